@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+# TrueType fonts to UnicodeFont headers for the meeting room display.
+#
+# Renders the glyphs of a subset of code points at the given point sizes and
+# writes one header per size, in the format described in
+# include/components/unicode_font.h, plus fonts.h including all of them.
+#
+# Only the printable ASCII and Latin-1 characters and the characters listed
+# in the code point file are emitted, so the fonts stay small.
+
+import argparse
+import os.path
+import sys
+from PIL import Image, ImageDraw, ImageFont
+
+# same resolution as Adafruit's fontconvert, so the sizes match the
+# FreeSans*pt7b fonts of Adafruit_GFX
+DPI = 141
+THRESHOLD = 127
+BYTES_PER_LINE = 12
+
+
+def default_codepoints():
+    return set(range(0x20, 0x7F)) | set(range(0xA0, 0x100))
+
+
+def read_codepoints(path):
+    """Every character in the file, and U+XXXX notations, one per line or not"""
+    codepoints = set()
+    with open(path, encoding="utf-8") as f:
+        for line in f:
+            line = line.split("#", 1)[0].strip()
+            for token in line.split():
+                if token.upper().startswith("U+"):
+                    codepoints.add(int(token[2:], 16))
+                else:
+                    codepoints.update(ord(c) for c in token)
+    return codepoints
+
+
+def render_glyph(font, ascent, codepoint):
+    """Returns (bits, width, height, xAdvance, xOffset, yOffset) of a glyph"""
+    char = chr(codepoint)
+    advance = round(font.getlength(char))
+    left, top, right, bottom = font.getbbox(char)
+    width, height = right - left, bottom - top
+    if width <= 0 or height <= 0:
+        return [], 0, 0, advance, 0, 0
+
+    image = Image.new("L", (width, height), 0)
+    ImageDraw.Draw(image).text((-left, -top), char, font=font, fill=255)
+    pixels = image.tobytes()
+
+    # trim empty rows and columns left by anti-aliasing
+    rows = [y for y in range(height) if any(pixels[y * width + x] > THRESHOLD for x in range(width))]
+    cols = [x for x in range(width) if any(pixels[y * width + x] > THRESHOLD for y in range(height))]
+    if not rows:
+        return [], 0, 0, advance, 0, 0
+
+    x0, x1, y0, y1 = cols[0], cols[-1] + 1, rows[0], rows[-1] + 1
+    bits = [1 if pixels[y * width + x] > THRESHOLD else 0 for y in range(y0, y1) for x in range(x0, x1)]
+
+    # offsets are relative to the cursor on the baseline
+    return bits, x1 - x0, y1 - y0, advance, left + x0, top + y0 - ascent
+
+
+def pack(bits):
+    """Packs the bits MSB first, rows are not padded (like GFXfont)"""
+    data = bytearray((len(bits) + 7) // 8)
+    for i, bit in enumerate(bits):
+        if bit:
+            data[i >> 3] |= 0x80 >> (i & 7)
+    return data
+
+
+def char_comment(codepoint):
+    char = chr(codepoint)
+    return char if char.isprintable() and char not in "\\" else ""
+
+
+def write_font(out, name, ttf, points, codepoints):
+    font = ImageFont.truetype(ttf, size=round(points * DPI / 72))
+    ascent, descent = font.getmetrics()
+
+    bitmap = bytearray()
+    glyphs = []
+    for codepoint in codepoints:
+        bits, width, height, advance, x_offset, y_offset = render_glyph(font, ascent, codepoint)
+        glyphs.append((len(bitmap), width, height, advance, x_offset, y_offset, codepoint))
+        bitmap += pack(bits)
+
+    if len(bitmap) > 0xFFFF:
+        sys.exit(f"Error: {name} needs {len(bitmap)} bytes of bitmaps, at most 65535 are supported")
+
+    with open(out, "w") as f:
+        f.write("#pragma once\n\n")
+        f.write(f"// {os.path.basename(ttf)} {points}pt, {len(codepoints)} code points.\n")
+        f.write("// Generated by fonts/ttf_to_header.py, do not edit.\n\n")
+        f.write("#include \"components/unicode_font.h\"\n\n")
+
+        f.write(f"const uint8_t {name}Bitmaps[] PROGMEM = {{")
+        for i in range(0, len(bitmap), BYTES_PER_LINE):
+            f.write("\n    " + ", ".join(f"0x{b:02X}" for b in bitmap[i:i + BYTES_PER_LINE]) + ",")
+        f.write("\n};\n\n")
+
+        f.write(f"const GFXglyph {name}Glyphs[] PROGMEM = {{\n")
+        for offset, width, height, advance, x_offset, y_offset, codepoint in glyphs:
+            f.write(f"    {{{offset}, {width}, {height}, {advance}, {x_offset}, {y_offset}}}, // U+{codepoint:04X} {char_comment(codepoint)}\n")
+        f.write("};\n\n")
+
+        f.write(f"const uint16_t {name}Codepoints[] PROGMEM = {{")
+        for i in range(0, len(codepoints), BYTES_PER_LINE):
+            f.write("\n    " + ", ".join(f"0x{c:04X}" for c in codepoints[i:i + BYTES_PER_LINE]) + ",")
+        f.write("\n};\n\n")
+
+        f.write(f"const UnicodeFont {name} PROGMEM = {{{name}Bitmaps, {name}Glyphs, {name}Codepoints, {len(codepoints)}, {ascent + descent}}};\n")
+
+    # bitmaps + 7 bytes per glyph + 2 bytes per code point
+    return len(bitmap) + len(glyphs) * 9
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Converts a TrueType font to UnicodeFont headers")
+    parser.add_argument("-i", "--input", required=True, help="TrueType font file")
+    parser.add_argument("-o", "--output", default="fonts", help="output directory")
+    parser.add_argument("-n", "--name", help="name of the fonts, defaults to the file name")
+    parser.add_argument("-c", "--codepoints", help="file with additional characters to include")
+    parser.add_argument("-s", "--sizes", type=int, nargs="+", default=[9, 12, 18, 24], help="sizes in pt")
+    args = parser.parse_args()
+
+    codepoints = default_codepoints()
+    if args.codepoints:
+        codepoints |= read_codepoints(args.codepoints)
+    codepoints = sorted(c for c in codepoints if c <= 0xFFFF)
+
+    name = args.name or os.path.splitext(os.path.basename(args.input))[0]
+    os.makedirs(args.output, exist_ok=True)
+
+    headers = []
+    for points in args.sizes:
+        font_name = f"{name}{points}ptSubset"
+        header = f"{font_name}.h"
+        size = write_font(os.path.join(args.output, header), font_name, args.input, points, codepoints)
+        headers.append(header)
+        print(f"{header}: {len(codepoints)} code points, {size} bytes")
+
+    with open(os.path.join(args.output, "fonts.h"), "w") as f:
+        f.write("#pragma once\n\n")
+        for header in headers:
+            f.write(f"#include \"fonts/{header}\"\n")
+
+
+if __name__ == "__main__":
+    main()
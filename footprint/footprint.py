@@ -0,0 +1,319 @@
+#!/usr/bin/env python3
+# Flash and RAM footprint report for esp32-weather-epd.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+# Breaks the flash and RAM use of the firmware and the asset pack down by
+# library, component, font and icon, and compares it with a baseline. See
+# README in this folder.
+
+import argparse
+import glob
+import json
+import os.path
+import re
+import subprocess
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'icons'))
+import pack_assets  # noqa: E402
+
+# output sections of the ESP32 linker scripts
+FLASH_SECTIONS = ('.flash.text', '.flash.rodata', '.flash.appdesc', '.iram0.text', '.iram0.vectors', '.dram0.data',
+                  '.rtc.text', '.rtc.data')
+RAM_SECTIONS = ('.dram0.data', '.dram0.bss', '.noinit', '.iram0.text', '.iram0.vectors')
+RTC_SECTIONS = ('.rtc.data', '.rtc.bss', '.rtc_noinit', '.rtc.force_slow')
+
+# demangled symbol prefixes of the components and header-only libraries
+COMPONENTS = [
+    ('Calendar', r'Calendar::'),
+    ('StatusBar', r'StatusBar::'),
+    ('Status', r'Status::'),
+    ('DisplayBuffer', r'DisplayBuffer::'),
+    ('PageBuffer', r'(PageBuffer|StripBuffer|GlyphCache)::'),
+    ('Icons', r'(AssetPack|IconCache|VectorIcon)::'),
+    ('RowCache', r'RowCache::'),
+    ('CalendarClient', r'calendar_client::'),
+    ('GxEPD2', r'GxEPD2'),
+    ('ArduinoJson', r'ArduinoJson'),
+    ('Adafruit_GFX', r'Adafruit_GFX'),
+]
+
+FONT = re.compile(r'^(FreeSans\w*?\d+pt\w*?7b|\w+?\d+ptSubset)(Bitmaps|Glyphs|Codepoints)?$')
+ICON = re.compile(r'^(\w+)_(\d+)x\2$')
+
+
+def add(table, name, flash=0, ram=0):
+    entry = table.setdefault(name, {'flash': 0, 'ram': 0})
+    entry['flash'] += flash
+    entry['ram'] += ram
+
+
+def parse_map(path):
+    """Returns (totals, libraries) from a GNU ld map file."""
+    totals = {}
+    libraries = {}
+    section = None
+    pending = None
+
+    with open(path, errors='replace') as f:
+        lines = f.read().split('\n')
+
+    start = next((i for i, l in enumerate(lines) if l.startswith('Linker script and memory map')), 0)
+    for line in lines[start:]:
+        # output section
+        m = re.match(r'^(\.[\w.]+)\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)', line)
+        if m:
+            section = m.group(1)
+            size = int(m.group(3), 16)
+            if size:
+                add(totals, section, size if section in FLASH_SECTIONS else 0,
+                    size if section in RAM_SECTIONS or section in RTC_SECTIONS else 0)
+            pending = None
+            continue
+        if re.match(r'^\.[\w.]+\s*$', line):
+            section = line.strip()
+            continue
+
+        # input section, its name may be on a line of its own
+        m = re.match(r'^ (\.[^\s]+|COMMON)\s*$', line)
+        if m:
+            pending = m.group(1)
+            continue
+        m = re.match(r'^ (?:(\.[^\s]+|COMMON)\s+)?0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(.+)$', line)
+        if not m or section is None or (m.group(1) is None and pending is None):
+            pending = None
+            continue
+        pending = None
+
+        size = int(m.group(3), 16)
+        if size == 0:
+            continue
+        flash = size if section in FLASH_SECTIONS else 0
+        ram = size if section in RAM_SECTIONS or section in RTC_SECTIONS else 0
+        if flash or ram:
+            add(libraries, library_of(m.group(4).strip()), flash, ram)
+
+    return totals, libraries
+
+
+def library_of(obj):
+    """Name of the library an object file of the map belongs to."""
+    obj = obj.replace('\\', '/')
+    if '/toolchain-' in obj:
+        return 'toolchain'
+    m = re.search(r'lib([^/()]+)\.a\(', obj)
+    if m:
+        name = m.group(1)
+        if '/framework-arduinoespressif32/' in obj and '/tools/sdk/' in obj:
+            return 'esp-idf'
+        return 'framework' if name == 'FrameworkArduino' else name
+    if '/src/' in obj and '.pio/build' in obj:
+        return 'firmware'
+    if '/lib/' in obj and '.pio/build' in obj:
+        return obj.split('/lib/')[1].split('/')[0]
+    return 'other'
+
+
+def parse_elf(path, nm):
+    """Returns a list of (demangled name, type, size) of the ELF symbols."""
+    out = subprocess.run([nm, '--print-size', '--size-sort', '--demangle', path],
+                         check=True, capture_output=True, text=True).stdout
+    symbols = []
+    for line in out.splitlines():
+        parts = line.split(None, 3)
+        if len(parts) == 4:
+            symbols.append((parts[3], parts[2], int(parts[1], 16)))
+    return symbols
+
+
+def symbol_size(kind, size):
+    """(flash, ram) taken by a symbol of the nm type kind."""
+    kind = kind.lower()
+    if kind in 'tr':
+        return size, 0
+    if kind in 'dg':
+        return size, size
+    if kind in 'bsv':
+        return 0, size
+    return 0, 0
+
+
+def classify_symbols(symbols, report):
+    components = report['components']
+    fonts = report['fonts']
+    icons = report['icons']
+    sizes = report['icon_sizes']
+
+    for name, kind, size in symbols:
+        flash, ram = symbol_size(kind, size)
+        if not flash and not ram:
+            continue
+
+        m = FONT.match(name)
+        if m:
+            add(fonts, m.group(1), flash, ram)
+            continue
+
+        # icons compiled into the firmware as bitmaps
+        m = ICON.match(name)
+        if m:
+            add(icons, m.group(1), flash, ram)
+            add(sizes, '{0}x{0} (firmware)'.format(m.group(2)), flash, ram)
+            continue
+
+        for component, pattern in COMPONENTS:
+            if re.search(pattern, name):
+                add(components, component, flash, ram)
+                break
+
+
+def icon_names(svg_dir, header_dir):
+    names = set()
+    for path in glob.glob(os.path.join(svg_dir, '*.svg')) if svg_dir else []:
+        names.add(re.sub(r'[^0-9A-Za-z]+', '_', os.path.splitext(os.path.basename(path))[0]))
+    for path in glob.glob(os.path.join(header_dir, '*x*', '*.h')) if header_dir else []:
+        m = ICON.match(os.path.splitext(os.path.basename(path))[0])
+        if m:
+            names.add(m.group(1))
+    return names
+
+
+def parse_pack(path, names, report):
+    """Attributes the entries of the asset pack to icons, keys are matched by
+    hashing all known icon names with all sizes found in the pack."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    magic, version, count, total = pack_assets.HEADER.unpack_from(data, 0)
+    if magic != pack_assets.MAGIC:
+        sys.exit('Error: {} is not an asset pack'.format(path))
+
+    entries = [pack_assets.ENTRY.unpack_from(data, pack_assets.HEADER.size + i * pack_assets.ENTRY.size)
+               for i in range(count)]
+    candidates = set(w for _, _, _, w, h in entries) | {pack_assets.MASTER, pack_assets.OUTLINE}
+    lookup = {pack_assets.key(n, s): (n, s) for n in names for s in candidates}
+
+    used = pack_assets.HEADER.size + count * pack_assets.ENTRY.size
+    add(report['totals'], 'asset pack index', flash=used)
+    for key, offset, length, width, height in entries:
+        name, size = lookup.get(key, ('unknown {:08x}'.format(key), width))
+        if size == pack_assets.OUTLINE:
+            label = 'outline'
+        elif size == pack_assets.MASTER:
+            label = '{0}x{0} master'.format(width)
+        else:
+            label = '{0}x{0}'.format(width)
+        add(report['icons'], name, flash=length)
+        add(report['icon_sizes'], label, flash=length)
+    add(report['totals'], 'asset pack', flash=total)
+
+
+def dead_icons(names, sources):
+    """Icons that no string literal in the sources names."""
+    literals = set()
+    for root in sources:
+        for path in glob.glob(os.path.join(root, '**', '*.*'), recursive=True):
+            if os.path.splitext(path)[1] in ('.c', '.cc', '.cpp', '.h', '.hpp'):
+                with open(path, errors='replace') as f:
+                    literals.update(re.findall(r'"([^"\\\n]*)"', f.read()))
+    return sorted(n for n in names if n not in literals)
+
+
+def print_table(title, table, baseline, threshold):
+    if not table and not baseline:
+        return
+    print('\n{}'.format(title))
+    print('  {:<40} {:>10} {:>10} {:>10} {:>10}'.format('', 'flash', 'Δ flash', 'ram', 'Δ ram'))
+    keys = sorted(set(table) | set(baseline), key=lambda k: -table.get(k, {'flash': 0})['flash'])
+    for k in keys:
+        now = table.get(k, {'flash': 0, 'ram': 0})
+        was = baseline.get(k)
+        df = now['flash'] - was['flash'] if was else None
+        dr = now['ram'] - was['ram'] if was else None
+
+        def delta(d):
+            return '' if d is None else '{:+d}'.format(d) if d else '0'
+
+        flag = ' <<<' if (df or 0) >= threshold or (dr or 0) >= threshold else ''
+        print('  {:<40} {:>10} {:>10} {:>10} {:>10}{}'.format(k[:40], now['flash'], delta(df), now['ram'], delta(dr),
+                                                            flag))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Flash and RAM footprint by asset, component and library.')
+    parser.add_argument('--elf', help='firmware.elf')
+    parser.add_argument('--map', help='linker map file of the firmware')
+    parser.add_argument('--nm', default='xtensa-esp32-elf-nm', help='nm of the toolchain')
+    parser.add_argument('--pack', help='asset pack (see icons/pack_assets.py)')
+    parser.add_argument('--svg', help='SVG icons, to name the icons of the asset pack')
+    parser.add_argument('--headers', help='icon header folder, to name the icons of the asset pack')
+    parser.add_argument('--sources', nargs='*', default=[], help='source folders to search for icon names')
+    parser.add_argument('--baseline', help='baseline to compare with (json)')
+    parser.add_argument('--update-baseline', action='store_true', help='write the report to the baseline')
+    parser.add_argument('--threshold', type=int, default=4096, help='mark growth of at least this many bytes')
+    parser.add_argument('--fail-above', type=int, help='exit with an error if anything grew by more bytes')
+    args = parser.parse_args()
+
+    report = {c: {} for c in ('totals', 'libraries', 'components', 'fonts', 'icons', 'icon_sizes')}
+
+    if args.map:
+        report['totals'], report['libraries'] = parse_map(args.map)
+    if args.elf:
+        classify_symbols(parse_elf(args.elf, args.nm), report)
+
+    names = icon_names(args.svg, args.headers)
+    if args.pack:
+        parse_pack(args.pack, names, report)
+
+    baseline = {}
+    if args.baseline and os.path.exists(args.baseline) and not args.update_baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+
+    threshold = args.threshold
+    print_table('Totals (by section)', report['totals'], baseline.get('totals', {}), threshold)
+    print_table('Libraries (map file)', report['libraries'], baseline.get('libraries', {}), threshold)
+    print_table('Components and libraries (symbols)', report['components'], baseline.get('components', {}), threshold)
+    print_table('Fonts', report['fonts'], baseline.get('fonts', {}), threshold)
+    print_table('Icons by size', report['icon_sizes'], baseline.get('icon_sizes', {}), threshold)
+    print_table('Icons', report['icons'], baseline.get('icons', {}), threshold)
+
+    if args.sources and names:
+        dead = dead_icons(names, args.sources)
+        print('\nIcons not named in the sources (the server may still ask for them in /status):')
+        print('  ' + (', '.join(dead) if dead else 'none'))
+
+    if args.update_baseline and args.baseline:
+        # categories that were not measured this time are kept
+        if os.path.exists(args.baseline):
+            with open(args.baseline) as f:
+                old = json.load(f)
+            for category, table in old.items():
+                if not report.get(category):
+                    report[category] = table
+        with open(args.baseline, 'w') as f:
+            json.dump(report, f, indent=2, sort_keys=True)
+            f.write('\n')
+        print('\nBaseline written to {}'.format(args.baseline))
+    elif args.fail_above is not None and baseline:
+        grown = [(c, k) for c, table in report.items() for k, v in table.items()
+                 if k in baseline.get(c, {}) and (v['flash'] - baseline[c][k]['flash'] > args.fail_above or
+                                                  v['ram'] - baseline[c][k]['ram'] > args.fail_above)]
+        if grown:
+            sys.exit('Error: footprint grew by more than {} bytes: {}'.format(
+                args.fail_above, ', '.join('{}/{}'.format(c, k) for c, k in grown)))
+
+
+if __name__ == '__main__':
+    main()
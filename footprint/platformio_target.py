@@ -0,0 +1,42 @@
+# PlatformIO extra script that adds the targets "footprint" and
+# "footprint-baseline", see README in this folder.
+import os
+
+Import("env")  # noqa: F821
+
+project = env.subst("$PROJECT_DIR")  # noqa: F821
+build = env.subst("$BUILD_DIR")  # noqa: F821
+elf = os.path.join(build, env.subst("${PROGNAME}.elf"))  # noqa: F821
+map_file = os.path.join(build, env.subst("${PROGNAME}.map"))  # noqa: F821
+pack = os.path.join(build, "assets.bin")
+icons = os.path.join(project, "icons")
+# nm of the same toolchain, e.g. xtensa-esp32-elf-nm
+nm = env.subst("$CC").replace("gcc", "nm")  # noqa: F821
+
+env.Append(LINKFLAGS=["-Wl,-Map," + map_file])  # noqa: F821
+
+command = (
+    '"$PYTHONEXE" "{icons}/pack_assets.py" -v "{icons}/svg" -o "{pack}" && '
+    '"$PYTHONEXE" "{project}/footprint/footprint.py" --elf "{elf}" --map "{map}" --nm "{nm}" '
+    '--pack "{pack}" --svg "{icons}/svg" --sources "{project}/src" "{project}/include" '
+    '--baseline "{project}/footprint/baseline.json"'
+).format(icons=icons, pack=pack, project=project, elf=elf, map=map_file, nm=nm)
+
+# fail the report if anything grew by more bytes, e.g. in CI:
+#   pio run -t footprint -O custom_footprint_fail_above=4096
+fail_above = env.GetProjectOption("custom_footprint_fail_above", "")  # noqa: F821
+check = command + (" --fail-above {}".format(int(fail_above)) if fail_above else "")
+
+env.AddCustomTarget(  # noqa: F821
+    name="footprint",
+    dependencies=elf,
+    actions=[check],
+    title="Footprint",
+    description="Flash and RAM use by asset, component and library, compared with the baseline")
+
+env.AddCustomTarget(  # noqa: F821
+    name="footprint-baseline",
+    dependencies=elf,
+    actions=[command + " --update-baseline"],
+    title="Footprint baseline",
+    description="Write the current footprint to footprint/baseline.json")
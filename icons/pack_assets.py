@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+# Asset pack builder for esp32-weather-epd.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+# Packs the icon headers generated by svg_to_headers.sh into the binary asset
+# pack that is flashed into the assets partition, see include/asset_pack.h
+# for the layout.
+
+import argparse
+import glob
+import os.path
+import re
+import struct
+import sys
+
+import svg_outline
+
+MAGIC = b'ASPK'
+VERSION = 1
+MASTER = 0
+OUTLINE = 0xFFFF
+HEADER = struct.Struct('<4sHHI')
+ENTRY = struct.Struct('<IIIHH')
+ALIGN = 4
+
+
+def fnv1a(data, h=2166136261):
+    for b in data:
+        h = ((h ^ b) * 16777619) & 0xffffffff
+    return h
+
+
+def key(name, size):
+    return fnv1a('{}@{}'.format(name, size).encode())
+
+
+def read_icon(path):
+    """Returns (name, width, height, bitmap) of a header of png_to_header.py."""
+    with open(path) as f:
+        text = f.read()
+    size = re.search(r'//\s*(\d+)\s*x\s*(\d+)', text)
+    var = re.search(r'const unsigned char (\w+)\[\]', text)
+    if not size or not var:
+        sys.exit('Error: {} is not an icon header'.format(path))
+    width, height = int(size.group(1)), int(size.group(2))
+    name = re.sub(r'_{}x{}$'.format(width, height), '', var.group(1))
+    body = text[text.index('{', var.end()):]
+    bitmap = bytes(int(b, 16) for b in re.findall(r'0x([0-9a-fA-F]{2})', body))
+    if len(bitmap) != (width + 7) // 8 * height:
+        sys.exit('Error: {} has {} bytes, expected {}'.format(path, len(bitmap), (width + 7) // 8 * height))
+    return name, width, height, bitmap
+
+
+def build(assets):
+    """assets: list of (key, width, height, blob)"""
+    assets = sorted(assets, key=lambda a: a[0])
+    for a, b in zip(assets, assets[1:]):
+        if a[0] == b[0]:
+            sys.exit('Error: duplicate asset key {:08x}'.format(a[0]))
+
+    offset = HEADER.size + ENTRY.size * len(assets)
+    index = b''
+    blobs = b''
+    for k, width, height, blob in assets:
+        pad = -(offset + len(blobs)) % ALIGN
+        blobs += b'\0' * pad
+        index += ENTRY.pack(k, offset + len(blobs), len(blob), width, height)
+        blobs += blob
+
+    total = offset + len(blobs)
+    return HEADER.pack(MAGIC, VERSION, len(assets), total) + index + blobs
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Build the asset pack from the generated icon headers.')
+    parser.add_argument('-i', '--input', default='',
+                        help='directory with the <size>x<size> icon header folders, e.g. ../lib/display-assets/icons')
+    parser.add_argument('-o', '--output', required=True, help='asset pack to write, e.g. assets.bin')
+    parser.add_argument('-s', '--sizes', type=int, nargs='*', help='only pack these icon sizes')
+    parser.add_argument('-m', '--master', type=int,
+                        help='pack the icons of this size as masters, which are scaled to any other size on the device')
+    parser.add_argument('-v', '--vectors',
+                        help='directory with the SVG icons to pack as outlines, which are drawn in any size on the device')
+    args = parser.parse_args()
+
+    assets = []
+    paths = glob.glob(os.path.join(args.input, '*x*', '*.h')) if args.input else []
+    for path in sorted(paths):
+        name, width, height, bitmap = read_icon(path)
+        if width == args.master:
+            assets.append((key(name, MASTER), width, height, bitmap))
+        if (args.sizes or args.master) and width not in (args.sizes or []):
+            continue
+        assets.append((key(name, width), width, height, bitmap))
+
+    if args.vectors:
+        for path in sorted(glob.glob(os.path.join(args.vectors, '*.svg'))):
+            name = re.sub(r'[^0-9A-Za-z]+', '_', os.path.splitext(os.path.basename(path))[0])
+            units = svg_outline.UNITS
+            assets.append((key(name, OUTLINE), units, units, svg_outline.convert(path)))
+
+    if not assets:
+        sys.exit('Error: no icons found')
+
+    pack = build(assets)
+    with open(args.output, 'wb') as f:
+        f.write(pack)
+    print('{}: {} assets, {} bytes'.format(args.output, len(assets), len(pack)))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,277 @@
+#!/usr/bin/env python3
+# SVG to vector icon converter for esp32-weather-epd.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+# Converts the filled shapes of an SVG icon into the outline format drawn by
+# the firmware (see include/components/vector_icon.h): move, line, cubic and
+# close commands with coordinates quantized to a grid of UNITS x UNITS across
+# the icon. Arcs and quadratic curves are turned into cubic curves, transforms
+# are applied. Strokes are not supported, the icons only use fills.
+
+import math
+import re
+import sys
+import xml.etree.ElementTree as ET
+
+UNITS = 4096
+
+MOVE, LINE, CUBIC, CLOSE = range(4)
+
+NUMBER = r'[-+]?(?:\d+\.?\d*|\.\d+)(?:[eE][-+]?\d+)?'
+
+
+def multiply(a, b):
+    """Product of the affine matrices a and b, (a, b, c, d, e, f) as in SVG."""
+    return (a[0] * b[0] + a[2] * b[1], a[1] * b[0] + a[3] * b[1],
+            a[0] * b[2] + a[2] * b[3], a[1] * b[2] + a[3] * b[3],
+            a[0] * b[4] + a[2] * b[5] + a[4], a[1] * b[4] + a[3] * b[5] + a[5])
+
+
+IDENTITY = (1, 0, 0, 1, 0, 0)
+
+
+def parse_transform(text):
+    m = IDENTITY
+    for name, args in re.findall(r'(\w+)\s*\(([^)]*)\)', text or ''):
+        v = [float(n) for n in re.findall(NUMBER, args)]
+        if name == 'matrix':
+            t = tuple(v)
+        elif name == 'translate':
+            t = (1, 0, 0, 1, v[0], v[1] if len(v) > 1 else 0)
+        elif name == 'scale':
+            t = (v[0], 0, 0, v[1] if len(v) > 1 else v[0], 0, 0)
+        elif name == 'rotate':
+            a = math.radians(v[0])
+            t = (math.cos(a), math.sin(a), -math.sin(a), math.cos(a), 0, 0)
+            if len(v) == 3:
+                t = multiply(multiply((1, 0, 0, 1, v[1], v[2]), t), (1, 0, 0, 1, -v[1], -v[2]))
+        else:
+            sys.exit('Error: transform {} is not supported'.format(name))
+        m = multiply(m, t)
+    return m
+
+
+def arc_to_cubics(x0, y0, rx, ry, phi, large, sweep, x, y):
+    """Endpoint arc to cubic curves, see the SVG implementation notes (F.6)."""
+    if rx == 0 or ry == 0:
+        return [(x, y, x, y, x, y)]
+    rx, ry = abs(rx), abs(ry)
+    cphi, sphi = math.cos(math.radians(phi)), math.sin(math.radians(phi))
+    dx, dy = (x0 - x) / 2, (y0 - y) / 2
+    x1 = cphi * dx + sphi * dy
+    y1 = -sphi * dx + cphi * dy
+    scale = x1 * x1 / (rx * rx) + y1 * y1 / (ry * ry)
+    if scale > 1:
+        rx, ry = rx * math.sqrt(scale), ry * math.sqrt(scale)
+    num = rx * rx * ry * ry - rx * rx * y1 * y1 - ry * ry * x1 * x1
+    den = rx * rx * y1 * y1 + ry * ry * x1 * x1
+    coef = math.sqrt(max(0, num / den)) if den else 0
+    if large == sweep:
+        coef = -coef
+    cx1, cy1 = coef * rx * y1 / ry, -coef * ry * x1 / rx
+    cx = cphi * cx1 - sphi * cy1 + (x0 + x) / 2
+    cy = sphi * cx1 + cphi * cy1 + (y0 + y) / 2
+
+    def angle(ux, uy, vx, vy):
+        return math.atan2(ux * vy - uy * vx, ux * vx + uy * vy)
+
+    t1 = angle(1, 0, (x1 - cx1) / rx, (y1 - cy1) / ry)
+    dt = angle((x1 - cx1) / rx, (y1 - cy1) / ry, (-x1 - cx1) / rx, (-y1 - cy1) / ry)
+    if not sweep and dt > 0:
+        dt -= 2 * math.pi
+    elif sweep and dt < 0:
+        dt += 2 * math.pi
+
+    def point(t):
+        px, py = rx * math.cos(t), ry * math.sin(t)
+        return cphi * px - sphi * py + cx, sphi * px + cphi * py + cy
+
+    def tangent(t):
+        px, py = -rx * math.sin(t), ry * math.cos(t)
+        return cphi * px - sphi * py, sphi * px + cphi * py
+
+    n = max(1, int(math.ceil(abs(dt) / (math.pi / 2) - 1e-9)))
+    step = dt / n
+    k = 4 / 3 * math.tan(step / 4)
+    curves = []
+    for i in range(n):
+        a, b = t1 + i * step, t1 + (i + 1) * step
+        (ax, ay), (bx, by) = point(a), point(b)
+        (tax, tay), (tbx, tby) = tangent(a), tangent(b)
+        curves.append((ax + k * tax, ay + k * tay, bx - k * tbx, by - k * tby, bx, by))
+    curves[-1] = curves[-1][:4] + (x, y)
+    return curves
+
+
+def parse_path(d):
+    """Path data to a list of (command, points) in user space."""
+    tokens = re.findall(r'[MmLlHhVvCcSsQqTtAaZz]|' + NUMBER, d)
+    out = []
+    i = 0
+    cmd = None
+    x = y = sx = sy = 0
+    last_ctrl = None  # for S and T
+    last_cmd = ''
+
+    def num():
+        nonlocal i
+        v = float(tokens[i])
+        i += 1
+        return v
+
+    def flag():
+        # flags may be written without separators, e.g. "a1 1 0 011 1"
+        nonlocal i
+        t = tokens[i]
+        if len(t) > 1 and t[0] in '01':
+            tokens[i] = t[1:]
+            return int(t[0])
+        i += 1
+        return int(float(t))
+
+    while i < len(tokens):
+        if re.match(r'[A-Za-z]', tokens[i]):
+            cmd = tokens[i]
+            i += 1
+            if cmd in 'Zz':
+                out.append((CLOSE, []))
+                x, y = sx, sy
+                last_cmd, last_ctrl = 'Z', None
+                continue
+        rel = cmd.islower()
+        ox, oy = (x, y) if rel else (0, 0)
+        c = cmd.upper()
+        if c == 'M':
+            x, y = ox + num(), oy + num()
+            sx, sy = x, y
+            out.append((MOVE, [(x, y)]))
+            cmd = 'l' if rel else 'L'
+            last_ctrl = None
+        elif c in 'LHV':
+            if c == 'L':
+                x, y = ox + num(), oy + num()
+            elif c == 'H':
+                x = ox + num()
+            else:
+                y = oy + num()
+            out.append((LINE, [(x, y)]))
+            last_ctrl = None
+        elif c in 'CS':
+            if c == 'C':
+                x1, y1 = ox + num(), oy + num()
+            elif last_cmd in 'CS' and last_ctrl:
+                x1, y1 = 2 * x - last_ctrl[0], 2 * y - last_ctrl[1]
+            else:
+                x1, y1 = x, y
+            x2, y2 = ox + num(), oy + num()
+            nx, ny = ox + num(), oy + num()
+            out.append((CUBIC, [(x1, y1), (x2, y2), (nx, ny)]))
+            last_ctrl = (x2, y2)
+            x, y = nx, ny
+        elif c in 'QT':
+            if c == 'Q':
+                qx, qy = ox + num(), oy + num()
+            elif last_cmd in 'QT' and last_ctrl:
+                qx, qy = 2 * x - last_ctrl[0], 2 * y - last_ctrl[1]
+            else:
+                qx, qy = x, y
+            nx, ny = ox + num(), oy + num()
+            out.append((CUBIC, [(x + 2 / 3 * (qx - x), y + 2 / 3 * (qy - y)),
+                                (nx + 2 / 3 * (qx - nx), ny + 2 / 3 * (qy - ny)), (nx, ny)]))
+            last_ctrl = (qx, qy)
+            x, y = nx, ny
+        elif c == 'A':
+            rx, ry, phi = num(), num(), num()
+            large, sweep = flag(), flag()
+            nx, ny = ox + num(), oy + num()
+            for curve in arc_to_cubics(x, y, rx, ry, phi, large, sweep, nx, ny):
+                out.append((CUBIC, [curve[0:2], curve[2:4], curve[4:6]]))
+            x, y = nx, ny
+            last_ctrl = None
+        else:
+            sys.exit('Error: unexpected path data {}'.format(tokens[i]))
+        last_cmd = c
+    return out
+
+
+def shapes(element, matrix, fill):
+    """Yields the path commands of all filled shapes below element."""
+    for child in element:
+        tag = child.tag.split('}')[-1]
+        m = multiply(matrix, parse_transform(child.get('transform')))
+        style = dict(p.split(':', 1) for p in (child.get('style') or '').split(';') if ':' in p)
+        f = style.get('fill', child.get('fill', fill)).strip()
+        if tag == 'g':
+            yield from shapes(child, m, f)
+        elif f == 'none':
+            continue
+        elif tag == 'path':
+            yield m, parse_path(child.get('d', ''))
+        elif tag == 'rect':
+            x, y = float(child.get('x', 0)), float(child.get('y', 0))
+            w, h = float(child.get('width')), float(child.get('height'))
+            yield m, [(MOVE, [(x, y)]), (LINE, [(x + w, y)]), (LINE, [(x + w, y + h)]),
+                      (LINE, [(x, y + h)]), (CLOSE, [])]
+        elif tag in ('circle', 'ellipse', 'polygon', 'polyline', 'line'):
+            sys.exit('Error: <{}> is not supported, convert it to a path'.format(tag))
+
+
+def zigzag(v):
+    return v << 1 if v >= 0 else ((-v) << 1) - 1
+
+
+def varint(v, out):
+    while v >= 0x80:
+        out.append(0x80 | (v & 0x7f))
+        v >>= 7
+    out.append(v)
+
+
+def convert(path):
+    """Returns the outline of the SVG icon at path, encoded for the firmware."""
+    root = ET.parse(path).getroot()
+    box = root.get('viewBox')
+    if box:
+        bx, by, bw, bh = [float(v) for v in re.findall(NUMBER, box)]
+    else:
+        bx, by = 0, 0
+        bw, bh = [float(re.findall(NUMBER, root.get(a))[0]) for a in ('width', 'height')]
+
+    # fit the view box into the unit square, centered
+    s = UNITS / max(bw, bh)
+    view = (s, 0, 0, s, (UNITS - bw * s) / 2 - bx * s, (UNITS - bh * s) / 2 - by * s)
+
+    out = bytearray()
+    px = py = 0
+
+    def emit(points):
+        nonlocal px, py
+        for ux, uy in points:
+            qx = int(round(min(max(ux, -UNITS), 2 * UNITS)))
+            qy = int(round(min(max(uy, -UNITS), 2 * UNITS)))
+            varint(zigzag(qx - px), out)
+            varint(zigzag(qy - py), out)
+            px, py = qx, qy
+
+    for m, commands in shapes(root, view, root.get('fill', 'black')):
+        for op, points in commands:
+            out.append(op)
+            emit([(m[0] * x + m[2] * y + m[4], m[1] * x + m[3] * y + m[5]) for x, y in points])
+    return bytes(out)
+
+
+if __name__ == '__main__':
+    for arg in sys.argv[1:]:
+        print('{}: {} bytes'.format(arg, len(convert(arg))))
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Read-only pack of binary assets (the icons) that lives in its own data
+// partition instead of the firmware image, built by icons/pack_assets.py.
+//
+// The partition is memory mapped, so assets are used in place without being
+// copied to RAM. On the host, where there is no flash, the pack is read from
+// a memory mapped file "<name>.bin" instead.
+//
+// Layout, all values little endian:
+//   header   magic "ASPK", uint16 version, uint16 count, uint32 total size
+//   index    count entries, sorted by key
+//            uint32 key, uint32 offset, uint32 length, uint16 width, uint16 height
+//   blobs    each starting at a 4 byte boundary
+//
+// The key is fnv1a() of "<name>@<size>", e.g. "wifi_2_bar@48", the offset is
+// relative to the start of the pack. Icons that are only stored once, at
+// full size, to be scaled on the device use the size Master ("wifi_2_bar@0"),
+// the outlines of icons (see VectorIcon) the size Outline.
+class AssetPack
+{
+public:
+    static const uint32_t Magic = 0x4B505341; // "ASPK"
+    static const uint16_t Version = 1;
+    static const uint16_t Master = 0;
+    static const uint16_t Outline = 0xFFFF;
+
+    struct Asset
+    {
+        const uint8_t *data;
+        uint32_t length;
+        uint16_t width;
+        uint16_t height;
+    };
+
+    AssetPack() : base(NULL), size(0), handle(0), content(0) {}
+    ~AssetPack() { end(); }
+
+    // map the partition with the given label, false if it is missing or
+    // does not hold a valid pack
+    bool begin(const char *name = "assets");
+    void end();
+    bool isOpen() const { return base != NULL; }
+
+    bool find(const char *name, uint16_t size, Asset &asset) const;
+    bool find(uint32_t key, Asset &asset) const;
+
+    uint16_t count() const;
+
+    // hash of the whole pack, to tell renderings made with other assets
+    // apart. Computed on the first call, 0 if no pack is mapped.
+    uint32_t contentKey() const;
+
+    static uint32_t key(const char *name, uint16_t size);
+
+protected:
+    struct Header
+    {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t count;
+        uint32_t size;
+    };
+
+    struct Entry
+    {
+        uint32_t key;
+        uint32_t offset;
+        uint32_t length;
+        uint16_t width;
+        uint16_t height;
+    };
+
+    const uint8_t *base;
+    size_t size;
+    uint32_t handle; // mmap handle of the partition, unused on the host
+    mutable uint32_t content;
+
+    bool validate() const;
+    const Entry *entries() const { return (const Entry *)(base + sizeof(Header)); }
+};
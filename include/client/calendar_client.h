@@ -2,52 +2,20 @@
 
 #include <vector>
 #include <string>
+#include <functional>
 #include <WiFiClient.h>
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
 
+#include "client/calendar_entry.h"
+#include "client/calendar_index.h"
+#include "client/calendar_store.h"
+#include "client/occupancy.h"
+#include "client/recurrence.h"
+#include "client/room_summary.h"
+
 namespace calendar_client
 {
-    enum BusyState : int
-    {
-        Free = 0,
-        Tentative = 1,
-        Busy = 2
-    };
-
-    class CalendarEntry
-    {
-    protected:
-        String title;
-        time_t start;
-        time_t end;
-        bool all_day;
-        BusyState busy;
-        bool important;
-        String message;
-
-    public:
-        CalendarEntry() : title(""),
-                          start(0),
-                          end(LONG_MAX),
-                          all_day(false),
-                          busy(BusyState::Free),
-                          important(false),
-                          message("") {};
-
-        CalendarEntry(const JsonObject &json);
-
-        String getTitle() const { return title; }
-        time_t getStart() const { return start; }
-        time_t getEnd() const { return end; }
-        bool isAllDay() const { return all_day; }
-        BusyState getBusy() const { return busy; }
-        bool isImportant() const { return important; }
-        String getMessage() const { return message; }
-    };
-
-    typedef std::vector<CalendarEntry> CalendarEntries;
-
     class CustomStatus
     {
     private:
@@ -73,29 +41,82 @@ namespace calendar_client
         String apiEndpoint;
         int apiPort;
 
-        time_t last_updated;
-        CalendarEntries entries;
+        CalendarStore store;
         CustomStatus *customStatus;
 
+        // multi-room mode, a store and a summary per room
+        std::vector<CalendarStore *> roomStores;
+        std::vector<RoomSummary> roomSummaries;
+
     public:
         CalendarClient(String apiEndpoint, int apiPort) : apiEndpoint(apiEndpoint), apiPort(apiPort) {}
+        // Fetches the next CALENDAR_WINDOW_DAYS days of the calendar and of
+        // the API_ENDPOINT_EXTRA_CALENDARS, merged into one.
         int fetchCalendar();
         int fetchCustomStatus();
 
+        // Keeps the calendar of the last fetch in flash, or publishes the one
+        // kept there, so that the wakes between syncs render without WiFi.
+        // In multi-room mode, the calendars and names of all rooms.
+        bool saveCalendar() const;
+        bool loadCalendar();
+
+        // The last sync, kept across deep sleep, NULL if there was none since
+        // the last cold boot. A sync is due every CALENDAR_SYNC_INTERVAL.
+        static const SyncState *getLastSync();
+        static void setSynced(time_t now, int rssi);
+        static bool isSyncDue(time_t now);
+
+        // report device health back to the server. This is fire-and-forget,
+        // it is meant to run while the panel is refreshing.
+        int uploadTelemetry(uint32_t batteryVoltage, int rssi, unsigned long awakeMillis);
+
         // get the current calendar event. If multiple events are going at the same time,
         // nowClosestToStart=true will return the event where the starting-time is closest to now
         // wile nowClosestToStart=false will return the event where the end-time is closest to now
         const CalendarEntry *getCurrentEvent(time_t now, bool nowClosestToStart = true) const;
         const CalendarEntry *getNextEvent(time_t now) const;
-
-        time_t getLastUpdated() const { return last_updated; }
-        const CalendarEntries *getCalendarEntries() const { return &entries; }
+        static const CalendarEntry *findCurrentEvent(const CalendarIndex &index, time_t now, bool nowClosestToStart = true);
+
+        // Multi-room mode (MULTI_ROOM): fetches the calendars of all rooms in
+        // a single request, each into a store of its own, and sums them up.
+        int fetchRooms();
+        // the number of rooms, 1 if not in multi-room mode
+        static size_t getRoomCount();
+        // NULL until the rooms were fetched
+        const RoomSummary *getRoomSummary(size_t room) const { return room < roomSummaries.size() ? &roomSummaries[room] : NULL; }
+
+        // Thin-client mode (THIN_CLIENT): requests the frame the server renders
+        // for the room, unless the panel shows it already, which is answered
+        // with HTTP_CODE_NOT_MODIFIED. On HTTP_CODE_OK, render gets the body
+        // (see DisplayBuffer::streamFrame()) and returns false if it was cut
+        // short, in which case the request is repeated. If it is cut short
+        // every time, HTTPC_ERROR_CONNECTION_LOST is returned.
+        int fetchFrame(int16_t width, int16_t height, std::function<bool(Stream &)> render);
+        // The frame shown, NULL if it is not known, e.g. after a cold boot.
+        // Anything else drawn to the panel has to forget it.
+        static const FrameState *getFrame();
+        static void forgetFrame();
+
+        // The calendar of the last successful fetch. A new fetch replaces it
+        // as a whole, so get it once and use it for a whole render.
+        const CalendarSnapshot &getSnapshot() const { return store.snapshot(); }
+        time_t getLastUpdated() const { return roomStores.empty() ? getSnapshot().lastUpdated : roomStores[0]->snapshot().lastUpdated; }
+        const CalendarEntries *getCalendarEntries() const { return &getSnapshot().entries; }
+        const CalendarIndex &getIndex() const { return getSnapshot().index; }
+
+        // free/busy minutes of the day of t, as of the last successful fetch,
+        // kept across deep sleep. NULL if that day is not known.
+        static const DayOccupancy *getOccupancy(time_t t);
         const CustomStatus *getCustomStatus() const { return customStatus; }
 
         static const char *getHttpResponsePhrase(int code);
 
     protected:
-        bool parseCalendar(HTTPClient &client);
+        bool parseCalendars(HTTPClient *http, size_t count);
+        bool parseRooms(HTTPClient &client, time_t now);
+        void createRooms();
+        void updateOccupancy(const CalendarEntries &entries, time_t now);
         bool parseCustomStatus(HTTPClient &client);
     };
 };
\ No newline at end of file
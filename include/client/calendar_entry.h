@@ -0,0 +1,74 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <vector>
+#include <time.h>
+#include <limits.h>
+
+#include "client/recurrence.h"
+
+namespace calendar_client
+{
+    enum BusyState : int
+    {
+        Free = 0,
+        Tentative = 1,
+        Busy = 2
+    };
+
+    // An event, or a series of recurring events: then start and end are the
+    // ones of the first instance, and the store expands the instances that
+    // fall into the fetched days, see CalendarSnapshot.
+    class CalendarEntry
+    {
+    protected:
+        String id;
+        String title;
+        time_t start;
+        time_t end;
+        bool all_day;
+        BusyState busy;
+        bool important;
+        String message;
+        Recurrence recurrence;
+        bool instance;
+
+    public:
+        CalendarEntry() : id(""),
+                          title(""),
+                          start(0),
+                          end(LONG_MAX),
+                          all_day(false),
+                          busy(BusyState::Free),
+                          important(false),
+                          message(""),
+                          instance(false) {};
+
+        CalendarEntry(const JsonObject &json);
+
+        // identifies the event, empty if the server did not send one
+        String getId() const { return id; }
+        String getTitle() const { return title; }
+        time_t getStart() const { return start; }
+        time_t getEnd() const { return end; }
+        bool isAllDay() const { return all_day; }
+        BusyState getBusy() const { return busy; }
+        // Busy and Tentative entries take up the room, Free ones do not
+        bool takesUpRoom() const { return busy != BusyState::Free; }
+        bool isImportant() const { return important; }
+        String getMessage() const { return message; }
+        const Recurrence &getRecurrence() const { return recurrence; }
+        // expanded from a series
+        bool isInstance() const { return instance; }
+
+        // the instance of this series that starts at start
+        CalendarEntry instanceAt(time_t start) const;
+
+        // compact binary form, used to keep the calendar in flash
+        void write(std::vector<uint8_t> &out) const;
+        bool read(const uint8_t *&data, const uint8_t *limit);
+    };
+
+    typedef std::vector<CalendarEntry> CalendarEntries;
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+#include <time.h>
+#include <limits.h>
+
+namespace calendar_client
+{
+    class CalendarEntry;
+
+    // Index over the calendar entries, built once after they are parsed, that
+    // answers the questions of the components and the sleep scheduler without
+    // scanning all entries. All results point into the indexed entries, which
+    // must not change while the index is used.
+    //
+    // Events are taken as the half-open interval [start, end). For the free
+    // time queries, only the entries that take up the room count (see
+    // CalendarEntry::takesUpRoom()), like in DayOccupancy.
+    class CalendarIndex
+    {
+    protected:
+        // The entries sorted by start, which is also an implicit balanced
+        // search tree: the root of every range [lo, hi) is its middle element.
+        // maxEnd holds the latest end within the subtree of each element.
+        std::vector<const CalendarEntry *> byStart;
+        std::vector<time_t> starts;
+        std::vector<time_t> maxEnd;
+
+        // The time taken up by the events, merged into disjoint blocks, and a
+        // max tree over the length of the gap after every block.
+        struct Block
+        {
+            time_t start;
+            time_t end;
+        };
+        std::vector<Block> blocks;
+        std::vector<time_t> gapTree;
+        size_t gapLeaves;
+
+        time_t buildMaxEnd(size_t lo, size_t hi);
+        void collect(size_t lo, size_t hi, time_t t0, time_t t1, std::vector<const CalendarEntry *> &out) const;
+        time_t gap(size_t block) const;
+        size_t firstGap(size_t node, size_t lo, size_t hi, size_t from, time_t length) const;
+        // index of the last block starting at or before t, or -1
+        long blockAt(time_t t) const;
+
+    public:
+        CalendarIndex() : gapLeaves(0) {}
+
+        void build(const std::vector<CalendarEntry> &entries);
+        void clear();
+        size_t size() const { return byStart.size(); }
+
+        // Appends the events that overlap [t0, t1) to out, sorted by start.
+        // With t0 == t1, these are the events that are going on at t0 (and
+        // did not just start at t0). O(log n) plus the number of results.
+        void eventsIn(time_t t0, time_t t1, std::vector<const CalendarEntry *> &out) const;
+        void eventsAt(time_t t, std::vector<const CalendarEntry *> &out) const { eventsIn(t, t, out); }
+
+        // the first event that starts after t, or NULL
+        const CalendarEntry *nextStart(time_t t) const;
+
+        // The end of the free time that begins at t: t itself if an event is
+        // going on at t, LONG_MAX if no event follows.
+        time_t freeUntil(time_t t) const;
+
+        // The earliest time at or after t from which the room is free for at
+        // least minDuration seconds.
+        time_t nextFreeSlot(time_t t, time_t minDuration) const;
+    };
+};
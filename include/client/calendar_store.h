@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <stdint.h>
+#include <time.h>
+
+#include "client/calendar_index.h"
+
+class Journal;
+
+namespace calendar_client
+{
+    class CalendarEntry;
+    typedef std::vector<CalendarEntry> CalendarEntries;
+
+    // A complete calendar as received from the server: the entries sorted by
+    // start and the index over them. Never copied, the index points into the
+    // entries.
+    //
+    // Recurring series are kept aside in their compact form, the entries hold
+    // their instances within the fetched days (CALENDAR_WINDOW_DAYS from
+    // today) instead, so everything that reads the entries sees plain events.
+    struct CalendarSnapshot
+    {
+        time_t lastUpdated;
+        CalendarEntries entries;
+        CalendarEntries series;
+        CalendarIndex index;
+
+        CalendarSnapshot();
+        CalendarSnapshot(const CalendarSnapshot &) = delete;
+        CalendarSnapshot &operator=(const CalendarSnapshot &) = delete;
+    };
+
+    // when the calendar was last fetched, kept across deep sleep
+    struct SyncState
+    {
+        time_t time;
+        int32_t rssi; // of the connection it was fetched over
+    };
+
+    // the frame the panel shows in thin-client mode, kept across deep sleep
+    struct FrameState
+    {
+        uint32_t hash;     // as sent by the server
+        time_t validUntil;  // when the server expects it to change, 0 if unknown
+    };
+
+    // Two snapshots, one published for the readers and one the parser fills.
+    // A parse that fails half way never becomes visible, a successful one is
+    // published at once by swapping a pointer (release), which the readers
+    // load (acquire), so they see either the old or the new calendar, but
+    // never a list that is still being built.
+    //
+    // The snapshot a reader got stays valid until the next but one
+    // prepare(), readers must not hold on to it across fetches.
+    class CalendarStore
+    {
+    protected:
+        CalendarSnapshot slots[2];
+        std::atomic<const CalendarSnapshot *> current;
+        CalendarSnapshot *back;
+        const char *space; // of the keys in the journal
+
+        void expand(CalendarSnapshot &snapshot, time_t now) const;
+        void check(CalendarSnapshot &snapshot) const;
+
+    public:
+        // space separates the keys of stores kept in the same journal
+        explicit CalendarStore(const char *space = "calendar");
+
+        // the published snapshot, an empty one before the first publish()
+        const CalendarSnapshot &snapshot() const { return *current.load(std::memory_order_acquire); }
+
+        // an empty snapshot to be filled by the parser
+        CalendarSnapshot &prepare();
+
+        // Expands the series of the prepared entries for the days from now on,
+        // sorts the entries, drops duplicates and invalid ones, builds the
+        // index and makes it the published snapshot.
+        void publish(time_t now);
+
+        // Keeps the published snapshot in the journal, in place of the one
+        // kept before, or loads the one kept there and publishes it. Series
+        // are kept in their compact form. A save that is cut short leaves the
+        // previous snapshot in place.
+        bool save(Journal &journal) const;
+        bool load(Journal &journal, time_t now);
+    };
+};
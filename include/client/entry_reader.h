@@ -0,0 +1,59 @@
+#pragma once
+
+#include <Arduino.h>
+#include <time.h>
+
+#include "client/calendar_entry.h"
+#include "client/calendar_store.h"
+
+namespace calendar_client
+{
+    // Reads a calendar response one entry at a time, straight off the
+    // connection, so only a single entry is held as a JsonDocument at a time:
+    //
+    //   {"last_updated": 1700000000, "entries": [{...}, {...}, ...]}
+    //
+    // Members other than these two are skipped, last_updated may come before
+    // or after the entries.
+    class EntryReader
+    {
+    protected:
+        enum State
+        {
+            Start,
+            Members,
+            Entries,
+            Done
+        };
+
+        Stream *stream;
+        State state;
+        bool error;
+        time_t lastUpdated;
+
+        int peekToken(bool skipWhitespace = true);
+        bool expect(char c);
+        bool readString(String &s);
+        bool readNumber(time_t &value);
+        bool skipValue();
+        bool seekEntries();
+        bool fail();
+
+    public:
+        EntryReader() : stream(NULL), state(Done), error(false), lastUpdated(0) {}
+        explicit EntryReader(Stream &stream) : stream(&stream), state(Start), error(false), lastUpdated(0) {}
+
+        // the next entry, false after the last one or if the response is
+        // malformed or cut short, see failed()
+        bool next(CalendarEntry &entry);
+
+        bool failed() const { return error; }
+        // known once next() returned false
+        time_t getLastUpdated() const { return lastUpdated; }
+
+        // Reads the responses of several calendars into the entries of the
+        // snapshot, merged by start, and sets its lastUpdated to the latest
+        // of them. Returns false if any response is malformed or cut short.
+        static bool merge(Stream *const streams[], size_t count, CalendarSnapshot &snapshot);
+    };
+};
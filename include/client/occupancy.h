@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+#include <vector>
+
+namespace calendar_client
+{
+    class CalendarEntry;
+
+    // Free/busy state of a single day at minute resolution, one bit per minute
+    // in three planes: busy and tentative after the entries' BusyState (Free
+    // entries take up no minutes, see takesUpRoom()), and important after
+    // isImportant(). The queries work on whole words, so they
+    // take at most a few dozen steps whatever the number of entries.
+    //
+    // Plain data without constructor, so it can live in RTC memory and be
+    // used on wakes that do not fetch the calendar. A day that was never built
+    // has a midnight of 0.
+    //
+    // Minutes are counted from local midnight. On days with a DST change the
+    // day is cut after 24 hours.
+    struct DayOccupancy
+    {
+        static const uint16_t Minutes = 24 * 60;
+        static const uint16_t Words = Minutes / 32;
+
+        time_t midnight;
+        uint32_t busy[Words];
+        uint32_t tentative[Words];
+        uint32_t important[Words];
+
+        void build(const std::vector<CalendarEntry> &entries, time_t midnight);
+
+        bool contains(time_t t) const { return midnight != 0 && t >= midnight && t < midnight + Minutes * 60; }
+        uint16_t minuteOf(time_t t) const { return (t - midnight) / 60; }
+
+        // busy or tentative
+        bool isOccupied(uint16_t minute) const;
+
+        // the first occupied minute at or after minute, Minutes if none
+        uint16_t freeUntil(uint16_t minute) const;
+        // the first free minute at or after minute, Minutes if none
+        uint16_t occupiedUntil(uint16_t minute) const;
+        // The first run of set minutes of a plane (e.g. busy) starting at or
+        // after from: returns its start and sets end to the minute after it.
+        // Minutes if there is none.
+        static uint16_t findRun(const uint32_t *plane, uint16_t from, uint16_t &end);
+
+        // local midnight of the day that is days after the one of t
+        static time_t startOfDay(time_t t, int days = 0);
+
+    protected:
+        static void setRange(uint32_t *plane, uint16_t from, uint16_t to);
+        static uint16_t findBit(const uint32_t *plane, uint16_t from, bool set);
+        uint16_t find(uint16_t from, bool occupied) const;
+        uint32_t occupiedWord(uint16_t i) const { return busy[i] | tentative[i]; }
+    };
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+#include <limits.h>
+#include <vector>
+
+namespace calendar_client
+{
+    // How the instances of a recurring event repeat, the subset of the RRULE
+    // of RFC 5545 that recurring meetings use: FREQ (DAILY, WEEKLY, MONTHLY,
+    // YEARLY), INTERVAL, BYDAY (weekdays without ordinals, for DAILY and
+    // WEEKLY), UNTIL and COUNT, plus the EXDATEs of the series. Weeks start
+    // on Monday.
+    //
+    // The instances are laid out on the local calendar from the first one
+    // (DTSTART), so they keep their time of day across DST changes. As in
+    // RFC 5545, dates that do not exist (e.g. the 31st in a short month) are
+    // skipped, and excluded instances still count towards COUNT.
+    struct Recurrence
+    {
+        enum Frequency : uint8_t
+        {
+            None = 0,
+            Daily,
+            Weekly,
+            Monthly,
+            Yearly
+        };
+
+        Frequency frequency;
+        uint8_t byDay; // bit 0 is Monday, 0 for the weekday of the first instance
+        uint16_t interval;
+        uint32_t count; // 0 if not limited
+        time_t until;   // the last an instance may start, LONG_MAX if not limited
+        std::vector<time_t> exceptions; // starts of the excluded instances, sorted
+
+        Recurrence() : frequency(None), byDay(0), interval(1), count(0), until(LONG_MAX) {}
+
+        bool isRecurring() const { return frequency != None; }
+
+        // Reads an RRULE value such as "FREQ=WEEKLY;BYDAY=MO,TH;COUNT=10",
+        // false (and not recurring) if it uses parts that are not supported.
+        bool parse(const char *rule);
+        void addException(time_t start);
+        bool isException(time_t start) const;
+
+        // Walks the starts of the instances of a series in order, from the
+        // first one that starts at or after from, to the last one that starts
+        // before limit. Without COUNT, the walk starts at the period of from
+        // right away. With COUNT, the instances before from still have to be
+        // counted, which costs a few integer steps per instance.
+        class Iterator
+        {
+        protected:
+            const Recurrence &rule;
+            tm first;      // local time of the first instance
+            long firstDay; // days since 1970-01-01 of the first instance
+            long fromDay;
+            long limitDay;
+            long untilDay;
+            time_t from;
+            time_t limit;
+
+            long period;     // days, weeks, months or years after the first
+            uint8_t weekday; // next weekday to try within a weekly period
+            uint32_t counted;
+            bool done;
+
+            void skipTo(long day);
+            bool nextDay(long &day);
+            time_t startOn(long day) const;
+
+        public:
+            Iterator(const Recurrence &rule, time_t first, time_t from, time_t limit);
+
+            // the start of the next instance, false if there is none
+            bool next(time_t &start);
+        };
+
+        // days since 1970-01-01 of a date and back, in the proleptic
+        // Gregorian calendar
+        static long daysFromCivil(int year, int month, int day);
+        static void civilFromDays(long days, int &year, int &month, int &day);
+        // 0 for Monday
+        static int weekdayOf(long days) { return (int)(((days % 7) + 10) % 7); }
+    };
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+
+#include "client/calendar_index.h"
+
+namespace calendar_client
+{
+    // What the multi-room mode shows of a room: the meeting going on, the
+    // next one and when the room is free. Fixed in size, the texts are
+    // truncated (on a character boundary), so a summary takes up the same
+    // few bytes however many events the room has.
+    struct RoomSummary
+    {
+        static const size_t MaxRooms = 4;
+        static const size_t TextSize = 48; // bytes of every text, including the terminator
+
+        char name[TextSize];
+        char current[TextSize]; // title of the meeting going on, empty if none
+        char next[TextSize];    // title of the next meeting, empty if none
+        time_t currentEnd;
+        time_t nextStart;
+        time_t freeFrom;  // now if the room is free
+        time_t freeUntil; // LONG_MAX if it stays free
+        uint8_t busy;     // BusyState of the current meeting
+        bool important;
+
+        void update(const char *name, const CalendarIndex &index, time_t now);
+        bool isFree() const { return current[0] == '\0'; }
+    };
+};
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include "components.h"
+#include "components/row_cache.h"
 #include "utils.h"
 #include "client/calendar_client.h"
 
@@ -11,6 +12,9 @@ private:
     calendar_client::CalendarClient *calClient;
     const int entryHeight;
 
+    // rendered entries from previous wakes, used while rendering
+    mutable RowCache rowCache;
+
 public:
 #if defined(DISP_3C) || defined(DISP_7C)
     Calendar(DisplayBuffer *buffer, calendar_client::CalendarClient *calClient, Color accentColor);
@@ -21,9 +25,10 @@ public:
     virtual void render(time_t now) const override;
 
 protected:
-    bool checkTruncatedEvents(time_t now, int *displayable, int *skipped, int *more) const;
+    bool checkTruncatedEvents(const calendar_client::CalendarEntries &entries, time_t now, int *displayable, int *skipped, int *more) const;
     int renderSkippedEntries(int y, int skipped, int maxEntries, String eventsTxt, bool more) const;
     int renderCalendarEntry(int x, int y, const calendar_client::CalendarEntry &entry, time_t now) const;
+    uint32_t entryKey(const calendar_client::CalendarEntry &entry, bool isPast, bool isCurrent) const;
     void renderCalendarEntryIcon(int x, int y, const calendar_client::CalendarEntry &entry, bool isPast, bool isCurrent) const;
     void renderCalendarEntryTitle(int x, int y, const calendar_client::CalendarEntry &entry, bool isPast) const;
     void renderCalendarEntryTime(int x, int y, const calendar_client::CalendarEntry &entry, bool isPast) const;
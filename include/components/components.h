@@ -9,6 +9,10 @@ class IDisplayComponent
 public:
     virtual ~IDisplayComponent() = default;
     virtual void render(time_t now) const = 0;
+
+    // draws the parts of the component that never change. They are composed
+    // once into the static layer every page starts with, see Display.
+    virtual void renderStatic() const {}
 };
 
 class DisplayComponent : public IDisplayComponent
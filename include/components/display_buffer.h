@@ -1,52 +1,150 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <functional>
+#include <algorithm>
 
 #include "config.h"
 #include "components/display_config.h"
+#include "components/page_buffer.h"
+#include "components/strip_buffer.h"
+#include "rle.h"
 #include "utils.h"
 
+// most lines a wrapped text can have, see drawString()
+#define TEXT_LAYOUT_MAX_LINES 4
+// number of wrapped texts kept in RTC memory across wakes
+#define TEXT_LAYOUT_CACHE_SIZE 24
+
+// Where a text is broken into lines by drawString() and how big the lines
+// are, for a given font and constraints.
+struct TextLayout
+{
+	struct Line
+	{
+		uint16_t start;  // index of the first character in the text
+		uint16_t length; // without the ellipsis
+		bool ellipsis;   // "..." is appended to the line
+		TextSize size;
+	};
+
+	// identifies the text and the constraints
+	uint32_t textHash;
+	uint16_t textLength;
+	uint16_t maxWidth;
+	uint8_t maxLines;
+	uint8_t fontSize;
+
+	uint32_t lastUsed;
+	int16_t lineSpacing;
+	uint8_t lineCount;
+	Line lines[TEXT_LAYOUT_MAX_LINES];
+};
+
 class DisplayBuffer
 {
 private:
-	GxEPD2_DISPLAY_CLASS<GxEPD2_DRIVER_CLASS, MAX_HEIGHT(GxEPD2_DRIVER_CLASS)> *display;
+	GxEPD2_DRIVER_CLASS *epd2;
+	PageBuffer *page;
+	int16_t currentPage;
+	int16_t pages;
+#if defined(DISP_7C)
+	uint8_t *nativeRow;
+#endif
 	Color foregroundColor;
 	Color backgroundColor;
 	uint8_t fontSize;
+	int16_t pin_epd_busy;
+	int16_t busyLevel;
+
+	// handed to the driver only for the wait of a refresh, see refresh()
+	void (*busyCallback)(const void *);
+	const void *busyCallbackParameter;
+
+	// precomposed content every page starts with, see setStaticLayer()
+	// It is stored row after row, each row plane after plane.
+	const std::vector<uint8_t> *staticLayer;
+	rle::Decoder staticLayerDecoder;
 
 public:
 	DisplayBuffer(int8_t pin_epd_cs, int16_t pin_epd_dc, int16_t pin_epd_rst, int16_t pin_epd_busy);
 
-	void hibernate() { display->hibernate(); }
+	void hibernate() { epd2->hibernate(); }
+
+	// the busy callback is invoked by the epd driver in a loop for as long as
+	// the panel holds the BUSY line during the refresh started by the last
+	// nextPage() or streamFrame(). The waits of power on, init and power off
+	// do not call it.
+	void setBusyCallback(void (*busyCallback)(const void *), const void *parameter = 0)
+	{
+		this->busyCallback = busyCallback;
+		this->busyCallbackParameter = parameter;
+	}
+	bool isBusy() const;
+	void waitWhileBusy(uint32_t timeout = 30000) const;
+
 	// init method with additional parameters:
 	// initial false for re-init after processor deep sleep wake up, if display power supply was kept
 	// this can be used to avoid the repeated initial full refresh on displays with fast partial update
 	// NOTE: garbage will result on fast partial update displays, if initial full update is omitted after power loss
 	// reset_duration = 10 is default; a value of 2 may help with "clever" reset circuit of newer boards from Waveshare
 	// pulldown_rst_mode true for alternate RST handling to avoid feeding 5V through RST pin
-	void init(uint32_t serial_diag_bitrate = 115200, bool initial = true, uint16_t reset_duration = 10, bool pulldown_rst_mode = false) { display->init(serial_diag_bitrate, initial, reset_duration, pulldown_rst_mode); }
+	void init(uint32_t serial_diag_bitrate = 115200, bool initial = true, uint16_t reset_duration = 10, bool pulldown_rst_mode = false)
+	{
+		epd2->init(serial_diag_bitrate, initial, reset_duration, pulldown_rst_mode);
+		setFullWindow();
+	}
 
-	int16_t width() { return display->width(); }
-	int16_t height() { return display->height(); }
+	int16_t width() { return page->width(); }
+	int16_t height() { return page->height(); }
 
 	void invert() { setForegroundColor(setBackgroundColor(this->foregroundColor)); }
 
-	bool nextPage() { return display->nextPage(); }
+	// sends the current page to the panel and selects the next one.
+	// After the last page the panel is refreshed and false is returned.
+	bool nextPage();
 
-	void setTextSize(uint8_t s) { this->display->setTextSize(s); }
+	void setTextSize(uint8_t s) { this->page->setTextSize(s); }
 	void setFontSize(uint8_t fontSize);
 	uint8_t getFontSize() const { return this->fontSize; }
+	static uint32_t fontKey(uint8_t fontSize);
 	Color setForegroundColor(Color c);
 	Color setBackgroundColor(Color c);
 
 	Color getForegroundColor() const { return this->foregroundColor; }
 	Color getBackgroundColor() const { return this->backgroundColor; }
 
-	void setFullWindow() { display->setFullWindow(); }
-	void setPartialWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h) { display->setPartialWindow(x, y, w, h); }
+	void setFullWindow();
 
 	void clearDisplay();
 
+	// In paged mode only a band of the display is held in memory. Everything
+	// entirely outside of it is skipped before doing any work, instead of
+	// being clipped pixel by pixel.
+	bool isVisible(int16_t y, int16_t h) const { return page->intersectsBand(y, h); }
+	bool isVisible(const Rect &r) const { return isVisible(r.y, r.height); }
+
+	// Copy a region of the current page, e.g. to reuse it on a later wake,
+	// or restore it. See PageBuffer::readRect() for the limitations.
+	bool readRect(const Rect &r, std::vector<uint8_t> &out) { return page->readRect(r.x, r.y, r.width, r.height, out); }
+	bool writeRect(const Rect &r, const std::vector<uint8_t> &data) { return page->writeRect(r.x, r.y, r.width, r.height, data.data(), data.size()); }
+	bool writeRect(const Rect &r, const uint8_t *data, size_t len) { return page->writeRect(r.x, r.y, r.width, r.height, data, len); }
+
+	// Render draw() into a layer that can be used as the base of every page
+	// instead of a blank one. The layer holds all rows, run-length encoded.
+	void composeStaticLayer(std::function<void()> draw, std::vector<uint8_t> &layer);
+	// Start every page of the next frame with the given layer, or with the
+	// background color if layer is NULL. Restarts at the first page.
+	void setStaticLayer(const std::vector<uint8_t> *layer);
+
+	// Send a frame rendered elsewhere to the panel and refresh it. The frame
+	// is read from stream in the layout of the static layer, and decoded a
+	// few rows at a time straight to the panel, the page is not used. If the
+	// stream ends before the last row, false is returned and the panel is
+	// not refreshed.
+	bool streamFrame(Stream &stream);
+
 	Rect drawString(int16_t x, int16_t y, const String &text, uint8_t alignment = Alignment::Top | Alignment::Left);
 	Rect drawString(int16_t x, int16_t y, const String &text, uint8_t alignment, uint16_t max_width, uint16_t max_lines);
 
@@ -55,17 +153,54 @@ public:
 
 	void drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t width, int16_t height);
 	void drawIcon(int16_t x, int16_t y, const String &iconName, int16_t size, uint8_t alignment = Alignment::Top | Alignment::Left);
-	void drawRect(int16_t x, int16_t y, int16_t w, int16_t h) { display->drawRect(x, y, w, h, foregroundColor); }
+	void drawRect(int16_t x, int16_t y, int16_t w, int16_t h)
+	{
+		if (isVisible(y, h))
+		{
+			page->drawRect(x, y, w, h, foregroundColor);
+		}
+	}
 	void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t thickness);
 	void drawRect(const Rect &r) { drawRect(r.x, r.y, r.width, r.height); }
 	void drawRect(const Rect &r, int16_t thickness) { drawRect(r.x, r.y, r.width, r.height, thickness); }
 
-	void fillBackground(int16_t x, int16_t y, int16_t w, int16_t h) { display->fillRect(x, y, w, h, backgroundColor); }
-
-	void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1) { display->drawLine(x0, y0, x1, y1, foregroundColor); }
-	void drawHLine(int16_t x, int16_t y, int16_t len) { drawLine(x, y, x + len, y); }
-	void drawVLine(int16_t x, int16_t y, int16_t len) { drawLine(x, y, x, y + len); }
+	void fillRect(int16_t x, int16_t y, int16_t w, int16_t h)
+	{
+		if (isVisible(y, h))
+		{
+			page->fillRect(x, y, w, h, foregroundColor);
+		}
+	}
+	void fillBackground(int16_t x, int16_t y, int16_t w, int16_t h) { page->fillRect(x, y, w, h, backgroundColor); }
+
+	// flips the colors of a region, e.g. to highlight it after it was drawn
+	void invertRect(int16_t x, int16_t y, int16_t w, int16_t h) { page->invertRect(x, y, w, h); }
+	void invertRect(const Rect &r) { invertRect(r.x, r.y, r.width, r.height); }
+
+	void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1)
+	{
+		if (isVisible(std::min(y0, y1), abs(y1 - y0) + 1))
+		{
+			page->drawLine(x0, y0, x1, y1, foregroundColor);
+		}
+	}
+	void drawHLine(int16_t x, int16_t y, int16_t len) { page->drawFastHLine(x, y, len + 1, foregroundColor); }
+	void drawVLine(int16_t x, int16_t y, int16_t len) { page->drawFastVLine(x, y, len + 1, foregroundColor); }
 
 protected:
-	static void _setFontSize(Adafruit_GFX *buffer, uint8_t fontSize);
+	// initializes the current page from the static layer or the background
+	void clearPage();
+
+	// sends the rows [y, y + h) to the panel, planes[p] points to the h rows
+	// of plane p, one after the other
+	void writeRows(const uint8_t *const planes[DISP_PLANES], int16_t y, int16_t h);
+	void refresh();
+
+	// Wraps the text like drawString() does, or returns the cached result of
+	// an earlier call with the same text, font and constraints.
+	const TextLayout &layoutString(const String &text, uint16_t max_width, uint16_t max_lines);
+	void _layoutString(const String &text, TextLayout &layout);
+	Rect _drawString(int16_t x, int16_t y, const String &text, const TextSize &size, uint8_t alignment);
+
+	static void _setFontSize(PageBuffer *buffer, uint8_t fontSize);
 };
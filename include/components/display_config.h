@@ -2,27 +2,32 @@
 
 #include "config.h"
 
+// The b/w frame fits into RAM as it is. The frames of the color panels are
+// kept in strips of DISP_STRIP_HEIGHT rows instead, see StripBuffer, of which
+// DISP_OPEN_STRIPS are held uncompressed at a time.
 #ifdef DISP_BW
 #include <GxEPD2_BW.h>
-#define GxEPD2_DISPLAY_CLASS GxEPD2_BW
 #define GxEPD2_DRIVER_CLASS GxEPD2_750_T7
 #define MAX_HEIGHT(EPD) (EPD::HEIGHT)
+#define DISP_PLANES 1
 #endif
 #ifdef DISP_3C
 #define DISP_WIDTH 800
 #define DISP_HEIGHT 480
 #include <GxEPD2_3C.h>
-#define GxEPD2_DISPLAY_CLASS GxEPD2_3C
 #define GxEPD2_DRIVER_CLASS GxEPD2_750c_Z08
-#define MAX_HEIGHT(EPD) (EPD::HEIGHT / 2)
+#define DISP_PLANES 2
+#define DISP_STRIP_HEIGHT 16
+#define DISP_OPEN_STRIPS 4
 #endif
 #ifdef DISP_7C
 #define DISP_WIDTH 800
 #define DISP_HEIGHT 480
 #include <GxEPD2_7C.h>
-#define GxEPD2_DISPLAY_CLASS GxEPD2_7C
 #define GxEPD2_DRIVER_CLASS GxEPD2_730c_GDEY073D46
-#define MAX_HEIGHT(EPD) (EPD::HEIGHT / 4)
+#define DISP_PLANES 3
+#define DISP_STRIP_HEIGHT 16
+#define DISP_OPEN_STRIPS 4
 #endif
 
 // Define the Alignment enum with bit flags
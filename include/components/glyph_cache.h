@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+#include <Adafruit_GFX.h>
+
+#include "components/unicode_font.h"
+
+// Glyphs of GFX fonts, unpacked from the bit stream of the font into 1bpp
+// bitmaps with their rows padded to full bytes (MSB first). In this form
+// they can be blitted a byte at a time instead of pixel by pixel.
+//
+// Glyphs are unpacked the first time they are asked for, so only the
+// characters that are actually used take up memory.
+class GlyphCache
+{
+protected:
+	static const uint16_t NotCached = 0xFFFF;
+
+	struct FontGlyphs
+	{
+		const void *font; // GFXfont or UnicodeFont
+		std::vector<uint16_t> offsets; // of every glyph in data, or NotCached
+		std::vector<uint8_t> data;
+	};
+
+	std::vector<FontGlyphs> fonts;
+
+	FontGlyphs &glyphsOf(const void *font, uint16_t glyphCount);
+	const uint8_t *get(const void *font, uint16_t glyphCount, uint16_t index, const GFXglyph *glyph, const uint8_t *bitmap);
+
+public:
+	// The bitmap of character c, or NULL if the font has no bitmap for it or
+	// the cache of the font is full.
+	const uint8_t *get(const GFXfont *font, uint8_t c);
+	// the same for the glyph with the given index, see findGlyph()
+	const uint8_t *get(const UnicodeFont *font, uint16_t index);
+};
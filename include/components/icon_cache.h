@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+
+#include "asset_pack.h"
+
+// Icons in sizes that are not in the asset pack, scaled from the master
+// copy of the icon (see AssetPack::Master), so any size can be drawn while
+// only one copy of each icon is stored in flash.
+//
+// Scaled icons are kept in a few slots, the least recently used one is
+// replaced when all of them are taken.
+class IconCache
+{
+protected:
+	struct Slot
+	{
+		uint32_t key; // AssetPack::key() of name and size
+		uint32_t used;
+		std::vector<uint8_t> bitmap;
+	};
+
+	std::vector<Slot> slots;
+	uint32_t useCounter;
+
+public:
+	IconCache(uint8_t slotCount);
+
+	// The icon in the given size, scaled from the master in the pack, or
+	// NULL if the pack has no master for it. The bitmap stays valid until
+	// its slot is taken by another icon.
+	const uint8_t *get(const AssetPack &pack, const char *name, uint16_t size);
+
+	// Scale a square 1bpp bitmap (MSB first, rows padded to full bytes, set
+	// bits are white). Every destination pixel averages the box of source
+	// pixels it covers and becomes black if at least threshold / 256 of
+	// them are black. Sizes above the source size repeat pixels.
+	static void scale(const uint8_t *src, uint16_t srcSize, uint8_t *dst, uint16_t dstSize, uint8_t threshold = 128);
+};
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <Adafruit_GFX.h>
+#include <vector>
+
+#include "components/display_config.h"
+#include "components/glyph_cache.h"
+#include "components/unicode_font.h"
+#include "utf8.h"
+
+// Banded framebuffer the display components draw into.
+//
+// Every color is stored in DISP_PLANES 1bpp planes, MSB first, with rows
+// padded to full bytes. A set bit means "white" on the first plane and "no
+// color" on the others, which is the layout the BW and 3C controllers expect,
+// so bands can be handed to the epd driver as they are. The 7C panel uses
+// three planes holding the bits of the native color index instead.
+//
+// Only the rows of the current band are held in memory. Drawing outside of
+// the band is silently dropped. Rotation is not supported.
+//
+// Subclasses may store the rows differently (see StripBuffer), all access
+// to the pixels goes through rowData().
+class PageBuffer : public Adafruit_GFX
+{
+protected:
+	uint8_t *planes[DISP_PLANES];
+	uint16_t stride;
+	int16_t pageHeight;
+	int16_t bandY;
+	int16_t bandHeight;
+
+	GlyphCache glyphCache;
+	const UnicodeFont *unicodeFont;
+	utf8::Decoder utf8Decoder;
+
+public:
+	PageBuffer(int16_t width, int16_t height, int16_t pageHeight);
+	virtual ~PageBuffer();
+
+	// select the rows [y, y + h) that are currently held in memory
+	void setBand(int16_t y, int16_t h);
+	int16_t getBandY() const { return bandY; }
+	int16_t getBandHeight() const { return bandHeight; }
+	int16_t getPageHeight() const { return pageHeight; }
+	uint16_t getStride() const { return stride; }
+
+	// true if any of the rows [y, y + h) is part of the current band
+	bool intersectsBand(int16_t y, int16_t h) const { return y < bandY + bandHeight && y + h > bandY; }
+
+	// pointer to the row y (in display coordinates) of a plane,
+	// or NULL if the row is not part of the current band
+	uint8_t *row(uint8_t plane, int16_t y)
+	{
+		if (y < bandY || y >= bandY + bandHeight)
+		{
+			return NULL;
+		}
+		return rowData(plane, y);
+	}
+
+	// Read access to consecutive rows of a plane starting at y, e.g. to send
+	// them to the panel. h is the number of rows wanted and is lowered to the
+	// number of rows that are contiguous in memory.
+	virtual const uint8_t *rows(uint8_t plane, int16_t y, int16_t &h);
+
+	virtual void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+	virtual void fillScreen(uint16_t color) override;
+	virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+	virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override { fillRect(x, y, w, 1, color); }
+	virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override { fillRect(x, y, 1, h, color); }
+
+	// Text is UTF-8 encoded. It is drawn with the unicode font if one is set,
+	// otherwise with the GFX font, which only has 7-bit glyphs, so other
+	// characters are replaced, see utf8::fold(). Glyphs are drawn from the
+	// glyph cache where possible. Scaled text, wrapping and the classic
+	// font go through Adafruit_GFX.
+	using Adafruit_GFX::write;
+	virtual size_t write(uint8_t c) override;
+
+	// Draw text with the given font instead of the GFX font, NULL to go back
+	// to the GFX font. Unicode fonts are not scaled by setTextSize().
+	void setUnicodeFont(const UnicodeFont *font) { unicodeFont = font; }
+	// like getTextBounds() at 0/0, but for UTF-8 text and both kinds of fonts
+	void textBounds(const String &text, int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h);
+
+	// flip every pixel of the rectangle between black and white
+	void invertRect(int16_t x, int16_t y, int16_t w, int16_t h);
+
+	// Blit a 1bpp bitmap (MSB first, rows padded to full bytes) into the band.
+	// Set bits are drawn in color, cleared bits are left untouched. If inverted
+	// is true, the cleared bits are drawn instead (like drawInvertedBitmap).
+	void drawBitmap1bpp(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color, bool inverted);
+
+	// Copy a rectangle of the band, run-length encoded row after row and each
+	// row plane after plane, or restore it from such a copy. x and w must be
+	// multiples of 8 and the rectangle must lie within the band, otherwise
+	// false is returned and nothing is copied.
+	bool readRect(int16_t x, int16_t y, int16_t w, int16_t h, std::vector<uint8_t> &out);
+	bool writeRect(int16_t x, int16_t y, int16_t w, int16_t h, const uint8_t *data, size_t len);
+
+	// bit p of the result is the value written to plane p for this color
+	static uint8_t planeBits(uint16_t color);
+
+protected:
+	// for subclasses that manage the memory of the rows themselves
+	PageBuffer(int16_t width, int16_t height);
+
+	// pointer to the row y of a plane, y must be part of the band
+	virtual uint8_t *rowData(uint8_t plane, int16_t y) { return planes[plane] + (y - bandY) * stride; }
+
+	enum SpanOp : uint8_t
+	{
+		Clear,
+		Set,
+		Toggle
+	};
+
+	// clip the rectangle to the panel width and the current band.
+	// Returns false if nothing of it is left.
+	bool clip(int16_t &x0, int16_t &y0, int16_t &x1, int16_t &y1) const;
+	void spanRows(uint8_t plane, int16_t x0, int16_t y0, int16_t x1, int16_t y1, SpanOp op);
+
+	size_t writeGfx(uint8_t c);
+	void writeUnicode(uint32_t codepoint);
+	const GFXglyph *unicodeGlyph(uint32_t codepoint, int32_t &index) const;
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "components.h"
+#include "client/calendar_client.h"
+#include "config.h"
+
+// The multi-room mode (MULTI_ROOM) below the status bar: a column per room
+// with its name, the meeting going on or how long it is free, and the next
+// meeting. Drawn from the room summaries alone.
+class Rooms : public DisplayComponent
+{
+private:
+    calendar_client::CalendarClient *calClient;
+    int columns;
+
+public:
+#if defined(DISP_3C) || defined(DISP_7C)
+    Rooms(DisplayBuffer *buffer, calendar_client::CalendarClient *calClient, Color accentColor);
+#else
+    Rooms(DisplayBuffer *buffer, calendar_client::CalendarClient *calClient);
+#endif
+
+    virtual void render(time_t now) const override;
+    // the column separators and the rules around the state of the rooms
+    virtual void renderStatic() const override;
+
+protected:
+    const int nameHeight = 32;
+    const int nextHeight = 56;
+    const int padding = 8;
+
+    void renderRoom(int x, const calendar_client::RoomSummary &room, time_t now) const;
+};
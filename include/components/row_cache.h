@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+
+#include "components/display_buffer.h"
+#include "journal.h"
+
+// Cache of rendered regions of the display in flash (the journal partition),
+// so that regions that look exactly like on a previous wake are copied
+// instead of being laid out and rasterized again.
+//
+// Regions are identified by a key, a hash of everything that affects how
+// they look, see fnv1a(). When the cache would grow beyond its budget (in bytes), the
+// regions that were not drawn for the most wakes are evicted first.
+class RowCache
+{
+protected:
+	struct Entry
+	{
+		uint32_t key;
+		uint32_t lastUsed; // wake the region was last drawn on
+		uint16_t size;
+	};
+
+	size_t budget;
+	std::vector<Entry> index;
+	uint32_t wake;
+	bool open;
+	bool changed;
+	Journal *journal; // shared, see Journal::shared()
+
+	std::vector<Entry>::iterator find(uint32_t key);
+	void remove(std::vector<Entry>::iterator entry);
+	void evict(size_t needed);
+
+public:
+	RowCache(size_t budget) : budget(budget), wake(0), open(false), changed(false), journal(NULL) {}
+
+	// loads the index, must be called before draw() and store()
+	void begin();
+	// writes back the index
+	void end();
+
+	// copies the cached region into the buffer, false if it is not cached
+	bool draw(DisplayBuffer *buffer, uint32_t key, const Rect &r);
+	// adds the region as it is drawn in the buffer now
+	void store(DisplayBuffer *buffer, uint32_t key, const Rect &r);
+};
@@ -43,6 +43,7 @@ public:
 #endif
 
     virtual void render(time_t now) const override;
+    virtual void renderStatic() const override;
 
     const static int StatusBarHeight = 24;
 };
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+
+#include "components/page_buffer.h"
+
+// Full frame buffer for panels whose uncompressed frame does not fit into
+// RAM, so everything can be rendered in a single pass.
+//
+// The frame is cut into horizontal strips of stripHeight rows. A strip that
+// is a single solid color only remembers that color, every other strip is
+// kept run-length encoded. The strips that are currently being drawn to are
+// decoded into a small number of slots and encoded again once they are the
+// least recently used strip and the slot is needed for another one.
+//
+// The band always covers the whole display.
+class StripBuffer : public PageBuffer
+{
+protected:
+	static const uint8_t NotSolid = 0xFF;
+
+	struct Strip
+	{
+		int8_t slot;               // slot holding the decoded rows, or -1
+		uint8_t solid;             // planeBits() of the strip color or NotSolid
+		std::vector<uint8_t> data; // encoded planes if not solid
+	};
+
+	int16_t stripHeight;
+	uint8_t slotCount;
+	size_t slotPlaneBytes;
+	std::vector<Strip> strips;
+
+	uint8_t *slotData;
+	int16_t *slotStrip; // strip held by each slot, or -1
+	uint32_t *slotUsed; // value of useCounter at the last access
+	bool *slotDirty;
+	uint32_t useCounter;
+
+	virtual uint8_t *rowData(uint8_t plane, int16_t y) override;
+
+	int8_t open(int16_t strip, bool write);
+	void close(int8_t slot);
+	int16_t stripRows(int16_t strip) const { return std::min(stripHeight, (int16_t)(HEIGHT - strip * stripHeight)); }
+
+public:
+	StripBuffer(int16_t width, int16_t height, int16_t stripHeight, uint8_t slotCount);
+	virtual ~StripBuffer();
+
+	virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+	virtual const uint8_t *rows(uint8_t plane, int16_t y, int16_t &h) override;
+
+	// memory currently used by the encoded strips, in bytes
+	size_t getEncodedSize() const;
+};
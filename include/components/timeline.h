@@ -0,0 +1,32 @@
+#pragma once
+
+#include "components.h"
+#include "client/calendar_client.h"
+#include "config.h"
+
+// Bar under the status bar that shows the busy and tentative times of the
+// day between TIMELINE_START and TIMELINE_END, and where now is. It is drawn
+// from the occupancy of the day, one span per run of busy minutes.
+class Timeline : public DisplayComponent
+{
+public:
+#if defined(DISP_3C) || defined(DISP_7C)
+    Timeline(DisplayBuffer *buffer, Color accentColor);
+#else
+    Timeline(DisplayBuffer *buffer);
+#endif
+
+    virtual void render(time_t now) const override;
+    virtual void renderStatic() const override;
+
+    // including the separator in its last row
+    const static int TimelineHeight = 12;
+
+protected:
+    const int padding = 4;
+    const int barHeight = 7;
+
+    // x of a minute of the day, clamped to the bar
+    int minuteX(int minute) const;
+    void renderRuns(const uint32_t *plane, int barY, bool hatched) const;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <Adafruit_GFX.h>
+
+// A font like GFXfont, but for an arbitrary set of code points instead of a
+// contiguous range of 8-bit characters. Generated from TrueType fonts by
+// fonts/ttf_to_header.py.
+//
+// The glyphs are stored in the order of the code points, which are sorted,
+// so a glyph is found with a binary search.
+typedef struct
+{
+	const uint8_t *bitmap;       // glyph bitmaps, concatenated like in GFXfont
+	const GFXglyph *glyph;       // one glyph per code point
+	const uint16_t *codepoints;  // sorted ascending
+	uint16_t count;              // number of code points
+	uint8_t yAdvance;            // newline distance
+} UnicodeFont;
+
+// index of the glyph of the code point in the font, or -1
+inline int32_t findGlyph(const UnicodeFont *font, uint32_t codepoint)
+{
+	int32_t lo = 0;
+	int32_t hi = (int32_t)font->count - 1;
+
+	while (lo <= hi)
+	{
+		int32_t mid = (lo + hi) / 2;
+		uint16_t cp = font->codepoints[mid];
+
+		if (cp == codepoint)
+		{
+			return mid;
+		}
+		if (cp < codepoint)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid - 1;
+		}
+	}
+	return -1;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "components/page_buffer.h"
+
+// Icons stored as outlines instead of bitmaps, so they can be drawn in any
+// size from a fraction of the flash. Made from the SVGs by
+// icons/svg_outline.py.
+//
+// An outline is a sequence of commands, each a byte followed by its points:
+//   0 move to (1 point), 1 line to (1 point), 2 cubic curve to (3 points),
+//   3 close the contour (no points)
+// Coordinates are on a grid of Units x Units across the icon. Every value is
+// the difference to the previous x or y value, zigzag encoded as a varint.
+//
+// Outlines are filled with the even-odd rule, by sampling every pixel at its
+// center, without anti-aliasing.
+class VectorIcon
+{
+public:
+	static const uint16_t Units = 4096;
+
+	enum Command : uint8_t
+	{
+		Move,
+		Line,
+		Cubic,
+		Close
+	};
+
+	// Fill the outline into the page at x/y, scaled to size x size. Only the
+	// rows within the band are rasterized. Returns false if the data is
+	// malformed, nothing is drawn in that case.
+	static bool draw(PageBuffer &page, const uint8_t *data, size_t len, int16_t x, int16_t y, uint16_t size, uint16_t color);
+
+protected:
+	struct Edge
+	{
+		float x;    // x at the center of the first row the edge crosses
+		float dxdy; // change of x per row
+		int16_t y0; // first row whose center is on the edge
+		int16_t y1; // first row below the edge
+	};
+
+	// The straight edges of an outline, in pixels.
+	class Edges
+	{
+	public:
+		std::vector<Edge> edges;
+		float startX, startY, curX, curY;
+
+		Edges() : startX(0), startY(0), curX(0), curY(0) {}
+
+		void moveTo(float x, float y);
+		void lineTo(float x, float y);
+		void cubicTo(float x1, float y1, float x2, float y2, float x, float y);
+		void close() { lineTo(startX, startY); }
+	};
+
+	static void fill(PageBuffer &page, std::vector<Edge> &edges, uint16_t color);
+};
@@ -17,15 +17,42 @@
 //   DISP_BW  - 7.5in e-Paper (v2)      800x480px  Black/White
 //   DISP_3C  - 7.5in e-Paper (B)       800x480px  Red/Black/White
 //   DISP_7C  - 7.3in ACeP e-Paper (F)  800x480px  7-Color
-// Uncomment the macro that identifies your physical panel.
+// Uncomment the macro that identifies your physical panel, or pass it as a
+// build flag (e.g. -DDISP_7C), which takes precedence.
+#if !defined(DISP_BW) && !defined(DISP_3C) && !defined(DISP_7C)
 #define DISP_BW
 // #define DISP_3C
 // #define DISP_7C
+#endif
 
 #ifdef DISP_BW
 #define INVERT_AS_ACCENT true
 #endif
 
+// ROW CACHE
+// Calendar entries that look exactly like on a previous wake are copied from
+// a cache in flash (the journal partition, see partitions.csv) instead of
+// being drawn again. Size in bytes, at most about 200KB with the 256KB
+// journal partition. 0 disables the cache.
+#define ROW_CACHE_SIZE 32768
+
+// ICON CACHE
+// Icons are stored once at full size in the asset pack and scaled to the size
+// they are drawn at. This is the number of scaled icons that are kept in RAM
+// until the next deep sleep (at most 2KB each for a 128px icon).
+#define ICON_CACHE_SLOTS 6
+
+// RTC STORE
+// Bytes of RTC memory for the state that is kept across deep sleep, see
+// rtc_store.h. Checked against the records at compile time. The ESP32 has
+// 8KB of RTC slow memory, shared with the text layout cache.
+#define RTC_STORE_SIZE 2048
+
+// OCCUPANCY
+// Number of days, starting today, whose free/busy minutes are kept in RTC
+// memory, so wakes without network still know the schedule (540 bytes each).
+#define OCCUPANCY_DAYS 2
+
 // PINS
 // The configuration below is intended for use with the project's official
 // wiring diagrams using the FireBeetle 2 ESP32-E microcontroller board.
@@ -56,6 +83,30 @@
 #define API_ENDPOINT "hass.local"
 #define API_ENDPOINT_PORT 8099
 #define API_ENDPOINT_FETCH_CALENDAR "all"
+// More calendars shown together with API_ENDPOINT_FETCH_CALENDAR, such as a
+// shared building calendar, as a list of quoted names separated by commas,
+// e.g. "building", "holidays". Leave empty to show a single calendar.
+#define API_ENDPOINT_EXTRA_CALENDARS
+
+// Multi-room mode: instead of the calendar of a single room, a column with
+// the current and next meeting of each of these rooms (2 to 4) is shown,
+// fetched in one request every CALENDAR_SYNC_INTERVAL and kept in flash in
+// between, like the single calendar. Comment out for a single room.
+// #define MULTI_ROOM "room_a", "room_b", "room_c"
+
+// Thin-client mode: the server renders the whole panel for the room
+// API_ENDPOINT_FETCH_CALENDAR, and the device only streams the frame from
+// /frame to the panel. An unchanged frame is not transferred again and the
+// panel is left alone. Not to be combined with MULTI_ROOM.
+// #define THIN_CLIENT
+
+// Days of the calendar fetched on every sync, starting today. The calendar
+// is kept in flash, and the wakes between syncs render it from there without
+// turning on WiFi.
+#define CALENDAR_WINDOW_DAYS 7
+// Minutes between syncs, which pick up new invites, changes and the custom
+// status. Set to 0 to sync on every wake.
+#define CALENDAR_SYNC_INTERVAL 120 // minutes
 
 // HTTP
 // The following errors are likely the result of insuffient http client tcp timeout:
@@ -99,6 +150,11 @@
 // NTP_TIMEOUT or select closer/lower latency time servers.
 #define NTP_TIMEOUT 20000 // ms
 
+// Hours of the day shown by the timeline bar under the status bar, busy
+// times are drawn solid, tentative ones hatched. (range: [0-24])
+#define TIMELINE_START 7  // 07:00
+#define TIMELINE_END 20   // 20:00
+
 // Sleep duration in minutes. (aka how often esp32 will wake for an update)
 // Aligned to the nearest minute boundary.
 // For example, if set to 30 (minutes) the display will update at 00 or 30
@@ -243,4 +299,5 @@
 #define TXT_PAST_EVENTS "past events"
 #define TXT_UPCOMINT_EVENTS "upcoming events"
 #define TXT_UNTIL "bis"
+#define TXT_NEXT "danach"
 #define TXT_FREE "Frei"
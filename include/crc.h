@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Checksums for data that is kept across resets, to tell intact data from
+// data that was cut short or damaged.
+namespace crc
+{
+    // CRC-32 (IEEE 802.3). Data in several parts is checked by passing the
+    // result of the previous part as seed.
+    uint32_t crc32(const void *data, size_t len, uint32_t seed = 0);
+};
+
+// 32 bit FNV-1a hash, for keys. Pass the result of a previous call as seed
+// to hash several values as one. See utils.h for the String overload.
+uint32_t fnv1a(const void *data, size_t len, uint32_t seed = 2166136261u);
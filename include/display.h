@@ -2,10 +2,13 @@
 
 #include <vector>
 #include <string>
+#include <functional>
 
 #include "components/statusbar.h"
 #include "components/status.h"
+#include "components/timeline.h"
 #include "components/calendar.h"
+#include "components/rooms.h"
 #include "client/calendar_client.h"
 #include "utils.h"
 #include "components/display_buffer.h"
@@ -21,12 +24,20 @@ private:
 	int8_t pin_epd_cs;
 
 	StatusBar *statusBar;
+	Timeline *timeline;
 	Calendar *calendar;
 	Status *statusIndicator;
+	Rooms *rooms; // in multi-room mode, instead of the three above
 	calendar_client::CalendarClient *calClient;
 
 	bool initialized;
 
+	// run-length encoded content every page of render() starts with
+	std::vector<uint8_t> staticLayer;
+
+	// work that runs while the panel holds BUSY during the refresh
+	std::vector<std::function<void()>> refreshTasks;
+
 	// working with the display
 public:
 #if defined(DISP_3C) || defined(DISP_7C)
@@ -40,17 +51,25 @@ public:
 	void init();
 
 	// turn the power to the display off.
-	// first puts the epd driver to deep sleep for, and then
-	// cuts power to the power pin
+	// first waits for a running refresh to finish, puts the epd driver to
+	// deep sleep and then cuts power to the power pin
 	void powerOff();
 
+	// queue work to be done while the panel is refreshing. Every task runs
+	// exactly once, either from the busy callback of the next refresh, or
+	// at the latest when powerOff() is called.
+	void addRefreshTask(std::function<void()> task) { refreshTasks.push_back(task); }
+	void runRefreshTasks();
+
 	// Display configuration
 public:
 	void setStatus(String message, bool isImportant = false, const uint8_t *icon = NULL);
 
 	// Rendering functions
 public:
-	// renders the display in a single refresh cycle for the display
+	// renders the display in a single refresh cycle for the display.
+	// The panel is not powered off afterwards, so that the caller can keep
+	// working while the refresh is still running. Call powerOff() when done.
 	void render(time_t now)
 	{
 		if (!initialized)
@@ -58,14 +77,35 @@ public:
 			init();
 		}
 
+		if (staticLayer.empty())
+		{
+			loadStaticLayer();
+		}
+
+		buffer->setStaticLayer(&staticLayer);
 		do
 		{
 			_render(now);
 		} while (buffer->nextPage());
+		buffer->setStaticLayer(NULL);
+	}
 
-		powerOff();
+	// Thin-client mode: sends a frame rendered by the server straight to the
+	// panel, see DisplayBuffer::streamFrame(). The panel is not powered off
+	// afterwards, like with render().
+	bool renderFrame(Stream &stream)
+	{
+		if (!initialized)
+		{
+			init();
+		}
+
+		return buffer->streamFrame(stream);
 	}
 
+	int16_t width() { return buffer->width(); }
+	int16_t height() { return buffer->height(); }
+
 	// Draw an error message to the display.
 	// If only title is specified, content of tilte is wrapped across two lines
 	void error(String icon, const String &title, const String &description = "", time_t now = 0)
@@ -85,13 +125,14 @@ public:
 		{
 			init();
 		}
+#ifdef THIN_CLIENT
+		calendar_client::CalendarClient::forgetFrame();
+#endif
 
 		do
 		{
 			_fullPageStatus(icon, 196, title, description, now);
 		} while (buffer->nextPage());
-
-		powerOff();
 	}
 
 	void fullPageStatus(String icon, int16_t iconSize, const String &title, const String &description, time_t now)
@@ -100,18 +141,27 @@ public:
 		{
 			init();
 		}
+#ifdef THIN_CLIENT
+		calendar_client::CalendarClient::forgetFrame();
+#endif
 
 		do
 		{
 			_fullPageStatus(icon, 196, title, description, now);
 		} while (buffer->nextPage());
-
-		powerOff();
 	}
 
 	// internal rendering functions.
 	// they draw the display, but do not take care of the nextPage. That is done in the public variants
 protected:
+	static void _onBusy(const void *display);
+
+	// loads the static layer from flash, or composes and stores it if the
+	// stored one does not match the current layout
+	void loadStaticLayer();
+
+	void _renderStatic() const;
+
 	void _fullPageStatus(String icon, int16_t iconSize, const String &title, const String &description, time_t now) const;
 	void _render(time_t now) const;
 };
\ No newline at end of file
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// Append-only log of key/value records in its own data partition, for caches
+// that are too large for RTC memory and rewritten too often for NVS.
+//
+// The partition is written sector after sector as a ring, which spreads the
+// wear evenly. Putting a key appends a record and the newest record of a key
+// wins, removing a key appends a tombstone. The sector after the one being
+// written is always kept erased: when the current sector is full, writing
+// moves on to the erased one, the records still in use in the sector after
+// it (the oldest) are copied over, and the oldest is erased (compaction).
+//
+// Every record carries a CRC over its header and data, it only counts once
+// it was written completely. A record cut short by a reset is ignored and
+// the previous value of its key is kept. Once a compaction has copied all
+// records, it appends a marker record before erasing the oldest sector. A
+// compaction that was interrupted before the marker is done again by the
+// next begin(), one that was interrupted after it only finishes the erase.
+//
+// Values are read in place from the memory mapped partition. On the host,
+// the partition is a memory mapped file "<name>.bin" instead, and writing
+// can be made to fail at any point with injectFault().
+//
+// Layout of every sector:
+//   header   magic "JRNL", uint32 sequence (increases with every sector)
+//   records  uint32 key, uint16 length, uint16 flags, uint32 crc,
+//            data padded to 4 bytes
+//
+// Only one instance may use a partition at a time, the users of the journal
+// partition share the one of shared().
+class Journal
+{
+public:
+    static const uint32_t Magic = 0x4C4E524A; // "JRNL"
+    static const uint32_t SectorSize = 4096;
+    // size of the file created on the host
+    static const uint32_t HostSize = 64 * SectorSize;
+
+    Journal();
+    ~Journal() { end(); }
+
+    // map the partition with the given label, false if it is missing or
+    // can not be used
+    bool begin(const char *name = "journal");
+    void end();
+    bool isOpen() const { return base != NULL; }
+
+    // The newest value of key, NULL if there is none. Points into the
+    // mapped partition and stays valid until the next put() or remove().
+    const uint8_t *get(uint32_t key, size_t &length) const;
+    bool put(uint32_t key, const void *data, size_t length);
+    bool remove(uint32_t key);
+
+    // number of keys with a value
+    size_t count() const { return index.size(); }
+
+    // the "journal" partition, mapped on first use and kept mapped
+    static Journal &shared();
+
+    // separates the keys of different users of the journal
+    static uint32_t key(const char *space, uint32_t id);
+
+#ifndef ARDUINO
+    // Lets the next writes and erases stop after bytes more bytes, as if the
+    // power was cut. Everything fails afterwards, until the next begin().
+    void injectFault(size_t bytes) { faultBudget = bytes; }
+#endif
+
+protected:
+    struct SectorHeader
+    {
+        uint32_t magic;
+        uint32_t sequence;
+    };
+
+    struct RecordHeader
+    {
+        uint32_t key;
+        uint16_t length;
+        uint16_t flags;
+        uint32_t crc; // of key, length, flags and the data
+    };
+
+    static const uint16_t Tombstone = 1;
+    // marks the end of the copies made by a compaction, the key is the
+    // sequence of the compacted sector
+    static const uint16_t Compacted = 2;
+
+    // where the newest record of a key starts in the partition
+    struct Location
+    {
+        uint32_t key;
+        uint32_t offset;
+    };
+
+    std::vector<Location> index; // sorted by key
+
+    const uint8_t *base;
+    size_t size;
+    uint32_t handle; // mmap handle of the partition
+    const void *partition;
+    uint16_t sectors;
+
+    uint16_t head;     // the sector being written
+    uint32_t offset;   // where the next record goes
+    uint32_t sequence; // of the head
+
+#ifndef ARDUINO
+    long faultBudget;
+#endif
+
+    bool mount();
+    void scan(uint16_t sector);
+    bool isCompacted(uint16_t sector, uint32_t compactedSequence) const;
+    bool advance();
+    bool compact(uint16_t sector);
+    bool append(uint32_t key, const void *data, size_t length, uint16_t flags);
+    bool writeRecord(uint32_t key, const void *data, size_t length, uint16_t flags);
+
+    bool write(uint32_t address, const void *data, size_t length);
+    bool erase(uint16_t sector);
+    bool isBlank(uint16_t sector) const;
+    bool isUsed(uint16_t sector) const;
+
+    void setLocation(uint32_t key, uint32_t offset);
+    void removeLocation(uint32_t key);
+
+    static uint32_t recordSize(size_t length) { return sizeof(RecordHeader) + ((length + 3) & ~3); }
+    static uint32_t checksum(const RecordHeader &header, const void *data);
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// Byte oriented run-length encoding (PackBits style), used for bitmaps that
+// are mostly blank.
+//
+// A control byte c < 128 is followed by c + 1 literal bytes.
+// A control byte c >= 128 is followed by one byte that repeats c - 126 times.
+namespace rle
+{
+    // appends the encoded data to out
+    void encode(const uint8_t *data, size_t len, std::vector<uint8_t> &out);
+
+    // Decoder that can be fed the encoded data in arbitrary chunks, e.g.
+    // straight from a network stream. Runs that are cut off at the end of a
+    // chunk are continued when the next chunk is set.
+    class Decoder
+    {
+    protected:
+        const uint8_t *in;
+        size_t inLen;
+        size_t pos;
+
+        uint8_t remaining; // bytes left in the current run
+        bool literal;
+        bool pending; // the value of a repeat run was not read yet
+        uint8_t value;
+
+    public:
+        Decoder() : in(NULL), inLen(0), pos(0), remaining(0), literal(false), pending(false), value(0) {}
+
+        // start decoding a new stream
+        void reset(const uint8_t *data, size_t len);
+        // continue the current stream with the next chunk of encoded data
+        void setInput(const uint8_t *data, size_t len);
+
+        // Decodes up to len bytes into out, or skips them if out is NULL.
+        // Returns the number of bytes produced, which is less than len when
+        // the input ran out.
+        size_t read(uint8_t *out, size_t len);
+
+        // true when all input was consumed and no run is pending
+        bool done() const { return remaining == 0 && !pending && pos >= inLen; }
+    };
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "client/calendar_store.h"
+#include "client/occupancy.h"
+#include "config.h"
+
+// The records kept in the RTC store and their types. Bump RtcStore::Version
+// whenever one is added, removed or its type changes.
+namespace rtc_record
+{
+    enum Id : uint8_t
+    {
+        Occupancy, // free/busy minutes of the coming days
+        Sync,      // when the calendar was last fetched
+        Frame,     // the frame shown in thin-client mode
+        Count
+    };
+
+    template <Id id>
+    struct Type;
+
+    template <>
+    struct Type<Occupancy>
+    {
+        typedef calendar_client::DayOccupancy Value[OCCUPANCY_DAYS];
+    };
+
+    template <>
+    struct Type<Sync>
+    {
+        typedef calendar_client::SyncState Value;
+    };
+
+    template <>
+    struct Type<Frame>
+    {
+        typedef calendar_client::FrameState Value;
+    };
+
+    constexpr size_t dataSize(int id)
+    {
+        return id == Occupancy ? sizeof(Type<Occupancy>::Value) : id == Sync ? sizeof(Type<Sync>::Value) : id == Frame ? sizeof(Type<Frame>::Value) : 0;
+    }
+};
+
+// State that has to survive deep sleep, kept in RTC slow memory. Unlike
+// Preferences (NVS), saving costs no flash write and no wear, but everything
+// is lost on power loss or reset. After such a cold boot, or when the
+// layout of the records changed, the store starts out empty.
+//
+// Every record has a fixed place and is saved with its length and a CRC, so
+// loading a record that was never saved or got corrupted fails instead of
+// returning garbage.
+//
+// On the host, where there is no RTC memory, the store is kept in the file
+// "rtc_store.bin" instead, which stands in for a deep sleep between runs.
+class RtcStore
+{
+public:
+    static const uint32_t Magic = 0x53435452; // "RTCS"
+    static const uint16_t Version = 3;
+
+    struct Header
+    {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t size;
+    };
+
+    struct RecordHeader
+    {
+        uint32_t crc;
+        uint16_t length; // 0 if the record was not saved
+        uint16_t reserved;
+    };
+
+    // bytes taken up by a record and its header, and where it starts
+    static constexpr size_t slotSize(int id) { return sizeof(RecordHeader) + ((rtc_record::dataSize(id) + 3) & ~3); }
+    static constexpr size_t offset(int id) { return id == 0 ? sizeof(Header) : offset(id - 1) + slotSize(id - 1); }
+
+    // Checks the store, to be called once before any other method. Returns
+    // false if it was reset because of a cold boot or a new layout.
+    static bool begin();
+
+    template <rtc_record::Id id>
+    static bool load(typename rtc_record::Type<id>::Value &value) { return read(id, &value, sizeof(value)); }
+
+    template <rtc_record::Id id>
+    static void save(const typename rtc_record::Type<id>::Value &value) { write(id, &value, sizeof(value)); }
+
+    static void erase(rtc_record::Id id);
+
+protected:
+    static bool read(rtc_record::Id id, void *data, size_t length);
+    static void write(rtc_record::Id id, const void *data, size_t length);
+    static void reset();
+};
+
+static_assert(RtcStore::offset(rtc_record::Count) <= RTC_STORE_SIZE, "the RTC store records do not fit into RTC_STORE_SIZE");
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Decoding of UTF-8 encoded text, as it arrives from the calendar API.
+namespace utf8
+{
+    // returned for malformed input
+    const uint32_t Replacement = 0xFFFD;
+    // returned by Decoder::feed() while a sequence is incomplete
+    const uint32_t Incomplete = 0xFFFFFFFF;
+
+    // Decoder that is fed one byte at a time, e.g. from Print::write()
+    class Decoder
+    {
+    protected:
+        uint32_t codepoint;
+        uint8_t remaining; // continuation bytes still expected
+
+    public:
+        Decoder() : codepoint(0), remaining(0) {}
+
+        // Returns the decoded code point once a sequence is complete,
+        // Incomplete before that and Replacement for malformed sequences.
+        uint32_t feed(uint8_t b);
+        void reset() { remaining = 0; }
+    };
+
+    // Decodes the code point starting at pos (pos < len) and moves pos past
+    // it. Malformed sequences yield Replacement.
+    uint32_t next(const char *s, size_t len, size_t &pos);
+
+    // A printable ASCII stand-in for a code point, for fonts that only have
+    // 7-bit glyphs: accents are dropped from Latin-1 letters ('Ü' -> 'U'),
+    // everything else that is not ASCII becomes '?'.
+    char fold(uint32_t codepoint);
+};
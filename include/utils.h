@@ -24,6 +24,8 @@
 #include <WiFiClient.h>
 #include <HTTPClient.h>
 
+#include "crc.h"
+
 wl_status_t startWiFi();
 void killWiFi();
 bool getNtpTime(tm *timeInfo);
@@ -36,9 +38,7 @@ String getRefreshTimeStr(tm *timeInfo, bool timeSuccess);
 const char *getWiFidesc(int rssi);
 const char *getWifiStatusPhrase(wl_status_t status);
 void disableBuiltinLED();
+uint32_t fnv1a(const String &s, uint32_t seed = 2166136261u);
 const uint8_t *getIcon(String iconName, int16_t iconSize);
-const uint8_t *getIcon24(String iconName);
-const uint8_t *getIcon32(String iconName);
-const uint8_t *getIcon48(String iconName);
-const uint8_t *getIcon128(String iconName);
-const uint8_t *getIcon196(String iconName);
\ No newline at end of file
+const uint8_t *getIconOutline(String iconName, int16_t iconSize, size_t &length);
+uint32_t getIconPackKey();
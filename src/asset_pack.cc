@@ -0,0 +1,211 @@
+#include "asset_pack.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <esp_idf_version.h>
+#include <esp_partition.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "config.h"
+#include "utils.h"
+
+bool AssetPack::begin(const char *name)
+{
+	end();
+
+#ifdef ARDUINO
+	const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, name);
+	if (partition == NULL)
+	{
+		Serial.printf("[error]: Partition '%s' not found\n", name);
+		return false;
+	}
+
+	// only map as much of the partition as the pack takes up
+	Header header;
+	if (esp_partition_read(partition, 0, &header, sizeof(header)) != ESP_OK || header.magic != Magic || header.size > partition->size)
+	{
+		Serial.printf("[error]: Partition '%s' does not hold an asset pack\n", name);
+		return false;
+	}
+
+	const void *data;
+#if ESP_IDF_VERSION_MAJOR >= 5
+	esp_partition_mmap_handle_t mapHandle;
+	esp_err_t err = esp_partition_mmap(partition, 0, header.size, ESP_PARTITION_MMAP_DATA, &data, &mapHandle);
+#else
+	spi_flash_mmap_handle_t mapHandle;
+	esp_err_t err = esp_partition_mmap(partition, 0, header.size, SPI_FLASH_MMAP_DATA, &data, &mapHandle);
+#endif
+	if (err != ESP_OK)
+	{
+		Serial.printf("[error]: Mapping partition '%s' failed (%d)\n", name, err);
+		return false;
+	}
+
+	base = (const uint8_t *)data;
+	size = header.size;
+	handle = mapHandle;
+#else
+	char path[64];
+	snprintf(path, sizeof(path), "%s.bin", name);
+
+	int fd = open(path, O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		Serial.printf("[error]: Asset pack '%s' not found\n", path);
+		if (fd >= 0)
+		{
+			close(fd);
+		}
+		return false;
+	}
+
+	void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		Serial.printf("[error]: Mapping '%s' failed\n", path);
+		return false;
+	}
+
+	base = (const uint8_t *)data;
+	size = st.st_size;
+#endif
+
+	if (!validate())
+	{
+		Serial.printf("[error]: Asset pack '%s' is invalid\n", name);
+		end();
+		return false;
+	}
+
+#if DEBUG_LEVEL >= 1
+	Serial.printf("[debug] Mapped asset pack '%s', %u assets, %u bytes\n", name, count(), (unsigned)size);
+#endif
+
+	return true;
+}
+
+void AssetPack::end()
+{
+	if (base == NULL)
+	{
+		return;
+	}
+
+#ifdef ARDUINO
+#if ESP_IDF_VERSION_MAJOR >= 5
+	esp_partition_munmap(handle);
+#else
+	spi_flash_munmap(handle);
+#endif
+#else
+	munmap((void *)base, size);
+#endif
+
+	base = NULL;
+	size = 0;
+	handle = 0;
+	content = 0;
+}
+
+// Checks the header and that every index entry points into the pack, so the
+// lookups can trust it.
+bool AssetPack::validate() const
+{
+	if (size < sizeof(Header))
+	{
+		return false;
+	}
+
+	const Header *header = (const Header *)base;
+	if (header->magic != Magic || header->version != Version || header->size > size ||
+		sizeof(Header) + header->count * sizeof(Entry) > header->size)
+	{
+		return false;
+	}
+
+	const Entry *index = entries();
+	for (uint16_t i = 0; i < header->count; i++)
+	{
+		if (index[i].offset > header->size || index[i].length > header->size - index[i].offset)
+		{
+			return false;
+		}
+		if (i > 0 && index[i - 1].key >= index[i].key)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+uint16_t AssetPack::count() const
+{
+	return base != NULL ? ((const Header *)base)->count : 0;
+}
+
+uint32_t AssetPack::contentKey() const
+{
+	if (content == 0 && base != NULL)
+	{
+		content = fnv1a(base, ((const Header *)base)->size);
+	}
+	return content;
+}
+
+uint32_t AssetPack::key(const char *name, uint16_t size)
+{
+	char id[64];
+	int len = snprintf(id, sizeof(id), "%s@%u", name, size);
+	return fnv1a(id, std::min(len, (int)sizeof(id) - 1));
+}
+
+bool AssetPack::find(const char *name, uint16_t size, Asset &asset) const
+{
+	return find(key(name, size), asset);
+}
+
+bool AssetPack::find(uint32_t key, Asset &asset) const
+{
+	if (base == NULL)
+	{
+		return false;
+	}
+
+	const Entry *index = entries();
+	int32_t lo = 0, hi = count() - 1;
+	while (lo <= hi)
+	{
+		int32_t mid = (lo + hi) / 2;
+		if (index[mid].key < key)
+		{
+			lo = mid + 1;
+		}
+		else if (index[mid].key > key)
+		{
+			hi = mid - 1;
+		}
+		else
+		{
+			asset.data = base + index[mid].offset;
+			asset.length = index[mid].length;
+			asset.width = index[mid].width;
+			asset.height = index[mid].height;
+			return true;
+		}
+	}
+
+	return false;
+}
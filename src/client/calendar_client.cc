@@ -1,10 +1,51 @@
 #include <Preferences.h>
+#include <algorithm>
 
 #include "client/calendar_client.h"
+#include "client/entry_reader.h"
 #include "config.h"
+#include "journal.h"
+#include "rtc_store.h"
+#include "utils.h"
 
 using namespace calendar_client;
 
+// free/busy minutes of today and the following days, see getOccupancy().
+// Kept in the RTC store across deep sleep, loaded on first use.
+static DayOccupancy occupancy[OCCUPANCY_DAYS];
+static bool occupancyLoaded = false;
+
+// the calendars shown, the first one also names the display to the server
+static const char *const calendars[] = {API_ENDPOINT_FETCH_CALENDAR, API_ENDPOINT_EXTRA_CALENDARS};
+static const size_t calendarCount = sizeof(calendars) / sizeof(calendars[0]);
+
+// the rooms of the multi-room mode
+#ifdef MULTI_ROOM
+static const char *const roomCalendars[] = {MULTI_ROOM};
+#else
+static const char *const roomCalendars[] = {API_ENDPOINT_FETCH_CALENDAR};
+#endif
+static const size_t roomCount = sizeof(roomCalendars) / sizeof(roomCalendars[0]);
+static_assert(roomCount <= RoomSummary::MaxRooms, "MULTI_ROOM lists more rooms than fit on the display");
+
+#ifdef MULTI_ROOM
+// the name the server sent for a room, kept in the journal with its calendar
+static uint32_t roomNameKey(size_t room)
+{
+	return Journal::key("room_name", fnv1a(roomCalendars[room], strlen(roomCalendars[room])));
+}
+#endif
+
+// the frame shown in thin-client mode, see getFrame(). In the RTC store too.
+static FrameState frame;
+static bool frameLoaded = false;
+static bool frameValid = false;
+
+// the last sync, see getLastSync(). Kept in the RTC store as well.
+static SyncState lastSync;
+static bool lastSyncLoaded = false;
+static bool lastSyncValid = false;
+
 CustomStatus::CustomStatus(const JsonObject &json)
 {
 	if (json["icon"].is<const char *>())
@@ -44,57 +85,107 @@ CustomStatus::CustomStatus(const JsonObject &json)
 	}
 }
 
-CalendarEntry::CalendarEntry(const JsonObject &json)
+int CalendarClient::fetchCustomStatus()
 {
-	if (json["title"].is<const char *>())
-	{
-		title = String(json["title"].as<const char *>());
-	}
+	int attempts = 0;
+	bool rxSuccess = false;
 
-	if (json["message"].is<const char *>())
+	int httpResponse = 0;
+	do
 	{
-		message = String(json["message"].as<const char *>());
-	}
+		wl_status_t connection_status = WiFi.status();
+		if (connection_status != WL_CONNECTED)
+		{
+			// -512 offset distinguishes these errors from httpClient errors
+			return -512 - static_cast<int>(connection_status);
+		}
 
-	if (json["start"].is<time_t>())
-	{
-		start = json["start"].as<time_t>();
-	}
+		HTTPClient http;
+		http.setConnectTimeout(HTTP_CLIENT_TCP_TIMEOUT); // default 10s
+		http.setTimeout(HTTP_CLIENT_TCP_TIMEOUT);		 // default 10s
+		http.addHeader(String("Content-Type"), String("application/protobuf"));
 
-	if (json["end"].is<time_t>())
-	{
-		end = json["end"].as<time_t>();
-	}
+		http.begin(client, apiEndpoint, apiPort, String("/status?calendar=") + String(API_ENDPOINT_FETCH_CALENDAR));
+		httpResponse = http.GET();
+		Serial.println("HTTP Response: " + String(httpResponse, DEC));
 
-	if (json["all_day"].is<bool>())
-	{
-		all_day = json["all_day"].as<bool>();
-	}
+		if (httpResponse == HTTP_CODE_OK)
+		{
+			rxSuccess = parseCustomStatus(http);
+		}
 
-	if (json["busy"].is<BusyState>())
-	{
-		busy = json["busy"].as<BusyState>();
-	}
-	else
-	{
-		busy = BusyState::Free;
-	}
+		client.stop();
+		http.end();
+		++attempts;
+	} while (!rxSuccess && attempts < 3);
 
-	if (json["important"].is<bool>())
-	{
-		important = json["important"].as<bool>();
-	}
-	else
+	return httpResponse;
+}
+
+int CalendarClient::fetchCalendar()
+{
+	int attempts = 0;
+	bool rxSuccess = false;
+
+	int httpResponse = 0;
+	do
 	{
-		important = false;
-	}
+		wl_status_t connection_status = WiFi.status();
+		if (connection_status != WL_CONNECTED)
+		{
+			// -512 offset distinguishes these errors from httpClient errors
+			return -512 - static_cast<int>(connection_status);
+		}
+
+		// A connection per calendar, all requested before any is read: the
+		// responses are merged as they come in, and what is not read yet is
+		// held back by the server.
+		WiFiClient clients[calendarCount];
+		HTTPClient http[calendarCount];
+		httpResponse = HTTP_CODE_OK;
+		for (size_t i = 0; i < calendarCount && httpResponse == HTTP_CODE_OK; i++)
+		{
+			http[i].setConnectTimeout(HTTP_CLIENT_TCP_TIMEOUT); // default 10s
+			http[i].setTimeout(HTTP_CLIENT_TCP_TIMEOUT);		// default 10s
+			http[i].addHeader(String("Content-Type"), String("application/protobuf"));
+
+			http[i].begin(clients[i], apiEndpoint, apiPort, String("/calendar?calendar=") + String(calendars[i]) + String("&window=") + String(CALENDAR_WINDOW_DAYS));
+			httpResponse = http[i].GET();
+			Serial.println("HTTP Response: " + String(httpResponse, DEC));
+		}
+
+		if (httpResponse == HTTP_CODE_OK)
+		{
+			rxSuccess = parseCalendars(http, calendarCount);
+		}
+
+		for (size_t i = 0; i < calendarCount; i++)
+		{
+			clients[i].stop();
+			http[i].end();
+		}
+		++attempts;
+	} while (!rxSuccess && attempts < 3);
+
+	return httpResponse;
 }
 
-int CalendarClient::fetchCustomStatus()
+size_t CalendarClient::getRoomCount()
+{
+	return roomCount;
+}
+
+int CalendarClient::fetchRooms()
 {
 	int attempts = 0;
 	bool rxSuccess = false;
 
+	String calendars;
+	for (size_t i = 0; i < roomCount; i++)
+	{
+		calendars += (i > 0 ? "," : "") + String(roomCalendars[i]);
+	}
+
 	int httpResponse = 0;
 	do
 	{
@@ -110,13 +201,15 @@ int CalendarClient::fetchCustomStatus()
 		http.setTimeout(HTTP_CLIENT_TCP_TIMEOUT);		 // default 10s
 		http.addHeader(String("Content-Type"), String("application/protobuf"));
 
-		http.begin(client, apiEndpoint, apiPort, String("/status?calendar=") + String(API_ENDPOINT_FETCH_CALENDAR));
+		// the rooms are rendered from the journal until isSyncDue(), so
+		// they are fetched for as many days as the own calendar
+		http.begin(client, apiEndpoint, apiPort, String("/rooms?calendar=") + calendars + String("&window=") + String(CALENDAR_WINDOW_DAYS));
 		httpResponse = http.GET();
 		Serial.println("HTTP Response: " + String(httpResponse, DEC));
 
 		if (httpResponse == HTTP_CODE_OK)
 		{
-			rxSuccess = parseCustomStatus(http);
+			rxSuccess = parseRooms(http, time(NULL));
 		}
 
 		client.stop();
@@ -127,11 +220,27 @@ int CalendarClient::fetchCustomStatus()
 	return httpResponse;
 }
 
-int CalendarClient::fetchCalendar()
+int CalendarClient::fetchFrame(int16_t width, int16_t height, std::function<bool(Stream &)> render)
 {
 	int attempts = 0;
 	bool rxSuccess = false;
 
+#if defined(DISP_7C)
+	const char *format = "7c";
+#elif defined(DISP_3C)
+	const char *format = "3c";
+#else
+	const char *format = "bw";
+#endif
+	String path = String("/frame?room=") + String(API_ENDPOINT_FETCH_CALENDAR) + String("&format=") + String(format) + String("&width=") + String(width) + String("&height=") + String(height);
+	const FrameState *shown = getFrame();
+	if (shown != NULL)
+	{
+		path += String("&since=") + String(shown->hash, HEX);
+	}
+
+	const char *headers[] = {"X-Frame-Hash", "X-Frame-Valid-Until"};
+
 	int httpResponse = 0;
 	do
 	{
@@ -145,15 +254,33 @@ int CalendarClient::fetchCalendar()
 		HTTPClient http;
 		http.setConnectTimeout(HTTP_CLIENT_TCP_TIMEOUT); // default 10s
 		http.setTimeout(HTTP_CLIENT_TCP_TIMEOUT);		 // default 10s
-		http.addHeader(String("Content-Type"), String("application/protobuf"));
+		// the body is binary and read straight off the connection, so it
+		// must not come in chunks
+		http.useHTTP10(true);
+		http.collectHeaders(headers, sizeof(headers) / sizeof(headers[0]));
 
-		http.begin(client, apiEndpoint, apiPort, String("/calendar?calendar=") + String(API_ENDPOINT_FETCH_CALENDAR));
+		http.begin(client, apiEndpoint, apiPort, path);
 		httpResponse = http.GET();
 		Serial.println("HTTP Response: " + String(httpResponse, DEC));
 
-		if (httpResponse == HTTP_CODE_OK)
+		if (httpResponse == HTTP_CODE_NOT_MODIFIED)
+		{
+			rxSuccess = true;
+		}
+		else if (httpResponse == HTTP_CODE_OK)
 		{
-			rxSuccess = parseCalendar(http);
+			// the panel shows neither the old frame nor the new one until
+			// the new one is complete
+			forgetFrame();
+			rxSuccess = render(http.getStream());
+			if (rxSuccess)
+			{
+				frame.hash = strtoul(http.header("X-Frame-Hash").c_str(), NULL, 16);
+				frame.validUntil = strtol(http.header("X-Frame-Valid-Until").c_str(), NULL, 10);
+				frameLoaded = true;
+				frameValid = true;
+				RtcStore::save<rtc_record::Frame>(frame);
+			}
 		}
 
 		client.stop();
@@ -161,27 +288,87 @@ int CalendarClient::fetchCalendar()
 		++attempts;
 	} while (!rxSuccess && attempts < 3);
 
+	// the server answered, but the frame never arrived completely
+	if (!rxSuccess && httpResponse == HTTP_CODE_OK)
+	{
+		return HTTPC_ERROR_CONNECTION_LOST;
+	}
 	return httpResponse;
 }
 
-const CalendarEntry *CalendarClient::getCurrentEvent(time_t now, bool nowClosestToStart) const
+const FrameState *CalendarClient::getFrame()
 {
-	CalendarEntries possibleCurrentEvents;
+	if (!frameLoaded)
+	{
+		frameValid = RtcStore::load<rtc_record::Frame>(frame);
+		frameLoaded = true;
+	}
+	return frameValid ? &frame : NULL;
+}
 
-	// because we can have multiple calendar events going at the same time, we need to find all that happen now
-	for (CalendarEntries::const_iterator it = entries.begin(); it != entries.end(); it++)
+void CalendarClient::forgetFrame()
+{
+	if (getFrame() != NULL)
 	{
-		if (it->getStart() < now && it->getEnd() > now)
-		{
-#if DEBUG_LEVEL >= 2
-			Serial.printf("[verbose] Event %s happening right now\n", it->getTitle().c_str());
-#endif
-			CalendarEntry entry = *it;
-			possibleCurrentEvents.push_back(entry);
-		}
+		frameValid = false;
+		RtcStore::erase(rtc_record::Frame);
 	}
+}
+
+int CalendarClient::uploadTelemetry(uint32_t batteryVoltage, int rssi, unsigned long awakeMillis)
+{
+	wl_status_t connection_status = WiFi.status();
+	if (connection_status != WL_CONNECTED)
+	{
+		// -512 offset distinguishes these errors from httpClient errors
+		return -512 - static_cast<int>(connection_status);
+	}
+
+	JsonDocument doc;
+	doc["battery_voltage"] = batteryVoltage;
+	doc["battery_percent"] = calcBatPercent(batteryVoltage, MIN_BATTERY_VOLTAGE, MAX_BATTERY_VOLTAGE);
+	doc["rssi"] = rssi;
+	doc["awake_ms"] = awakeMillis;
+	doc["last_updated"] = getLastUpdated();
+
+	String payload;
+	serializeJson(doc, payload);
+
+	HTTPClient http;
+	http.setConnectTimeout(HTTP_CLIENT_TCP_TIMEOUT); // default 10s
+	http.setTimeout(HTTP_CLIENT_TCP_TIMEOUT);		 // default 10s
+
+	http.begin(client, apiEndpoint, apiPort, String("/telemetry?calendar=") + String(API_ENDPOINT_FETCH_CALENDAR));
+	http.addHeader(String("Content-Type"), String("application/json"));
+	int httpResponse = http.POST(payload);
+
+#if DEBUG_LEVEL >= 1
+	Serial.println("[debug] telemetry upload: " + String(httpResponse, DEC));
+#endif
+
+	client.stop();
+	http.end();
+
+	return httpResponse;
+}
+
+const CalendarEntry *CalendarClient::getCurrentEvent(time_t now, bool nowClosestToStart) const
+{
+	return findCurrentEvent(getIndex(), now, nowClosestToStart);
+}
+
+const CalendarEntry *CalendarClient::findCurrentEvent(const CalendarIndex &index, time_t now, bool nowClosestToStart)
+{
+	std::vector<const CalendarEntry *> possibleCurrentEvents;
+
+	// because we can have multiple calendar events going at the same time, we need to find all that happen now
+	index.eventsAt(now, possibleCurrentEvents);
 
 #if DEBUG_LEVEL >= 2
+	for (const CalendarEntry *entry : possibleCurrentEvents)
+	{
+		Serial.printf("[verbose] Event %s happening right now\n", entry->getTitle().c_str());
+	}
 	Serial.printf("[verbose] Found %d events happening right now\n", possibleCurrentEvents.size());
 #endif
 
@@ -191,17 +378,14 @@ const CalendarEntry *CalendarClient::getCurrentEvent(time_t now, bool nowClosest
 	case 0:
 		return NULL;
 	case 1:
-		CalendarEntry *currentEntry = new CalendarEntry();
-		*currentEntry = possibleCurrentEvents.at(0);
-		return currentEntry;
+		return possibleCurrentEvents.at(0);
 	}
 
 	// Now lets try to find the one that starts closest to now
-	CalendarEntry *closest = new CalendarEntry();
+	const CalendarEntry *closest = possibleCurrentEvents.at(0);
 	time_t closestDelta = LONG_MAX;
 
-	// start from ++begin() in order to skip the first one
-	for (CalendarEntries::const_iterator it = possibleCurrentEvents.begin(); it != possibleCurrentEvents.end(); it++)
+	for (const CalendarEntry *it : possibleCurrentEvents)
 	{
 		time_t delta = difftime(nowClosestToStart ? now : it->getEnd(), nowClosestToStart ? it->getStart() : now);
 
@@ -215,7 +399,7 @@ const CalendarEntry *CalendarClient::getCurrentEvent(time_t now, bool nowClosest
 #if DEBUG_LEVEL >= 2
 			Serial.printf(" which has the same delta to now than the previous event %s (delta=%ld) but is marked important", closest->getTitle().c_str(), closestDelta);
 #endif
-			*closest = *it;
+			closest = it;
 		}
 		else if (delta < closestDelta)
 		{
@@ -223,7 +407,7 @@ const CalendarEntry *CalendarClient::getCurrentEvent(time_t now, bool nowClosest
 			Serial.printf(" which is closer to now than the previous event %s (delta=%ld)", closest->getTitle().c_str(), closestDelta);
 #endif
 			closestDelta = delta;
-			*closest = *it;
+			closest = it;
 		}
 #if DEBUG_LEVEL >= 2
 		else
@@ -237,21 +421,140 @@ const CalendarEntry *CalendarClient::getCurrentEvent(time_t now, bool nowClosest
 	return closest;
 }
 
-const CalendarEntry *CalendarClient::getNextEvent(time_t now) const
+void CalendarClient::updateOccupancy(const CalendarEntries &entries, time_t now)
+{
+	for (int i = 0; i < OCCUPANCY_DAYS; i++)
+	{
+		occupancy[i].build(entries, DayOccupancy::startOfDay(now, i));
+	}
+	occupancyLoaded = true;
+	RtcStore::save<rtc_record::Occupancy>(occupancy);
+}
+
+const DayOccupancy *CalendarClient::getOccupancy(time_t t)
 {
-	// Since we know that events are sorted, we can just return the first meeting that starts
-	// after the now
-	for (CalendarEntries::const_iterator it = entries.begin(); it != entries.end(); it++)
+	if (!occupancyLoaded)
 	{
-		if (it->getStart() > now)
+		if (!RtcStore::load<rtc_record::Occupancy>(occupancy))
 		{
-			return &(*it);
+			memset(occupancy, 0, sizeof(occupancy));
 		}
+		occupancyLoaded = true;
 	}
 
+	for (int i = 0; i < OCCUPANCY_DAYS; i++)
+	{
+		if (occupancy[i].contains(t))
+		{
+			return &occupancy[i];
+		}
+	}
 	return NULL;
 }
 
+bool CalendarClient::saveCalendar() const
+{
+	Journal &journal = Journal::shared();
+	if (!journal.isOpen())
+	{
+		return false;
+	}
+
+#ifdef MULTI_ROOM
+	for (size_t i = 0; i < roomStores.size(); i++)
+	{
+		const char *name = roomSummaries[i].name;
+		if (!roomStores[i]->save(journal) || !journal.put(roomNameKey(i), name, strlen(name) + 1))
+		{
+			return false;
+		}
+	}
+	return !roomStores.empty();
+#else
+	return store.save(journal);
+#endif
+}
+
+bool CalendarClient::loadCalendar()
+{
+	Journal &journal = Journal::shared();
+	if (!journal.isOpen())
+	{
+		return false;
+	}
+
+#ifdef MULTI_ROOM
+	// the summaries are made again for now, the names are the ones the
+	// server sent on the last sync
+	time_t now = time(NULL);
+	createRooms();
+	for (size_t i = 0; i < roomCount; i++)
+	{
+		size_t len = 0;
+		const char *name = (const char *)journal.get(roomNameKey(i), len);
+		if (!roomStores[i]->load(journal, now) || name == NULL || len == 0 || name[len - 1] != '\0')
+		{
+			return false;
+		}
+		roomSummaries[i].update(name, roomStores[i]->snapshot().index, now);
+	}
+
+#if DEBUG_LEVEL >= 1
+	Serial.printf("[debug] rooms: %d (kept)\n", roomCount);
+#endif
+	return true;
+#else
+	if (!store.load(journal, time(NULL)))
+	{
+		return false;
+	}
+
+	// the days of the occupancy may have rolled over since the last sync
+	updateOccupancy(*getCalendarEntries(), time(NULL));
+
+#if DEBUG_LEVEL >= 1
+	Serial.printf("[debug] calendar_events: %d (kept)\n", getCalendarEntries()->size());
+#endif
+	return true;
+#endif
+}
+
+const SyncState *CalendarClient::getLastSync()
+{
+	if (!lastSyncLoaded)
+	{
+		lastSyncValid = RtcStore::load<rtc_record::Sync>(lastSync);
+		lastSyncLoaded = true;
+	}
+	return lastSyncValid ? &lastSync : NULL;
+}
+
+void CalendarClient::setSynced(time_t now, int rssi)
+{
+	lastSync.time = now;
+	lastSync.rssi = rssi;
+	lastSyncLoaded = true;
+	lastSyncValid = true;
+	RtcStore::save<rtc_record::Sync>(lastSync);
+}
+
+bool CalendarClient::isSyncDue(time_t now)
+{
+	const SyncState *last = getLastSync();
+
+	// the clock went back, or the days fetched then are over
+	if (last == NULL || now < last->time || now >= DayOccupancy::startOfDay(last->time, CALENDAR_WINDOW_DAYS))
+	{
+		return true;
+	}
+	return now - last->time >= CALENDAR_SYNC_INTERVAL * 60L;
+}
+
+const CalendarEntry *CalendarClient::getNextEvent(time_t now) const
+{
+	return getIndex().nextStart(now);
+}
+
 bool CalendarClient::parseCustomStatus(HTTPClient &client)
 {
 	JsonDocument doc;
@@ -272,47 +575,131 @@ bool CalendarClient::parseCustomStatus(HTTPClient &client)
 	customStatus = new CustomStatus(doc.as<JsonObject>());
 
 #if DEBUG_LEVEL >= 1
-	Serial.printf("[debug] lastUpdated: %ld\n", last_updated);
+	Serial.printf("[debug] lastUpdated: %ld\n", getLastUpdated());
 #endif
 
 #if DEBUG_LEVEL >= 1
-	Serial.printf("[debug] calendar_events: %d\n", entries.size());
+	Serial.printf("[debug] calendar_events: %d\n", getCalendarEntries()->size());
 #endif
 
 	return true;
 }
 
-bool CalendarClient::parseCalendar(HTTPClient &client)
+// The entries of every response arrive sorted by start. They are merged
+// through a heap that holds the next entry of each response, so memory is
+// taken up by the merged calendar only, not by the responses.
+bool CalendarClient::parseCalendars(HTTPClient *http, size_t count)
 {
-	JsonDocument doc;
-	DeserializationError error = deserializeJson(doc, client.getStream());
+	std::vector<Stream *> streams;
+	for (size_t i = 0; i < count; i++)
+	{
+		streams.push_back(&http[i].getStream());
+	}
+
+	// filled aside and only published once complete, so a failed attempt
+	// leaves nothing behind for the next one. Duplicates, such as an event
+	// in two of the calendars, are dropped by publish().
+	CalendarSnapshot &next = store.prepare();
+	if (!EntryReader::merge(streams.data(), count, next))
+	{
+		return false;
+	}
 
 #if DEBUG_LEVEL >= 1
-	Serial.println("[debug] doc.overflowed() : " + String(doc.overflowed()));
+	Serial.printf("[debug] lastUpdated: %ld\n", next.lastUpdated);
 #endif
-#if DEBUG_LEVEL >= 2
-	serializeJsonPretty(doc, Serial);
+
+	store.publish(time(NULL));
+	updateOccupancy(*getCalendarEntries(), time(NULL));
+
+#if DEBUG_LEVEL >= 1
+	Serial.printf("[debug] calendar_events: %d\n", getCalendarEntries()->size());
 #endif
 
-	if (error)
+	return true;
+}
+
+// A store per room, whose calendar names its keys in the journal
+void CalendarClient::createRooms()
+{
+	if (roomStores.empty())
 	{
-		return false;
+		for (size_t i = 0; i < roomCount; i++)
+		{
+			roomStores.push_back(new CalendarStore(roomCalendars[i]));
+		}
+		roomSummaries.resize(roomCount);
+	}
+}
+
+// The response holds a calendar per room:
+// {"last_updated": ..., "rooms": [{"calendar": "room_a", "name": "Room A", "entries": [...]}, ...]}
+bool CalendarClient::parseRooms(HTTPClient &client, time_t now)
+{
+	// only what the summaries need is kept of the response
+	JsonDocument filter;
+	filter["last_updated"] = true;
+	filter["rooms"][0]["calendar"] = true;
+	filter["rooms"][0]["name"] = true;
+	const char *fields[] = {"id", "title", "start", "end", "all_day", "busy", "important", "rrule", "exdate"};
+	for (const char *field : fields)
+	{
+		filter["rooms"][0]["entries"][0][field] = true;
 	}
 
-	last_updated = doc["last_updated"].as<time_t>();
+	JsonDocument doc;
+	DeserializationError error = deserializeJson(doc, client.getStream(), DeserializationOption::Filter(filter));
 
 #if DEBUG_LEVEL >= 1
-	Serial.printf("[debug] lastUpdated: %ld\n", last_updated);
+	Serial.println("[debug] doc.overflowed() : " + String(doc.overflowed()));
 #endif
 
-	for (JsonObject entry : doc["entries"].as<JsonArray>())
+	if (error)
 	{
-		entries.push_back(CalendarEntry(entry));
+		return false;
 	}
 
+	// every room has to be in the response, before any of them is replaced
+	JsonArray rooms = doc["rooms"].as<JsonArray>();
+	std::vector<JsonObject> found(roomCount);
+	for (size_t i = 0; i < roomCount; i++)
+	{
+		for (JsonObject candidate : rooms)
+		{
+			if (candidate["calendar"].is<const char *>() && strcmp(candidate["calendar"].as<const char *>(), roomCalendars[i]) == 0)
+			{
+				found[i] = candidate;
+				break;
+			}
+		}
+
+		if (found[i].isNull())
+		{
+			Serial.printf("[error]: room %s is missing in the response\n", roomCalendars[i]);
+			return false;
+		}
+	}
+
+	createRooms();
+
+	for (size_t i = 0; i < roomCount; i++)
+	{
+		JsonObject room = found[i];
+		CalendarSnapshot &next = roomStores[i]->prepare();
+		next.lastUpdated = doc["last_updated"].as<time_t>();
+		for (JsonObject entry : room["entries"].as<JsonArray>())
+		{
+			next.entries.push_back(CalendarEntry(entry));
+		}
+		roomStores[i]->publish(now);
+
+		const char *name = room["name"].is<const char *>() ? room["name"].as<const char *>() : roomCalendars[i];
+		roomSummaries[i].update(name, roomStores[i]->snapshot().index, now);
+
 #if DEBUG_LEVEL >= 1
-	Serial.printf("[debug] calendar_events: %d\n", entries.size());
+		Serial.printf("[debug] room %s: %d events\n", name, roomStores[i]->snapshot().entries.size());
 #endif
+	}
 
 	return true;
 }
@@ -0,0 +1,203 @@
+#include <string.h>
+
+#include "client/calendar_entry.h"
+
+using namespace calendar_client;
+
+template <typename T>
+static void putValue(std::vector<uint8_t> &out, T value)
+{
+	out.insert(out.end(), (const uint8_t *)&value, (const uint8_t *)&value + sizeof(T));
+}
+
+template <typename T>
+static bool getValue(const uint8_t *&data, const uint8_t *limit, T &value)
+{
+	if (limit - data < (ptrdiff_t)sizeof(T))
+	{
+		return false;
+	}
+	memcpy(&value, data, sizeof(T));
+	data += sizeof(T);
+	return true;
+}
+
+// strings are kept as their length followed by the bytes
+static void putString(std::vector<uint8_t> &out, const String &s)
+{
+	uint16_t length = s.length() > UINT16_MAX ? UINT16_MAX : s.length();
+	putValue(out, length);
+	out.insert(out.end(), (const uint8_t *)s.c_str(), (const uint8_t *)s.c_str() + length);
+}
+
+static bool getString(const uint8_t *&data, const uint8_t *limit, String &s)
+{
+	uint16_t length;
+	if (!getValue(data, limit, length) || limit - data < length)
+	{
+		return false;
+	}
+	s = String();
+	s.concat((const char *)data, length);
+	data += length;
+	return true;
+}
+
+// members missing in the JSON keep their defaults
+CalendarEntry::CalendarEntry(const JsonObject &json) : CalendarEntry()
+{
+	if (json["id"].is<const char *>())
+	{
+		id = String(json["id"].as<const char *>());
+	}
+
+	if (json["title"].is<const char *>())
+	{
+		title = String(json["title"].as<const char *>());
+	}
+
+	if (json["message"].is<const char *>())
+	{
+		message = String(json["message"].as<const char *>());
+	}
+
+	if (json["start"].is<time_t>())
+	{
+		start = json["start"].as<time_t>();
+	}
+
+	if (json["end"].is<time_t>())
+	{
+		end = json["end"].as<time_t>();
+	}
+
+	if (json["all_day"].is<bool>())
+	{
+		all_day = json["all_day"].as<bool>();
+	}
+
+	if (json["busy"].is<BusyState>())
+	{
+		busy = json["busy"].as<BusyState>();
+	}
+	else
+	{
+		busy = BusyState::Free;
+	}
+
+	if (json["important"].is<bool>())
+	{
+		important = json["important"].as<bool>();
+	}
+	else
+	{
+		important = false;
+	}
+
+	instance = false;
+
+	// a series sent as its first instance, its RRULE and EXDATEs. If the
+	// rule can not be expanded, at least the first instance is shown.
+	if (json["rrule"].is<const char *>())
+	{
+		if (!recurrence.parse(json["rrule"].as<const char *>()))
+		{
+			Serial.printf("[error]: unsupported recurrence of %s: %s\n", title.c_str(), json["rrule"].as<const char *>());
+		}
+		for (JsonVariant exdate : json["exdate"].as<JsonArray>())
+		{
+			recurrence.addException(exdate.as<time_t>());
+		}
+	}
+}
+
+CalendarEntry CalendarEntry::instanceAt(time_t start) const
+{
+	CalendarEntry entry;
+	entry.id = id;
+	entry.title = title;
+	entry.start = start;
+	entry.end = start + (end - start);
+	entry.all_day = all_day;
+	entry.busy = busy;
+	entry.important = important;
+	entry.message = message;
+	entry.instance = true;
+	return entry;
+}
+
+void CalendarEntry::write(std::vector<uint8_t> &out) const
+{
+	putValue<int64_t>(out, start);
+	putValue<int64_t>(out, end);
+	putValue<uint8_t>(out, (all_day ? 1 : 0) | (important ? 2 : 0) | (recurrence.isRecurring() ? 4 : 0));
+	putValue<uint8_t>(out, busy);
+	putString(out, id);
+	putString(out, title);
+	putString(out, message);
+
+	if (recurrence.isRecurring())
+	{
+		putValue<uint8_t>(out, recurrence.frequency);
+		putValue<uint8_t>(out, recurrence.byDay);
+		putValue<uint16_t>(out, recurrence.interval);
+		putValue<uint32_t>(out, recurrence.count);
+		putValue<int64_t>(out, recurrence.until);
+		putValue<uint16_t>(out, recurrence.exceptions.size());
+		for (time_t exception : recurrence.exceptions)
+		{
+			putValue<int64_t>(out, exception);
+		}
+	}
+}
+
+bool CalendarEntry::read(const uint8_t *&data, const uint8_t *limit)
+{
+	int64_t startTime, endTime;
+	uint8_t flags, busyState;
+	if (!getValue(data, limit, startTime) || !getValue(data, limit, endTime) ||
+		!getValue(data, limit, flags) || !getValue(data, limit, busyState))
+	{
+		return false;
+	}
+
+	start = startTime;
+	end = endTime;
+	all_day = flags & 1;
+	important = flags & 2;
+	busy = static_cast<BusyState>(busyState);
+	instance = false;
+
+	if (!getString(data, limit, id) || !getString(data, limit, title) || !getString(data, limit, message))
+	{
+		return false;
+	}
+
+	recurrence = Recurrence();
+	if (flags & 4)
+	{
+		uint8_t frequency;
+		int64_t until;
+		uint16_t exceptions;
+		if (!getValue(data, limit, frequency) || !getValue(data, limit, recurrence.byDay) ||
+			!getValue(data, limit, recurrence.interval) || !getValue(data, limit, recurrence.count) ||
+			!getValue(data, limit, until) || !getValue(data, limit, exceptions))
+		{
+			return false;
+		}
+		recurrence.frequency = static_cast<Recurrence::Frequency>(frequency);
+		recurrence.until = until;
+
+		recurrence.exceptions.resize(exceptions);
+		for (time_t &exception : recurrence.exceptions)
+		{
+			int64_t value;
+			if (!getValue(data, limit, value))
+			{
+				return false;
+			}
+			exception = value;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <stdint.h>
+
+#include "client/calendar_entry.h"
+#include "client/calendar_index.h"
+
+using namespace calendar_client;
+
+void CalendarIndex::clear()
+{
+	byStart.clear();
+	starts.clear();
+	maxEnd.clear();
+	blocks.clear();
+	gapTree.clear();
+	gapLeaves = 0;
+}
+
+void CalendarIndex::build(const std::vector<CalendarEntry> &entries)
+{
+	clear();
+
+	for (const CalendarEntry &entry : entries)
+	{
+		byStart.push_back(&entry);
+	}
+	std::stable_sort(byStart.begin(), byStart.end(), [](const CalendarEntry *a, const CalendarEntry *b)
+					 { return a->getStart() < b->getStart(); });
+
+	for (const CalendarEntry *entry : byStart)
+	{
+		starts.push_back(entry->getStart());
+	}
+	maxEnd.resize(byStart.size());
+	buildMaxEnd(0, byStart.size());
+
+	for (const CalendarEntry *entry : byStart)
+	{
+		if (entry->getEnd() <= entry->getStart() || !entry->takesUpRoom())
+		{
+			continue;
+		}
+		if (!blocks.empty() && entry->getStart() <= blocks.back().end)
+		{
+			blocks.back().end = std::max(blocks.back().end, entry->getEnd());
+		}
+		else
+		{
+			blocks.push_back({entry->getStart(), entry->getEnd()});
+		}
+	}
+
+	gapLeaves = 1;
+	while (gapLeaves < blocks.size())
+	{
+		gapLeaves *= 2;
+	}
+	gapTree.assign(2 * gapLeaves, 0);
+	for (size_t i = 0; i < blocks.size(); i++)
+	{
+		gapTree[gapLeaves + i] = gap(i);
+	}
+	for (size_t i = gapLeaves - 1; i >= 1; i--)
+	{
+		gapTree[i] = std::max(gapTree[2 * i], gapTree[2 * i + 1]);
+	}
+}
+
+time_t CalendarIndex::buildMaxEnd(size_t lo, size_t hi)
+{
+	if (lo >= hi)
+	{
+		return LONG_MIN;
+	}
+
+	size_t mid = (lo + hi) / 2;
+	time_t end = byStart[mid]->getEnd();
+	end = std::max(end, buildMaxEnd(lo, mid));
+	end = std::max(end, buildMaxEnd(mid + 1, hi));
+	maxEnd[mid] = end;
+	return end;
+}
+
+void CalendarIndex::collect(size_t lo, size_t hi, time_t t0, time_t t1, std::vector<const CalendarEntry *> &out) const
+{
+	if (lo >= hi)
+	{
+		return;
+	}
+
+	// nothing in this subtree lasts until t0
+	size_t mid = (lo + hi) / 2;
+	if (maxEnd[mid] <= t0)
+	{
+		return;
+	}
+
+	collect(lo, mid, t0, t1, out);
+
+	// neither this entry nor the ones after it start before t1
+	if (starts[mid] >= t1)
+	{
+		return;
+	}
+
+	if (byStart[mid]->getEnd() > t0)
+	{
+		out.push_back(byStart[mid]);
+	}
+
+	collect(mid + 1, hi, t0, t1, out);
+}
+
+void CalendarIndex::eventsIn(time_t t0, time_t t1, std::vector<const CalendarEntry *> &out) const
+{
+	collect(0, byStart.size(), t0, t1, out);
+}
+
+const CalendarEntry *CalendarIndex::nextStart(time_t t) const
+{
+	size_t i = std::upper_bound(starts.begin(), starts.end(), t) - starts.begin();
+	return i < byStart.size() ? byStart[i] : NULL;
+}
+
+long CalendarIndex::blockAt(time_t t) const
+{
+	std::vector<Block>::const_iterator it = std::upper_bound(blocks.begin(), blocks.end(), t, [](time_t value, const Block &block)
+															 { return value < block.start; });
+	return (long)(it - blocks.begin()) - 1;
+}
+
+// length of the free time after a block, the last one is followed by no end
+time_t CalendarIndex::gap(size_t block) const
+{
+	return block + 1 < blocks.size() ? blocks[block + 1].start - blocks[block].end : LONG_MAX;
+}
+
+// the first block >= from followed by a gap of at least length, or SIZE_MAX
+size_t CalendarIndex::firstGap(size_t node, size_t lo, size_t hi, size_t from, time_t length) const
+{
+	if (hi <= from || gapTree[node] < length)
+	{
+		return SIZE_MAX;
+	}
+	if (hi - lo == 1)
+	{
+		return lo;
+	}
+
+	size_t mid = (lo + hi) / 2;
+	size_t found = firstGap(2 * node, lo, mid, from, length);
+	return found != SIZE_MAX ? found : firstGap(2 * node + 1, mid, hi, from, length);
+}
+
+time_t CalendarIndex::freeUntil(time_t t) const
+{
+	long b = blockAt(t);
+	if (b >= 0 && blocks[b].end > t)
+	{
+		return t;
+	}
+	return (size_t)(b + 1) < blocks.size() ? blocks[b + 1].start : LONG_MAX;
+}
+
+time_t CalendarIndex::nextFreeSlot(time_t t, time_t minDuration) const
+{
+	long b = blockAt(t);
+	time_t from = b >= 0 && blocks[b].end > t ? blocks[b].end : t;
+
+	size_t next = b + 1;
+	time_t until = next < blocks.size() ? blocks[next].start : LONG_MAX;
+	if (until == LONG_MAX || until - from >= minDuration)
+	{
+		return from;
+	}
+
+	// the gap after the last block never ends, so there always is one
+	return blocks[firstGap(1, 0, gapLeaves, next, minDuration)].end;
+}
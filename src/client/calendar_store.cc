@@ -0,0 +1,313 @@
+#include <algorithm>
+#include <iterator>
+
+#include "client/calendar_entry.h"
+#include "client/calendar_store.h"
+#include "client/occupancy.h"
+#include "config.h"
+#include "journal.h"
+
+using namespace calendar_client;
+
+// In the journal, a snapshot is kept as its serialized form cut into chunks.
+// Every save puts the chunks under the keys of a new generation, and only
+// then the head, which names the generation in use, so the previous
+// snapshot stays readable until the new one is complete. The keys are in the
+// space of the store.
+
+static const uint32_t FormatVersion = 2;
+static const size_t ChunkSize = 2048;
+static const size_t MaxChunks = 255;
+
+struct SavedHead
+{
+	uint32_t version;
+	uint32_t generation;
+	uint32_t chunks;
+	uint32_t length;
+};
+
+// followed by the entries, see CalendarEntry::write()
+struct SavedSnapshot
+{
+	int64_t lastUpdated;
+	uint32_t count;
+	uint32_t reserved;
+};
+
+static uint32_t headKey(const char *space)
+{
+	return Journal::key(space, 0);
+}
+
+static uint32_t chunkKey(const char *space, uint32_t generation, size_t chunk)
+{
+	return Journal::key(space, (generation << 8) | (chunk + 1));
+}
+
+static bool readHead(const Journal &journal, const char *space, SavedHead &head)
+{
+	size_t len = 0;
+	const uint8_t *stored = journal.get(headKey(space), len);
+	if (stored == NULL || len != sizeof(SavedHead))
+	{
+		return false;
+	}
+	memcpy(&head, stored, sizeof(SavedHead));
+	return head.version == FormatVersion;
+}
+
+// Entries with the same id are the same event, unless they start at
+// different times (instances of a recurring event). Without ids, the
+// title and times have to match.
+static bool sameEvent(const CalendarEntry &a, const CalendarEntry &b)
+{
+	if (a.getStart() != b.getStart())
+	{
+		return false;
+	}
+	if (!a.getId().isEmpty() || !b.getId().isEmpty())
+	{
+		return a.getId() == b.getId();
+	}
+	return a.getEnd() == b.getEnd() && a.getTitle() == b.getTitle();
+}
+
+static bool startsBefore(const CalendarEntry &a, const CalendarEntry &b)
+{
+	return a.getStart() < b.getStart();
+}
+
+CalendarSnapshot::CalendarSnapshot() : lastUpdated(0)
+{
+}
+
+CalendarStore::CalendarStore(const char *space) : current(&slots[0]), back(&slots[1]), space(space)
+{
+}
+
+CalendarSnapshot &CalendarStore::prepare()
+{
+	back->lastUpdated = 0;
+	back->entries.clear();
+	back->series.clear();
+	back->index.clear();
+	return *back;
+}
+
+void CalendarStore::check(CalendarSnapshot &snapshot) const
+{
+	CalendarEntries &entries = snapshot.entries;
+
+	// the components rely on the entries being in order
+	if (!std::is_sorted(entries.begin(), entries.end(), startsBefore))
+	{
+		Serial.printf("[error]: calendar entries are not sorted by start\n");
+		std::stable_sort(entries.begin(), entries.end(), startsBefore);
+	}
+
+	CalendarEntries::iterator out = entries.begin();
+	for (CalendarEntries::iterator it = entries.begin(); it != entries.end(); it++)
+	{
+		if (it->getEnd() < it->getStart())
+		{
+			Serial.printf("[error]: calendar entry %s ends before it starts\n", it->getTitle().c_str());
+			continue;
+		}
+
+		// duplicates start at the same time, so only the entries kept since
+		// the last change of the start need to be compared
+		bool duplicate = false;
+		for (CalendarEntries::iterator prev = out; prev != entries.begin() && (prev - 1)->getStart() == it->getStart(); prev--)
+		{
+			if (sameEvent(*(prev - 1), *it))
+			{
+				duplicate = true;
+				break;
+			}
+		}
+		if (duplicate)
+		{
+#if DEBUG_LEVEL >= 1
+			Serial.printf("[debug] dropping duplicate calendar entry %s\n", it->getTitle().c_str());
+#endif
+			continue;
+		}
+
+		if (out != it)
+		{
+			*out = std::move(*it);
+		}
+		out++;
+	}
+	entries.erase(out, entries.end());
+}
+
+// Moves the series out of the entries and puts their instances within the
+// window in their place, merged in by start.
+void CalendarStore::expand(CalendarSnapshot &snapshot, time_t now) const
+{
+	CalendarEntries &entries = snapshot.entries;
+	CalendarEntries::iterator series = std::stable_partition(entries.begin(), entries.end(), [](const CalendarEntry &entry)
+															 { return !entry.getRecurrence().isRecurring(); });
+	std::move(series, entries.end(), std::back_inserter(snapshot.series));
+	entries.erase(series, entries.end());
+	if (snapshot.series.empty())
+	{
+		return;
+	}
+
+	time_t from = DayOccupancy::startOfDay(now);
+	time_t to = DayOccupancy::startOfDay(now, CALENDAR_WINDOW_DAYS);
+	size_t singles = entries.size();
+	for (const CalendarEntry &entry : snapshot.series)
+	{
+		// the instances that are still going on at from count as well
+		time_t duration = entry.getEnd() - entry.getStart();
+		Recurrence::Iterator it(entry.getRecurrence(), entry.getStart(), from - duration, to);
+		time_t start;
+		while (it.next(start))
+		{
+			entries.push_back(entry.instanceAt(start));
+		}
+	}
+
+#if DEBUG_LEVEL >= 1
+	Serial.printf("[debug] expanded %d series into %d instances\n", (int)snapshot.series.size(), (int)(entries.size() - singles));
+#endif
+
+	std::stable_sort(entries.begin() + singles, entries.end(), startsBefore);
+	std::inplace_merge(entries.begin(), entries.begin() + singles, entries.end(), startsBefore);
+}
+
+void CalendarStore::publish(time_t now)
+{
+	expand(*back, now);
+	check(*back);
+	back->index.build(back->entries);
+
+	CalendarSnapshot *published = back;
+	back = const_cast<CalendarSnapshot *>(current.load(std::memory_order_relaxed));
+	current.store(published, std::memory_order_release);
+}
+
+bool CalendarStore::save(Journal &journal) const
+{
+	const CalendarSnapshot &published = snapshot();
+
+	SavedSnapshot saved = {};
+	saved.lastUpdated = published.lastUpdated;
+	saved.count = published.series.size();
+
+	// the instances are expanded again on load, for the days from then on
+	std::vector<uint8_t> data((const uint8_t *)&saved, (const uint8_t *)&saved + sizeof(saved));
+	for (const CalendarEntry &entry : published.entries)
+	{
+		if (!entry.isInstance())
+		{
+			entry.write(data);
+			saved.count++;
+		}
+	}
+	for (const CalendarEntry &entry : published.series)
+	{
+		entry.write(data);
+	}
+	memcpy(data.data(), &saved, sizeof(saved));
+
+	SavedHead head = {FormatVersion, 0, (uint32_t)((data.size() + ChunkSize - 1) / ChunkSize), (uint32_t)data.size()};
+	if (head.chunks > MaxChunks)
+	{
+		Serial.printf("[error]: calendar of %d bytes is too large to be kept\n", (int)data.size());
+		return false;
+	}
+
+	SavedHead old;
+	bool hasOld = readHead(journal, space, old);
+	head.generation = hasOld ? old.generation + 1 : 0;
+
+	for (size_t i = 0; i < head.chunks; i++)
+	{
+		size_t offset = i * ChunkSize;
+		if (!journal.put(chunkKey(space, head.generation, i), data.data() + offset, std::min(ChunkSize, data.size() - offset)))
+		{
+			return false;
+		}
+	}
+	if (!journal.put(headKey(space), &head, sizeof(head)))
+	{
+		return false;
+	}
+
+	if (hasOld)
+	{
+		for (size_t i = 0; i < old.chunks; i++)
+		{
+			journal.remove(chunkKey(space, old.generation, i));
+		}
+	}
+	// left over from a save of this generation that was cut short
+	size_t len = 0;
+	for (size_t i = head.chunks; i < MaxChunks && journal.get(chunkKey(space, head.generation, i), len) != NULL; i++)
+	{
+		journal.remove(chunkKey(space, head.generation, i));
+	}
+
+#if DEBUG_LEVEL >= 1
+	Serial.printf("[debug] kept calendar of %d entries in %d bytes\n", saved.count, (int)data.size());
+#endif
+	return true;
+}
+
+bool CalendarStore::load(Journal &journal, time_t now)
+{
+	SavedHead head;
+	if (!readHead(journal, space, head))
+	{
+		return false;
+	}
+
+	// copied out, the chunks are only valid until the journal is written
+	std::vector<uint8_t> data;
+	data.reserve(head.length);
+	for (size_t i = 0; i < head.chunks; i++)
+	{
+		size_t len = 0;
+		const uint8_t *chunk = journal.get(chunkKey(space, head.generation, i), len);
+		if (chunk == NULL)
+		{
+			Serial.printf("[error]: kept calendar is missing chunk %d\n", (int)i);
+			return false;
+		}
+		data.insert(data.end(), chunk, chunk + len);
+	}
+
+	SavedSnapshot saved;
+	if (data.size() != head.length || data.size() < sizeof(saved))
+	{
+		Serial.printf("[error]: kept calendar has %d bytes, expected %d\n", (int)data.size(), head.length);
+		return false;
+	}
+	memcpy(&saved, data.data(), sizeof(saved));
+
+	// like a parse, nothing becomes visible unless all entries are read
+	CalendarSnapshot &next = prepare();
+	next.lastUpdated = saved.lastUpdated;
+	next.entries.reserve(saved.count);
+
+	const uint8_t *p = data.data() + sizeof(saved);
+	const uint8_t *limit = data.data() + data.size();
+	for (uint32_t i = 0; i < saved.count; i++)
+	{
+		CalendarEntry entry;
+		if (!entry.read(p, limit))
+		{
+			Serial.printf("[error]: kept calendar entry %d is cut short\n", i);
+			return false;
+		}
+		next.entries.push_back(std::move(entry));
+	}
+	publish(now);
+
+	return true;
+}
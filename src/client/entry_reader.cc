@@ -0,0 +1,281 @@
+#include "client/entry_reader.h"
+
+#include <algorithm>
+
+#include "config.h"
+
+using namespace calendar_client;
+
+bool EntryReader::fail()
+{
+	error = true;
+	state = Done;
+	return false;
+}
+
+// The next character (that is not whitespace), left in the stream. -1 if
+// nothing arrives within the timeout of the stream.
+int EntryReader::peekToken(bool skipWhitespace)
+{
+	unsigned long deadline = millis() + stream->getTimeout();
+	for (;;)
+	{
+		if (stream->available() > 0)
+		{
+			int c = stream->peek();
+			if (!skipWhitespace || (c != ' ' && c != '\t' && c != '\r' && c != '\n'))
+			{
+				return c;
+			}
+			stream->read();
+		}
+		else if (millis() >= deadline)
+		{
+			return -1;
+		}
+		else
+		{
+			delay(1);
+		}
+	}
+}
+
+bool EntryReader::expect(char c)
+{
+	if (peekToken() != c)
+	{
+		return false;
+	}
+	stream->read();
+	return true;
+}
+
+bool EntryReader::readString(String &s)
+{
+	if (!expect('"'))
+	{
+		return false;
+	}
+
+	s = "";
+	char c;
+	while (stream->readBytes(&c, 1) == 1)
+	{
+		if (c == '"')
+		{
+			return true;
+		}
+		// the keys of interest have no escapes, others only need to be skipped
+		if (c == '\\' && stream->readBytes(&c, 1) != 1)
+		{
+			return false;
+		}
+		s += c;
+	}
+	return false;
+}
+
+// ArduinoJson would take the character after a number as well, which may be
+// the end of the object, so numbers are read here
+bool EntryReader::readNumber(time_t &value)
+{
+	int c = peekToken();
+	bool negative = c == '-';
+	if (negative)
+	{
+		stream->read();
+		c = peekToken(false);
+	}
+	if (c < '0' || c > '9')
+	{
+		return false;
+	}
+
+	value = 0;
+	while (c >= '0' && c <= '9')
+	{
+		value = value * 10 + (c - '0');
+		stream->read();
+		c = peekToken(false);
+	}
+	// fractions and exponents are not expected, but skipped
+	while (c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-' || (c >= '0' && c <= '9'))
+	{
+		stream->read();
+		c = peekToken(false);
+	}
+	if (negative)
+	{
+		value = -value;
+	}
+	return true;
+}
+
+bool EntryReader::skipValue()
+{
+	int c = peekToken();
+	if (c == '-' || (c >= '0' && c <= '9'))
+	{
+		time_t ignored;
+		return readNumber(ignored);
+	}
+
+	// everything else ends with its last character
+	JsonDocument doc;
+	return !deserializeJson(doc, *stream);
+}
+
+// Reads the members of the top level object up to the start of the entries
+// (true) or up to its end (false).
+bool EntryReader::seekEntries()
+{
+	for (;;)
+	{
+		int c = peekToken();
+		if (c == ',')
+		{
+			stream->read();
+			continue;
+		}
+		if (c == '}')
+		{
+			stream->read();
+			return false;
+		}
+
+		String key;
+		if (!readString(key) || !expect(':'))
+		{
+			return fail();
+		}
+
+		if (key == "entries")
+		{
+			return expect('[') || fail();
+		}
+		else if (key == "last_updated")
+		{
+			if (!readNumber(lastUpdated))
+			{
+				return fail();
+			}
+		}
+		else if (!skipValue())
+		{
+			return fail();
+		}
+	}
+}
+
+bool EntryReader::next(CalendarEntry &entry)
+{
+	if (state == Start)
+	{
+		if (!expect('{'))
+		{
+			return fail();
+		}
+		state = Members;
+	}
+
+	if (state == Members)
+	{
+		if (!seekEntries())
+		{
+			state = Done;
+			return false;
+		}
+		state = Entries;
+	}
+
+	if (state != Entries)
+	{
+		return false;
+	}
+
+	int c = peekToken();
+	if (c == ',')
+	{
+		stream->read();
+		c = peekToken();
+	}
+
+	if (c == ']')
+	{
+		stream->read();
+
+		// the members after the entries
+		if (seekEntries())
+		{
+			return fail();
+		}
+		state = Done;
+		return false;
+	}
+	if (c != '{')
+	{
+		return fail();
+	}
+
+	JsonDocument doc;
+	DeserializationError err = deserializeJson(doc, *stream);
+	if (err)
+	{
+		Serial.printf("[error]: calendar entry: %s\n", err.c_str());
+		return fail();
+	}
+	entry = CalendarEntry(doc.as<JsonObject>());
+	return true;
+}
+
+bool EntryReader::merge(Stream *const streams[], size_t count, CalendarSnapshot &snapshot)
+{
+	struct Head
+	{
+		CalendarEntry entry;
+		size_t source;
+	};
+	// the earliest start on top, the first calendar first on a tie
+	auto later = [](const Head &a, const Head &b)
+	{ return a.entry.getStart() > b.entry.getStart() || (a.entry.getStart() == b.entry.getStart() && a.source > b.source); };
+
+	std::vector<EntryReader> readers;
+	std::vector<Head> heap;
+	for (size_t i = 0; i < count; i++)
+	{
+		readers.push_back(EntryReader(*streams[i]));
+		Head head;
+		head.source = i;
+		if (readers[i].next(head.entry))
+		{
+			heap.push_back(std::move(head));
+			std::push_heap(heap.begin(), heap.end(), later);
+		}
+	}
+
+	while (!heap.empty())
+	{
+		std::pop_heap(heap.begin(), heap.end(), later);
+		Head &head = heap.back();
+		snapshot.entries.push_back(std::move(head.entry));
+
+		if (readers[head.source].next(head.entry))
+		{
+			std::push_heap(heap.begin(), heap.end(), later);
+		}
+		else
+		{
+			heap.pop_back();
+		}
+	}
+
+	for (const EntryReader &reader : readers)
+	{
+		if (reader.failed())
+		{
+			return false;
+		}
+		snapshot.lastUpdated = std::max(snapshot.lastUpdated, reader.getLastUpdated());
+	}
+	return true;
+}
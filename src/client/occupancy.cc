@@ -0,0 +1,126 @@
+#include <string.h>
+
+#include "client/calendar_entry.h"
+#include "client/occupancy.h"
+
+using namespace calendar_client;
+
+void DayOccupancy::build(const std::vector<CalendarEntry> &entries, time_t midnight)
+{
+	this->midnight = midnight;
+	memset(busy, 0, sizeof(busy));
+	memset(tentative, 0, sizeof(tentative));
+	memset(important, 0, sizeof(important));
+
+	time_t dayEnd = midnight + Minutes * 60;
+	for (const CalendarEntry &entry : entries)
+	{
+		if (entry.getEnd() <= midnight || entry.getStart() >= dayEnd)
+		{
+			continue;
+		}
+
+		// any minute the entry touches counts
+		time_t start = entry.getStart() > midnight ? entry.getStart() : midnight;
+		time_t end = entry.getEnd() < dayEnd ? entry.getEnd() : dayEnd;
+		uint16_t from = (start - midnight) / 60;
+		uint16_t to = (end - midnight + 59) / 60;
+
+		if (entry.takesUpRoom())
+		{
+			setRange(entry.getBusy() == BusyState::Busy ? busy : tentative, from, to);
+		}
+		if (entry.isImportant())
+		{
+			setRange(important, from, to);
+		}
+	}
+}
+
+void DayOccupancy::setRange(uint32_t *plane, uint16_t from, uint16_t to)
+{
+	while (from < to)
+	{
+		uint16_t bit = from & 31;
+		uint16_t count = to - from < 32 - bit ? to - from : 32 - bit;
+		uint32_t mask = count == 32 ? ~0u : ((1u << count) - 1) << bit;
+		plane[from >> 5] |= mask;
+		from += count;
+	}
+}
+
+bool DayOccupancy::isOccupied(uint16_t minute) const
+{
+	return minute < Minutes && (occupiedWord(minute >> 5) >> (minute & 31)) & 1;
+}
+
+// the first minute at or after from whose occupied bit equals occupied
+uint16_t DayOccupancy::find(uint16_t from, bool occupied) const
+{
+	if (from >= Minutes)
+	{
+		return Minutes;
+	}
+
+	uint16_t i = from >> 5;
+	uint32_t word = occupied ? occupiedWord(i) : ~occupiedWord(i);
+	word &= ~0u << (from & 31);
+	while (word == 0)
+	{
+		if (++i == Words)
+		{
+			return Minutes;
+		}
+		word = occupied ? occupiedWord(i) : ~occupiedWord(i);
+	}
+	return (i << 5) + __builtin_ctz(word);
+}
+
+uint16_t DayOccupancy::findBit(const uint32_t *plane, uint16_t from, bool set)
+{
+	if (from >= Minutes)
+	{
+		return Minutes;
+	}
+
+	uint16_t i = from >> 5;
+	uint32_t word = (set ? plane[i] : ~plane[i]) & (~0u << (from & 31));
+	while (word == 0)
+	{
+		if (++i == Words)
+		{
+			return Minutes;
+		}
+		word = set ? plane[i] : ~plane[i];
+	}
+	return (i << 5) + __builtin_ctz(word);
+}
+
+uint16_t DayOccupancy::findRun(const uint32_t *plane, uint16_t from, uint16_t &end)
+{
+	uint16_t start = findBit(plane, from, true);
+	end = findBit(plane, start, false);
+	return start;
+}
+
+uint16_t DayOccupancy::freeUntil(uint16_t minute) const
+{
+	return find(minute, true);
+}
+
+uint16_t DayOccupancy::occupiedUntil(uint16_t minute) const
+{
+	return find(minute, false);
+}
+
+time_t DayOccupancy::startOfDay(time_t t, int days)
+{
+	tm info;
+	localtime_r(&t, &info);
+	info.tm_mday += days;
+	info.tm_hour = 0;
+	info.tm_min = 0;
+	info.tm_sec = 0;
+	info.tm_isdst = -1;
+	return mktime(&info);
+}
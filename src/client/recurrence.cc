@@ -0,0 +1,390 @@
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "client/recurrence.h"
+
+using namespace calendar_client;
+
+static const char *weekdayNames[7] = {"MO", "TU", "WE", "TH", "FR", "SA", "SU"};
+
+static int daysInMonth(int year, int month)
+{
+	return month == 12 ? 31 : Recurrence::daysFromCivil(year, month + 1, 1) - Recurrence::daysFromCivil(year, month, 1);
+}
+
+// days since 1970-01-01 of the local date of t
+static long localDay(time_t t)
+{
+	if (t == LONG_MAX)
+	{
+		return LONG_MAX;
+	}
+	tm local = {};
+	localtime_r(&t, &local);
+	return Recurrence::daysFromCivil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+}
+
+// "YYYYMMDD", "YYYYMMDDTHHMMSS" in local time or "YYYYMMDDTHHMMSSZ" in UTC.
+// A date alone includes that whole day.
+static bool parseUntil(const std::string &value, time_t &until)
+{
+	int year, month, day;
+	int hour = 23, minute = 59, second = 59;
+	if (value.size() != 8 && value.size() != 15 && value.size() != 16)
+	{
+		return false;
+	}
+	if (sscanf(value.c_str(), "%4d%2d%2d", &year, &month, &day) != 3)
+	{
+		return false;
+	}
+	if (value.size() > 8 && (value[8] != 'T' || sscanf(value.c_str() + 9, "%2d%2d%2d", &hour, &minute, &second) != 3))
+	{
+		return false;
+	}
+
+	if (value.size() == 16)
+	{
+		if (value[15] != 'Z')
+		{
+			return false;
+		}
+		until = Recurrence::daysFromCivil(year, month, day) * 86400L + hour * 3600L + minute * 60L + second;
+		return true;
+	}
+
+	tm local = {};
+	local.tm_year = year - 1900;
+	local.tm_mon = month - 1;
+	local.tm_mday = day;
+	local.tm_hour = hour;
+	local.tm_min = minute;
+	local.tm_sec = second;
+	local.tm_isdst = -1;
+	until = mktime(&local);
+	return true;
+}
+
+static bool parseByDay(const std::string &value, uint8_t &byDay)
+{
+	byDay = 0;
+	size_t pos = 0;
+	while (pos <= value.size())
+	{
+		size_t end = value.find(',', pos);
+		if (end == std::string::npos)
+		{
+			end = value.size();
+		}
+
+		// ordinals like 1MO or -1FR are not supported
+		std::string name = value.substr(pos, end - pos);
+		const char **found = std::find_if(weekdayNames, weekdayNames + 7, [&name](const char *n)
+										  { return name == n; });
+		if (found == weekdayNames + 7)
+		{
+			return false;
+		}
+		byDay |= 1 << (found - weekdayNames);
+		pos = end + 1;
+	}
+	return byDay != 0;
+}
+
+bool Recurrence::parse(const char *rule)
+{
+	frequency = None;
+
+	Frequency freq = None;
+	uint8_t days = 0;
+	unsigned long every = 1;
+	unsigned long limit = 0;
+	time_t last = LONG_MAX;
+
+	const char *p = rule;
+	while (*p != '\0')
+	{
+		const char *end = strchr(p, ';');
+		if (end == NULL)
+		{
+			end = p + strlen(p);
+		}
+		const char *eq = (const char *)memchr(p, '=', end - p);
+		if (eq == NULL)
+		{
+			return false;
+		}
+		std::string name(p, eq);
+		std::string value(eq + 1, end);
+		p = *end == ';' ? end + 1 : end;
+
+		if (name == "FREQ")
+		{
+			if (value == "DAILY")
+			{
+				freq = Daily;
+			}
+			else if (value == "WEEKLY")
+			{
+				freq = Weekly;
+			}
+			else if (value == "MONTHLY")
+			{
+				freq = Monthly;
+			}
+			else if (value == "YEARLY")
+			{
+				freq = Yearly;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		else if (name == "INTERVAL")
+		{
+			every = strtoul(value.c_str(), NULL, 10);
+			if (every < 1 || every > UINT16_MAX)
+			{
+				return false;
+			}
+		}
+		else if (name == "COUNT")
+		{
+			limit = strtoul(value.c_str(), NULL, 10);
+			if (limit < 1)
+			{
+				return false;
+			}
+		}
+		else if (name == "UNTIL")
+		{
+			if (!parseUntil(value, last))
+			{
+				return false;
+			}
+		}
+		else if (name == "BYDAY")
+		{
+			if (!parseByDay(value, days))
+			{
+				return false;
+			}
+		}
+		else if (name != "WKST" || value != "MO")
+		{
+			return false;
+		}
+	}
+
+	if (freq == None || (days != 0 && freq != Daily && freq != Weekly))
+	{
+		return false;
+	}
+
+	frequency = freq;
+	byDay = days;
+	interval = every;
+	count = limit;
+	until = last;
+	return true;
+}
+
+void Recurrence::addException(time_t start)
+{
+	std::vector<time_t>::iterator it = std::lower_bound(exceptions.begin(), exceptions.end(), start);
+	if (it == exceptions.end() || *it != start)
+	{
+		exceptions.insert(it, start);
+	}
+}
+
+bool Recurrence::isException(time_t start) const
+{
+	return std::binary_search(exceptions.begin(), exceptions.end(), start);
+}
+
+long Recurrence::daysFromCivil(int year, int month, int day)
+{
+	year -= month <= 2;
+	long era = (year >= 0 ? year : year - 399) / 400;
+	unsigned yearOfEra = (unsigned)(year - era * 400);
+	unsigned dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+	unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+	return era * 146097 + (long)dayOfEra - 719468;
+}
+
+void Recurrence::civilFromDays(long days, int &year, int &month, int &day)
+{
+	days += 719468;
+	long era = (days >= 0 ? days : days - 146096) / 146097;
+	unsigned dayOfEra = (unsigned)(days - era * 146097);
+	unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+	unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+	unsigned mp = (5 * dayOfYear + 2) / 153;
+	day = dayOfYear - (153 * mp + 2) / 5 + 1;
+	month = mp < 10 ? mp + 3 : mp - 9;
+	year = (int)(yearOfEra + era * 400) + (month <= 2);
+}
+
+Recurrence::Iterator::Iterator(const Recurrence &rule, time_t first, time_t from, time_t limit)
+	: rule(rule), from(from), limit(limit), period(0), weekday(0), counted(0), done(!rule.isRecurring())
+{
+	localtime_r(&first, &this->first);
+	firstDay = daysFromCivil(this->first.tm_year + 1900, this->first.tm_mon + 1, this->first.tm_mday);
+
+	// a day of margin, the local day of an instance is only known for sure
+	// once its start is computed
+	fromDay = localDay(from) - 1;
+	limitDay = localDay(limit);
+	untilDay = localDay(rule.until);
+
+	if (rule.count == 0)
+	{
+		skipTo(fromDay);
+	}
+}
+
+// Moves period on to the first period that may have an instance on or after
+// day. The periods before it are skipped without counting their instances.
+void Recurrence::Iterator::skipTo(long day)
+{
+	long span; // units of the frequency from the first period to day
+	int year, month, dayOfMonth;
+	civilFromDays(day, year, month, dayOfMonth);
+
+	switch (rule.frequency)
+	{
+	case Daily:
+		span = day - firstDay;
+		break;
+	case Weekly:
+		// the last day of the week of the first instance
+		span = (day - (firstDay - weekdayOf(firstDay) + 6) + 6) / 7;
+		break;
+	case Monthly:
+		span = (year - (first.tm_year + 1900)) * 12L + month - 1 - first.tm_mon;
+		break;
+	case Yearly:
+		span = year - (first.tm_year + 1900);
+		break;
+	default:
+		return;
+	}
+
+	if (span > 0)
+	{
+		period = (span + rule.interval - 1) / rule.interval;
+	}
+}
+
+// The next day an instance may fall on after the rule's frequency,
+// interval and (for weekly rules) weekdays, in order.
+bool Recurrence::Iterator::nextDay(long &day)
+{
+	switch (rule.frequency)
+	{
+	case Daily:
+		day = firstDay + period++ * rule.interval;
+		return true;
+
+	case Weekly:
+	{
+		uint8_t days = rule.byDay != 0 ? rule.byDay : 1 << weekdayOf(firstDay);
+		long monday = firstDay - weekdayOf(firstDay);
+		for (;;)
+		{
+			while (weekday < 7)
+			{
+				long candidate = monday + period * 7 * rule.interval + weekday;
+				if (((days >> weekday++) & 1) && candidate >= firstDay)
+				{
+					day = candidate;
+					return true;
+				}
+			}
+			weekday = 0;
+			period++;
+		}
+	}
+
+	case Monthly:
+	case Yearly:
+		// skips the months that do not have the day of the first instance
+		for (;;)
+		{
+			long months = rule.frequency == Monthly ? first.tm_mon + period++ * rule.interval : first.tm_mon + period++ * rule.interval * 12L;
+			int year = first.tm_year + 1900 + months / 12;
+			int month = months % 12 + 1;
+			if (daysFromCivil(year, month, 1) > limitDay)
+			{
+				return false;
+			}
+			if (first.tm_mday <= daysInMonth(year, month))
+			{
+				day = daysFromCivil(year, month, first.tm_mday);
+				return true;
+			}
+		}
+
+	default:
+		return false;
+	}
+}
+
+time_t Recurrence::Iterator::startOn(long day) const
+{
+	int year, month, dayOfMonth;
+	civilFromDays(day, year, month, dayOfMonth);
+
+	tm local = first;
+	local.tm_year = year - 1900;
+	local.tm_mon = month - 1;
+	local.tm_mday = dayOfMonth;
+	local.tm_isdst = -1;
+	return mktime(&local);
+}
+
+bool Recurrence::Iterator::next(time_t &start)
+{
+	long day;
+	while (!done && nextDay(day))
+	{
+		if (day > limitDay || day > untilDay)
+		{
+			break;
+		}
+		if (rule.frequency == Daily && rule.byDay != 0 && !((rule.byDay >> weekdayOf(day)) & 1))
+		{
+			continue;
+		}
+		if (rule.count != 0 && counted >= rule.count)
+		{
+			break;
+		}
+		counted++;
+
+		if (day < fromDay)
+		{
+			continue;
+		}
+		time_t t = startOn(day);
+		if (t > rule.until || t >= limit)
+		{
+			break;
+		}
+		if (t < from || rule.isException(t))
+		{
+			continue;
+		}
+
+		start = t;
+		return true;
+	}
+
+	done = true;
+	return false;
+}
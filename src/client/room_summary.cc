@@ -0,0 +1,46 @@
+#include <string.h>
+
+#include "client/calendar_client.h"
+#include "client/room_summary.h"
+
+using namespace calendar_client;
+
+// Copies at most TextSize - 1 bytes, without cutting a UTF-8 sequence in
+// half: the copy ends before the byte that starts the cut off character.
+static void copyText(char *dest, const char *text)
+{
+	size_t len = strlen(text);
+	if (len >= RoomSummary::TextSize)
+	{
+		len = RoomSummary::TextSize - 1;
+		while (len > 0 && (text[len] & 0xC0) == 0x80)
+		{
+			len--;
+		}
+	}
+	memcpy(dest, text, len);
+	dest[len] = '\0';
+}
+
+void RoomSummary::update(const char *name, const CalendarIndex &index, time_t now)
+{
+	const CalendarEntry *currentEvent = CalendarClient::findCurrentEvent(index, now);
+	const CalendarEntry *nextEvent = index.nextStart(now);
+
+	// an event going on that does not take up the room leaves it free
+	if (index.freeUntil(now) != now)
+	{
+		currentEvent = NULL;
+	}
+
+	copyText(this->name, name);
+	copyText(current, currentEvent != NULL ? currentEvent->getTitle().c_str() : "");
+	copyText(next, nextEvent != NULL ? nextEvent->getTitle().c_str() : "");
+	currentEnd = currentEvent != NULL ? currentEvent->getEnd() : 0;
+	nextStart = nextEvent != NULL ? nextEvent->getStart() : 0;
+	busy = currentEvent != NULL ? currentEvent->getBusy() : BusyState::Free;
+	important = currentEvent != NULL && currentEvent->isImportant();
+
+	freeFrom = index.nextFreeSlot(now, 60);
+	freeUntil = index.freeUntil(freeFrom);
+}
@@ -1,20 +1,56 @@
 #include "components/components.h"
 
+// Subsets of FreeSans with the characters of Latin-1 and more, generated
+// by fonts/ttf_to_header.py. Without them, the 7-bit fonts of Adafruit_GFX
+// are used.
+#if __has_include("fonts/fonts.h")
+#include "fonts/fonts.h"
+#define FONT_9 FreeSans9ptSubset
+#define FONT_12 FreeSans12ptSubset
+#define FONT_18 FreeSans18ptSubset
+#define FONT_24 FreeSans24ptSubset
+#else
 #include <Fonts/FreeSans24pt7b.h>
 #include <Fonts/FreeSans18pt7b.h>
 #include <Fonts/FreeSans12pt7b.h>
 #include <Fonts/FreeSans9pt7b.h>
+#define FONT_9 FreeSans9pt7b
+#define FONT_12 FreeSans12pt7b
+#define FONT_18 FreeSans18pt7b
+#define FONT_24 FreeSans24pt7b
+#endif
 
+#include "components/vector_icon.h"
 #include "config.h"
 
+// The driver keeps the level its controller signals busy with to itself
+struct DriverBusyLevel : public GxEPD2_DRIVER_CLASS
+{
+	static int16_t of(const GxEPD2_DRIVER_CLASS *epd2) { return epd2->*(&DriverBusyLevel::_busy_level); }
+};
+
 DisplayBuffer::DisplayBuffer(int8_t pin_epd_cs, int16_t pin_epd_dc, int16_t pin_epd_rst, int16_t pin_epd_busy)
+	: pin_epd_busy(pin_epd_busy),
+	  busyCallback(NULL),
+	  busyCallbackParameter(NULL),
+	  staticLayer(NULL)
 {
-	this->display = new GxEPD2_DISPLAY_CLASS<GxEPD2_DRIVER_CLASS, MAX_HEIGHT(GxEPD2_DRIVER_CLASS)>(GxEPD2_DRIVER_CLASS(pin_epd_cs, pin_epd_dc, pin_epd_rst, pin_epd_busy));
-	display->setRotation(0);
-	display->setTextWrap(false);
+	this->epd2 = new GxEPD2_DRIVER_CLASS(pin_epd_cs, pin_epd_dc, pin_epd_rst, pin_epd_busy);
+	this->busyLevel = DriverBusyLevel::of(epd2);
+#if defined(DISP_3C) || defined(DISP_7C)
+	this->page = new StripBuffer(GxEPD2_DRIVER_CLASS::WIDTH, GxEPD2_DRIVER_CLASS::HEIGHT, DISP_STRIP_HEIGHT, DISP_OPEN_STRIPS);
+#else
+	this->page = new PageBuffer(GxEPD2_DRIVER_CLASS::WIDTH, GxEPD2_DRIVER_CLASS::HEIGHT, MAX_HEIGHT(GxEPD2_DRIVER_CLASS));
+#endif
+	this->pages = (GxEPD2_DRIVER_CLASS::HEIGHT + page->getPageHeight() - 1) / page->getPageHeight();
+#if defined(DISP_7C)
+	this->nativeRow = (uint8_t *)malloc(GxEPD2_DRIVER_CLASS::WIDTH / 2);
+#endif
+	page->setRotation(0);
+	page->setTextWrap(false);
 
 	setTextSize(1);
-	display->setFullWindow();
+	setFullWindow();
 	setForegroundColor(Color::Black);
 	setBackgroundColor(Color::White);
 }
@@ -33,46 +69,340 @@ Color DisplayBuffer::setBackgroundColor(Color c)
 	return old;
 }
 
+// BUSY is at the level the driver waits on, which depends on the controller
+bool DisplayBuffer::isBusy() const
+{
+	if (pin_epd_busy < 0)
+	{
+		return false;
+	}
+
+	return digitalRead(pin_epd_busy) == busyLevel;
+}
+
+// Blocks until the panel releases BUSY or the timeout (in ms) expires
+void DisplayBuffer::waitWhileBusy(uint32_t timeout) const
+{
+	unsigned long start = millis();
+	while (isBusy() && millis() - start < timeout)
+	{
+		delay(1);
+	}
+
+#if DEBUG_LEVEL >= 1
+	if (isBusy())
+	{
+		Serial.println("[debug] panel still busy after " + String(timeout) + "ms");
+	}
+#endif
+}
+
 // Function to test if a specific alignment flag is set
 bool hasAlignment(uint8_t alignment, Alignment flag)
 {
 	return (alignment & flag) == flag;
 }
 
+void DisplayBuffer::setFullWindow()
+{
+	currentPage = 0;
+	page->setBand(0, page->getPageHeight());
+}
+
 void DisplayBuffer::clearDisplay()
 {
-	display->setFullWindow();
-	display->fillScreen(backgroundColor);
+	setFullWindow();
+	clearPage();
+}
+
+void DisplayBuffer::clearPage()
+{
+	if (staticLayer == NULL)
+	{
+		page->fillScreen(backgroundColor);
+		return;
+	}
+
+	if (page->getBandY() == 0)
+	{
+		staticLayerDecoder.reset(staticLayer->data(), staticLayer->size());
+	}
+
+	int16_t bandEnd = page->getBandY() + page->getBandHeight();
+	for (int16_t y = page->getBandY(); y < bandEnd; y++)
+	{
+		for (uint8_t p = 0; p < DISP_PLANES; p++)
+		{
+			if (staticLayerDecoder.read(page->row(p, y), page->getStride()) != page->getStride())
+			{
+				Serial.println("[error]: static layer is truncated, falling back to a blank page");
+				staticLayer = NULL;
+				page->fillScreen(backgroundColor);
+				return;
+			}
+		}
+	}
+}
+
+void DisplayBuffer::setStaticLayer(const std::vector<uint8_t> *layer)
+{
+	staticLayer = (layer != NULL && !layer->empty()) ? layer : NULL;
+	clearDisplay();
+}
+
+void DisplayBuffer::composeStaticLayer(std::function<void()> draw, std::vector<uint8_t> &layer)
+{
+	layer.clear();
+
+	for (int16_t y = 0; y < page->height(); y += page->getPageHeight())
+	{
+		page->setBand(y, page->getPageHeight());
+		page->fillScreen(backgroundColor);
+
+		draw();
+
+		for (int16_t row = y; row < y + page->getBandHeight(); row++)
+		{
+			for (uint8_t p = 0; p < DISP_PLANES; p++)
+			{
+				rle::encode(page->row(p, row), page->getStride(), layer);
+			}
+		}
+	}
+
+#if DEBUG_LEVEL >= 1
+	Serial.printf("[debug] static layer composed: %d bytes\n", layer.size());
+#endif
+
+	clearDisplay();
+}
+
+// The frame does not go through the page, which on the color panels would
+// encode every strip only to decode it again. It is decoded into a band of a
+// few rows, which is sent to the panel as soon as it is complete.
+bool DisplayBuffer::streamFrame(Stream &stream)
+{
+	static const int16_t BandRows = 16;
+	uint16_t stride = page->getStride();
+	std::vector<uint8_t> band((size_t)BandRows * stride * DISP_PLANES);
+	const uint8_t *planes[DISP_PLANES];
+	for (uint8_t p = 0; p < DISP_PLANES; p++)
+	{
+		planes[p] = band.data() + p * BandRows * stride;
+	}
+
+	// the decoder keeps pointing into the chunk until it is used up
+	uint8_t chunk[256];
+	rle::Decoder decoder;
+
+	staticLayer = NULL;
+	for (int16_t bandY = 0; bandY < page->height(); bandY += BandRows)
+	{
+		int16_t rows = std::min(BandRows, (int16_t)(page->height() - bandY));
+		for (int16_t y = 0; y < rows; y++)
+		{
+			for (uint8_t p = 0; p < DISP_PLANES; p++)
+			{
+				uint8_t *row = (uint8_t *)planes[p] + y * stride;
+				size_t filled = decoder.read(row, stride);
+				while (filled < stride)
+				{
+					// asking for more than arrived would wait for the timeout
+					// at the end of the frame
+					size_t wanted = std::min(sizeof(chunk), (size_t)std::max(stream.available(), 1));
+					size_t len = stream.readBytes(chunk, wanted);
+					if (len == 0)
+					{
+						Serial.printf("[error]: frame is truncated at row %d\n", bandY + y);
+						return false;
+					}
+					decoder.setInput(chunk, len);
+					filled += decoder.read(row + filled, stride - filled);
+				}
+			}
+		}
+
+		writeRows(planes, bandY, rows);
+	}
+
+	refresh();
+	return true;
+}
+
+void DisplayBuffer::writeRows(const uint8_t *const planes[DISP_PLANES], int16_t y, int16_t h)
+{
+#if defined(DISP_7C)
+	// the ACeP controller only takes its native 4bpp format, so the planes
+	// are merged row by row. The controller keeps appending rows while paged.
+	if (y == 0)
+	{
+		epd2->setPaged();
+	}
+
+	for (int16_t row = 0; row < h; row++)
+	{
+		const uint8_t *p0 = planes[0] + row * page->getStride();
+		const uint8_t *p1 = planes[1] + row * page->getStride();
+		const uint8_t *p2 = planes[2] + row * page->getStride();
+
+		for (int16_t x = 0; x < GxEPD2_DRIVER_CLASS::WIDTH; x += 2)
+		{
+			uint8_t shift = 7 - (x & 7);
+			uint8_t hi = ((p0[x >> 3] >> shift) & 1) | (((p1[x >> 3] >> shift) & 1) << 1) | (((p2[x >> 3] >> shift) & 1) << 2);
+			shift--;
+			uint8_t lo = ((p0[x >> 3] >> shift) & 1) | (((p1[x >> 3] >> shift) & 1) << 1) | (((p2[x >> 3] >> shift) & 1) << 2);
+			nativeRow[x >> 1] = (hi << 4) | lo;
+		}
+
+		epd2->writeNative(nativeRow, NULL, 0, y + row, GxEPD2_DRIVER_CLASS::WIDTH, 1, false, false, false);
+	}
+#elif defined(DISP_3C)
+	epd2->writeImage(planes[0], planes[1], 0, y, GxEPD2_DRIVER_CLASS::WIDTH, h, false, false, false);
+#else
+	epd2->writeImage(planes[0], 0, y, GxEPD2_DRIVER_CLASS::WIDTH, h, false, false, false);
+#endif
+}
+
+// All rows are transferred, start the refresh. While the panel is busy, the
+// driver keeps calling the busy callback. It is only installed for this
+// wait, the driver also waits on BUSY while it powers up the controller for
+// the first rows, which the tasks of the callback must not delay.
+void DisplayBuffer::refresh()
+{
+	epd2->setBusyCallback(busyCallback, busyCallbackParameter);
+	epd2->refresh(false);
+	epd2->setBusyCallback(NULL, NULL);
+	setFullWindow();
+}
+
+bool DisplayBuffer::nextPage()
+{
+	int16_t bandY = page->getBandY();
+	int16_t bandHeight = page->getBandHeight();
+
+	// the rows are sent in the chunks they are stored in
+	int16_t h;
+	for (int16_t y = bandY; y < bandY + bandHeight; y += h)
+	{
+		h = bandY + bandHeight - y;
+		const uint8_t *planes[DISP_PLANES];
+		for (uint8_t p = 0; p < DISP_PLANES; p++)
+		{
+			planes[p] = page->rows(p, y, h);
+		}
+		writeRows(planes, y, h);
+	}
+
+#if DEBUG_LEVEL >= 1 && (defined(DISP_3C) || defined(DISP_7C))
+	Serial.printf("[debug] frame buffer: %d bytes encoded\n", ((StripBuffer *)page)->getEncodedSize());
+#endif
+
+	currentPage++;
+	if (currentPage >= pages)
+	{
+		refresh();
+		return false;
+	}
+
+	page->setBand(currentPage * page->getPageHeight(), page->getPageHeight());
+	clearPage();
+	return true;
 }
 
 void DisplayBuffer::setFontSize(uint8_t fontSize)
 {
 	this->fontSize = fontSize;
-	DisplayBuffer::_setFontSize(display, fontSize);
+	DisplayBuffer::_setFontSize(page, fontSize);
+}
+
+static void useFont(PageBuffer *buffer, const GFXfont *font)
+{
+	buffer->setUnicodeFont(NULL);
+	buffer->setFont(font);
 }
 
-void DisplayBuffer::_setFontSize(Adafruit_GFX *buffer, uint8_t fontSize)
+static void useFont(PageBuffer *buffer, const UnicodeFont *font)
 {
+	buffer->setUnicodeFont(font);
+}
+
+static uint32_t fontKey(const GFXfont *font)
+{
+	size_t glyphs = font->last - font->first + 1;
+	const GFXglyph &last = font->glyph[glyphs - 1];
+
+	uint32_t key = fnv1a(&font->first, sizeof(font->first));
+	key = fnv1a(&font->last, sizeof(font->last), key);
+	key = fnv1a(&font->yAdvance, sizeof(font->yAdvance), key);
+	key = fnv1a(font->glyph, glyphs * sizeof(GFXglyph), key);
+	return fnv1a(font->bitmap, last.bitmapOffset + (last.width * last.height + 7) / 8, key);
+}
+
+static uint32_t fontKey(const UnicodeFont *font)
+{
+	const GFXglyph &last = font->glyph[font->count - 1];
+
+	uint32_t key = fnv1a(&font->yAdvance, sizeof(font->yAdvance));
+	key = fnv1a(font->codepoints, font->count * sizeof(uint16_t), key);
+	key = fnv1a(font->glyph, font->count * sizeof(GFXglyph), key);
+	return fnv1a(font->bitmap, last.bitmapOffset + (last.width * last.height + 7) / 8, key);
+}
+
+// Identifies the font setFontSize() selects for the size: its metrics and
+// glyphs, hashed on the first call.
+uint32_t DisplayBuffer::fontKey(uint8_t fontSize)
+{
+	static uint32_t keys[4];
+	uint8_t i;
+
 	switch (fontSize)
 	{
 	case 9:
-		buffer->setFont(&FreeSans9pt7b);
+		i = 0;
+		break;
+
+	case 18:
+		i = 2;
+		break;
+
+	case 24:
+		i = 3;
+		break;
+
+	default:
+		i = 1;
+	}
+
+	if (keys[i] == 0)
+	{
+		const decltype(&FONT_12) fonts[] = {&FONT_9, &FONT_12, &FONT_18, &FONT_24};
+		keys[i] = ::fontKey(fonts[i]);
+	}
+	return keys[i];
+}
+
+void DisplayBuffer::_setFontSize(PageBuffer *buffer, uint8_t fontSize)
+{
+	switch (fontSize)
+	{
+	case 9:
+		useFont(buffer, &FONT_9);
 		break;
 
 	case 12:
-		buffer->setFont(&FreeSans12pt7b);
+		useFont(buffer, &FONT_12);
 		break;
 
 	case 18:
-		buffer->setFont(&FreeSans18pt7b);
+		useFont(buffer, &FONT_18);
 		break;
 
 	case 24:
-		buffer->setFont(&FreeSans24pt7b);
+		useFont(buffer, &FONT_24);
 		break;
 
 	default:
-		buffer->setFont(&FreeSans12pt7b);
+		useFont(buffer, &FONT_12);
 		Serial.printf("[error]: font-size %d is not available. Only one of 9, 12, 18, 24 is supported\n", fontSize);
 	}
 }
@@ -101,18 +431,31 @@ bool beginsAnyChar(const String &str1, const String &str2)
 	return false;
 }
 
+// Wrapped texts of previous wakes. Most texts, like the titles of calendar
+// entries, do not change from one wake to the next.
+RTC_DATA_ATTR static TextLayout layoutCache[TEXT_LAYOUT_CACHE_SIZE];
+RTC_DATA_ATTR static uint32_t layoutCacheCounter = 0;
+
 // Draw a String on x/y coordinate
 Rect DisplayBuffer::drawString(int16_t x, int16_t y, const String &text, uint8_t alignment)
 {
 	TextSize *size = getStringBounds(text);
+	Rect r = _drawString(x, y, text, *size, alignment);
+	delete size;
+
+	return r;
+}
 
+// Draw a String of known size on x/y coordinate
+Rect DisplayBuffer::_drawString(int16_t x, int16_t y, const String &text, const TextSize &size, uint8_t alignment)
+{
 	if (hasAlignment(alignment, Alignment::HorizontalCenter))
 	{
-		x -= size->width / 2;
+		x -= size.width / 2;
 	}
 	else if (hasAlignment(alignment, Alignment::Right))
 	{
-		x -= size->width;
+		x -= size.width;
 	}
 	else if (hasAlignment(alignment, Alignment::Left))
 	{
@@ -121,7 +464,7 @@ Rect DisplayBuffer::drawString(int16_t x, int16_t y, const String &text, uint8_t
 
 	if (hasAlignment(alignment, Alignment::VerticalCenter))
 	{
-		y -= size->height / 2;
+		y -= size.height / 2;
 	}
 	else if (hasAlignment(alignment, Alignment::Top))
 	{
@@ -129,10 +472,23 @@ Rect DisplayBuffer::drawString(int16_t x, int16_t y, const String &text, uint8_t
 	}
 	else if (hasAlignment(alignment, Alignment::Bottom))
 	{
-		y = y - size->height;
+		y = y - size.height;
 	}
 
-	int offsetY = y + size->height;
+	Rect r;
+	r.x = x;
+	r.y = y;
+	r.width = size.width;
+	r.height = size.height;
+
+	// glyphs may reach below the baseline and above the measured height,
+	// so only skip the text if it is well outside the band
+	if (!isVisible(y - size.height / 2, size.height * 2))
+	{
+		return r;
+	}
+
+	int offsetY = y + size.height;
 	int offsetX = x;
 
 	// I hate this!
@@ -140,26 +496,20 @@ Rect DisplayBuffer::drawString(int16_t x, int16_t y, const String &text, uint8_t
 	// adjust the Y offset to include the descender height since print
 	if (containsAnyChar(text, "qypgj()"))
 	{
-		offsetY -= size->height / 3;
+		offsetY -= size.height / 3;
 	}
 
 	if (beginsAnyChar(text, "1J"))
 	{
 		int16_t x, y;
 		uint16_t w, h;
-		display->getTextBounds("1", 0, 0, &x, &y, &w, &h);
+		page->textBounds("1", &x, &y, &w, &h);
 		offsetX -= w / 4 * 3;
 	}
 
-	display->setTextColor(foregroundColor);
-	display->setCursor(offsetX, offsetY);
-	display->print(text);
-
-	Rect r;
-	r.x = x;
-	r.y = y;
-	r.width = size->width;
-	r.height = size->height;
+	page->setTextColor(foregroundColor);
+	page->setCursor(offsetX, offsetY);
+	page->print(text);
 
 	return r;
 }
@@ -168,7 +518,7 @@ TextSize *DisplayBuffer::getStringBounds(const String &text)
 {
 	int16_t x1, y1;
 	uint16_t w, h;
-	display->getTextBounds(text, 0, 0, &x1, &y1, &w, &h);
+	page->textBounds(text, &x1, &y1, &w, &h);
 
 	TextSize *size = new TextSize();
 	size->width = w;
@@ -178,32 +528,81 @@ TextSize *DisplayBuffer::getStringBounds(const String &text)
 
 TextSize *DisplayBuffer::getStringBounds(const String &text, uint16_t max_width, uint16_t max_lines)
 {
-	uint16_t current_line = 0;
-	String textRemaining = text;
+	const TextLayout &layout = layoutString(text, max_width, max_lines);
 
 	TextSize *biggestTextSize = new TextSize();
 	biggestTextSize->width = 0;
 	biggestTextSize->height = 0;
 
-	// print until we reach max_lines or no more text remains
-	while (current_line < max_lines && !textRemaining.isEmpty())
+	for (uint8_t i = 0; i < layout.lineCount; i++)
 	{
-		int16_t x1, y1;
-		uint16_t w, h;
+		biggestTextSize->width = std::max(biggestTextSize->width, layout.lines[i].size.width);
+		biggestTextSize->height += layout.lines[i].size.height;
+	}
 
-		display->getTextBounds(textRemaining, 0, 0, &x1, &y1, &w, &h);
+	return biggestTextSize;
+}
 
-		if (w > biggestTextSize->width)
+const TextLayout &DisplayBuffer::layoutString(const String &text, uint16_t max_width, uint16_t max_lines)
+{
+	max_lines = std::min(max_lines, (uint16_t)TEXT_LAYOUT_MAX_LINES);
+	uint32_t textHash = fnv1a(text);
+
+	// look the text up, otherwise replace the least recently used layout
+	TextLayout *layout = &layoutCache[0];
+	for (TextLayout &cached : layoutCache)
+	{
+		if (cached.textHash == textHash && cached.textLength == text.length() && cached.fontSize == fontSize &&
+			cached.maxWidth == max_width && cached.maxLines == max_lines)
+		{
+			cached.lastUsed = ++layoutCacheCounter;
+			return cached;
+		}
+
+		if (cached.lastUsed < layout->lastUsed)
 		{
-			biggestTextSize->width = w;
+			layout = &cached;
 		}
+	}
+
+	layout->textHash = textHash;
+	layout->textLength = text.length();
+	layout->fontSize = fontSize;
+	layout->maxWidth = max_width;
+	layout->maxLines = max_lines;
+	layout->lastUsed = ++layoutCacheCounter;
+
+	_layoutString(text, *layout);
 
-		biggestTextSize->height += h;
+	return *layout;
+}
+
+// Breaks the text into lines of at most maxWidth pixels
+void DisplayBuffer::_layoutString(const String &text, TextLayout &layout)
+{
+	uint16_t max_width = layout.maxWidth;
+	uint16_t max_lines = layout.maxLines;
+
+	int16_t x1, y1;
+	uint16_t w, h;
+
+	page->textBounds(text, &x1, &y1, &w, &h);
+	layout.lineSpacing = h;
+
+	uint16_t current_line = 0;
+	unsigned int start = 0;
+	String textRemaining = text;
+
+	// print until we reach max_lines or no more text remains
+	while (current_line < max_lines && !textRemaining.isEmpty())
+	{
+		page->textBounds(textRemaining, &x1, &y1, &w, &h);
 
 		int endIndex = textRemaining.length();
 		// check if remaining text is to wide, if it is then print what we can
 		String subStr = textRemaining;
 		int splitAt = 0;
+		bool ellipsis = false;
 		int keepLastChar = 0;
 		while (w > max_width && splitAt != -1)
 		{
@@ -246,30 +645,41 @@ TextSize *DisplayBuffer::getStringBounds(const String &text, uint16_t max_width,
 				if (current_line < max_lines - 1)
 				{
 					// this is not the last line
-					display->getTextBounds(subStr, 0, 0, &x1, &y1, &w, &h);
+					page->textBounds(subStr, &x1, &y1, &w, &h);
 				}
 				else
 				{
 					// this is the last line, we need to make sure there is space for
 					// ellipsis
-					display->getTextBounds(subStr + "...", 0, 0, &x1, &y1, &w, &h);
+					page->textBounds(subStr + "...", &x1, &y1, &w, &h);
 					if (w <= max_width)
 					{
 						// ellipsis fit, add them to subStr
 						subStr = subStr + "...";
+						ellipsis = true;
 					}
 				}
 			}
 		}
 
+		TextLayout::Line &line = layout.lines[current_line];
+		line.start = start;
+		line.length = std::min((unsigned int)(endIndex + 1), textRemaining.length());
+		line.ellipsis = ellipsis;
+
+		page->textBounds(subStr, &x1, &y1, &w, &h);
+		line.size.width = w;
+		line.size.height = h;
+
 		// update textRemaining to no longer include what was printed
 		// +1 for exclusive bounds, +1 to get passed space/dash
+		start += endIndex + 2 - keepLastChar;
 		textRemaining = textRemaining.substring(endIndex + 2 - keepLastChar);
 
 		++current_line;
 	}
 
-	return biggestTextSize;
+	layout.lineCount = current_line;
 }
 
 void DisplayBuffer::drawIcon(int16_t x, int16_t y, const String &iconName, int16_t size, uint8_t alignment)
@@ -300,26 +710,51 @@ void DisplayBuffer::drawIcon(int16_t x, int16_t y, const String &iconName, int16
 		y -= size;
 	}
 
+	// looking up the icon by name is not free either
+	if (!isVisible(y, size))
+	{
+		return;
+	}
+
+	// outlines give better results than scaling a bitmap
+	size_t length;
+	const uint8_t *outline = getIconOutline(iconName, size, length);
+	if (outline != NULL && VectorIcon::draw(*page, outline, length, x, y, size, foregroundColor))
+	{
+		return;
+	}
+
 	drawBitmap(x, y, getIcon(iconName, size), size, size);
 }
 
 void DisplayBuffer::drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t width, int16_t height)
 {
-	display->drawInvertedBitmap(x, y, bitmap, width, height, foregroundColor);
+	if (!isVisible(y, height))
+	{
+		return;
+	}
+
+	page->drawBitmap1bpp(x, y, bitmap, width, height, foregroundColor, true);
 }
 
 void DisplayBuffer::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t thickness)
 {
-	display->fillRect(x, y, thickness, h, foregroundColor);					// left column
-	display->fillRect(x + w - thickness, y, thickness, h, foregroundColor); // right column
+	if (!isVisible(y, h))
+	{
+		return;
+	}
 
-	display->fillRect(x, y, w, thickness, foregroundColor);					// top column
-	display->fillRect(x, y + h - thickness, w, thickness, foregroundColor); // bottom column
+	page->fillRect(x, y, thickness, h, foregroundColor);					// left column
+	page->fillRect(x + w - thickness, y, thickness, h, foregroundColor); // right column
+
+	page->fillRect(x, y, w, thickness, foregroundColor);					// top column
+	page->fillRect(x, y + h - thickness, w, thickness, foregroundColor); // bottom column
 }
 
 // Draws a string that will flow into the next line when max_width is reached.
 // If a string exceeds max_lines an ellipsis (...) will terminate the last word.
-// Lines will break at spaces(' ') and dashes('-').
+// Lines will break at spaces(' ') and dashes('-'). At most
+// TEXT_LAYOUT_MAX_LINES lines are drawn.
 //
 // Note: max_width should be big enough to accommodate the largest word that
 //       will be displayed. If an unbroken string of characters longer than
@@ -333,81 +768,16 @@ Rect DisplayBuffer::drawString(int16_t x, int16_t y, const String &text, uint8_t
 	textRect.width = 0;
 	textRect.height = 0;
 
-	uint16_t current_line = 0;
-	String textRemaining = text;
-
-	int16_t x1, y1;
-	uint16_t w, h;
-
-	display->getTextBounds(textRemaining, 0, 0, &x1, &y1, &w, &h);
-	int16_t line_spacing = h;
+	const TextLayout &layout = layoutString(text, max_width, max_lines);
 
-	// print until we reach max_lines or no more text remains
-	while (current_line < max_lines && !textRemaining.isEmpty())
+	for (uint8_t current_line = 0; current_line < layout.lineCount; current_line++)
 	{
-		display->getTextBounds(textRemaining, 0, 0, &x1, &y1, &w, &h);
+		const TextLayout::Line &line = layout.lines[current_line];
 
-		int endIndex = textRemaining.length();
-		// check if remaining text is to wide, if it is then print what we can
-		String subStr = textRemaining;
-		int splitAt = 0;
-		int keepLastChar = 0;
-		while (w > max_width && splitAt != -1)
+		String subStr = text.substring(line.start, line.start + line.length);
+		if (line.ellipsis)
 		{
-
-			if (keepLastChar)
-			{
-				// if we kept the last character during the last iteration of this while
-				// loop, remove it now so we don't get stuck in an infinite loop.
-				subStr.remove(subStr.length() - 1);
-			}
-
-			// find the last place in the string that we can break it.
-			if (current_line < max_lines - 1)
-			{
-				splitAt = std::max(subStr.lastIndexOf(" "),
-								   subStr.lastIndexOf("-"));
-			}
-			else
-			{
-				// this is the last line, only break at spaces so we can add ellipsis
-				splitAt = subStr.lastIndexOf(" ");
-			}
-
-			// if splitAt == -1 then there is an unbroken set of characters that is
-			// longer than max_width. Otherwise if splitAt != -1 then we can continue
-			// the loop until the string is <= max_width
-			if (splitAt != -1)
-			{
-				endIndex = splitAt;
-				subStr = subStr.substring(0, endIndex + 1);
-
-				char lastChar = subStr.charAt(endIndex);
-				if (lastChar == ' ' || lastChar == '-' || lastChar == ':')
-				{
-					// remove this char now so it is not counted towards line width
-					keepLastChar = 0;
-					subStr.remove(endIndex);
-					--endIndex;
-				}
-
-				if (current_line < max_lines - 1)
-				{
-					// this is not the last line
-					display->getTextBounds(subStr, 0, 0, &x1, &y1, &w, &h);
-				}
-				else
-				{
-					// this is the last line, we need to make sure there is space for
-					// ellipsis
-					display->getTextBounds(subStr + "...", 0, 0, &x1, &y1, &w, &h);
-					if (w <= max_width)
-					{
-						// ellipsis fit, add them to subStr
-						subStr = subStr + "...";
-					}
-				}
-			}
+			subStr += "...";
 		}
 
 #if DEBUG_LEVEL >= 2
@@ -416,12 +786,12 @@ Rect DisplayBuffer::drawString(int16_t x, int16_t y, const String &text, uint8_t
 			Serial.printf("[verbose] Draw String (line %d): %s (x=%d / y=%d, height=%d)\n",
 						  current_line + 1,
 						  subStr.c_str(),
-						  x, y + (current_line * line_spacing),
-						  line_spacing);
+						  x, y + (current_line * layout.lineSpacing),
+						  layout.lineSpacing);
 		}
 #endif
 
-		Rect r = drawString(x, y + (current_line * line_spacing), subStr, alignment);
+		Rect r = _drawString(x, y + (current_line * layout.lineSpacing), subStr, line.size, alignment);
 
 		if (r.x < textRect.x)
 		{
@@ -439,14 +809,8 @@ Rect DisplayBuffer::drawString(int16_t x, int16_t y, const String &text, uint8_t
 			textRect.y = r.y;
 		}
 
-		textRect.height += r.height + (current_line * line_spacing);
-
-		// update textRemaining to no longer include what was printed
-		// +1 for exclusive bounds, +1 to get passed space/dash
-		textRemaining = textRemaining.substring(endIndex + 2 - keepLastChar);
-
-		++current_line;
+		textRect.height += r.height + (current_line * layout.lineSpacing);
 	}
 
 	return textRect;
-}
\ No newline at end of file
+}
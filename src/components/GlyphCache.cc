@@ -0,0 +1,77 @@
+#include "components/glyph_cache.h"
+
+const uint16_t GlyphCache::NotCached;
+
+GlyphCache::FontGlyphs &GlyphCache::glyphsOf(const void *font, uint16_t glyphCount)
+{
+	for (FontGlyphs &glyphs : fonts)
+	{
+		if (glyphs.font == font)
+		{
+			return glyphs;
+		}
+	}
+
+	fonts.push_back(FontGlyphs());
+	FontGlyphs &glyphs = fonts.back();
+	glyphs.font = font;
+	glyphs.offsets.assign(glyphCount, NotCached);
+	return glyphs;
+}
+
+const uint8_t *GlyphCache::get(const GFXfont *font, uint8_t c)
+{
+	if (c < font->first || c > font->last)
+	{
+		return NULL;
+	}
+
+	return get(font, font->last - font->first + 1, c - font->first, &font->glyph[c - font->first], font->bitmap);
+}
+
+const uint8_t *GlyphCache::get(const UnicodeFont *font, uint16_t index)
+{
+	if (index >= font->count)
+	{
+		return NULL;
+	}
+
+	return get(font, font->count, index, &font->glyph[index], font->bitmap);
+}
+
+const uint8_t *GlyphCache::get(const void *font, uint16_t glyphCount, uint16_t index, const GFXglyph *glyph, const uint8_t *bitmap)
+{
+	FontGlyphs &glyphs = glyphsOf(font, glyphCount);
+	uint16_t &offset = glyphs.offsets[index];
+
+	if (offset == NotCached)
+	{
+		uint16_t rowBytes = (glyph->width + 7) / 8;
+		size_t size = rowBytes * glyph->height;
+
+		if (size == 0 || glyphs.data.size() + size >= NotCached)
+		{
+			return NULL;
+		}
+
+		offset = glyphs.data.size();
+		glyphs.data.resize(glyphs.data.size() + size, 0);
+
+		// the rows of a glyph follow each other without padding in the font
+		const uint8_t *src = bitmap + glyph->bitmapOffset;
+		uint8_t *dst = glyphs.data.data() + offset;
+		uint16_t bit = 0;
+		for (uint8_t y = 0; y < glyph->height; y++)
+		{
+			for (uint8_t x = 0; x < glyph->width; x++, bit++)
+			{
+				if (src[bit >> 3] & (0x80 >> (bit & 7)))
+				{
+					dst[y * rowBytes + (x >> 3)] |= 0x80 >> (x & 7);
+				}
+			}
+		}
+	}
+
+	return glyphs.data.data() + offset;
+}
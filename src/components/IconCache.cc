@@ -0,0 +1,114 @@
+#include "components/icon_cache.h"
+
+#include <Arduino.h>
+#include <algorithm>
+#include <string.h>
+
+#include "config.h"
+
+IconCache::IconCache(uint8_t slotCount)
+	: slots(slotCount),
+	  useCounter(0)
+{
+	for (Slot &slot : slots)
+	{
+		slot.key = 0;
+		slot.used = 0;
+	}
+}
+
+const uint8_t *IconCache::get(const AssetPack &pack, const char *name, uint16_t size)
+{
+	if (slots.empty() || size == 0)
+	{
+		return NULL;
+	}
+
+	uint32_t key = AssetPack::key(name, size);
+	Slot *slot = &slots[0];
+	for (Slot &s : slots)
+	{
+		if (s.key == key && !s.bitmap.empty())
+		{
+			s.used = ++useCounter;
+			return s.bitmap.data();
+		}
+		if (s.used < slot->used)
+		{
+			slot = &s;
+		}
+	}
+
+	AssetPack::Asset master;
+	if (!pack.find(name, AssetPack::Master, master) || master.width != master.height ||
+		master.length < (uint32_t)((master.width + 7) / 8 * master.height))
+	{
+		return NULL;
+	}
+
+	slot->key = key;
+	slot->used = ++useCounter;
+	slot->bitmap.resize((size + 7) / 8 * size);
+	scale(master.data, master.width, slot->bitmap.data(), size);
+
+#if DEBUG_LEVEL >= 1
+	Serial.printf("[debug] Scaled icon '%s' from %dpx to %dpx\n", name, master.width, size);
+#endif
+
+	return slot->bitmap.data();
+}
+
+// Works a destination row at a time: the black pixels of every source column
+// within the rows of the box are counted first, then the counts are summed
+// up over the columns of each destination pixel. The boxes have integer
+// bounds, so they differ in size by a pixel when the sizes do not divide.
+void IconCache::scale(const uint8_t *src, uint16_t srcSize, uint8_t *dst, uint16_t dstSize, uint8_t threshold)
+{
+	uint16_t srcStride = (srcSize + 7) / 8;
+	uint16_t dstStride = (dstSize + 7) / 8;
+	std::vector<uint16_t> black(srcSize);
+
+	memset(dst, 0xFF, dstStride * dstSize);
+
+	for (uint16_t dy = 0; dy < dstSize; dy++)
+	{
+		uint16_t y0 = dy * srcSize / dstSize;
+		uint16_t y1 = std::max((dy + 1) * srcSize / dstSize, y0 + 1);
+
+		std::fill(black.begin(), black.end(), 0);
+		for (uint16_t sy = y0; sy < y1; sy++)
+		{
+			const uint8_t *row = src + sy * srcStride;
+			for (uint16_t i = 0; i < srcStride; i++)
+			{
+				// icons are mostly white
+				if (row[i] == 0xFF)
+				{
+					continue;
+				}
+				for (uint16_t sx = i * 8; sx < i * 8 + 8 && sx < srcSize; sx++)
+				{
+					black[sx] += !(row[i] & (0x80 >> (sx & 7)));
+				}
+			}
+		}
+
+		uint8_t *out = dst + dy * dstStride;
+		for (uint16_t dx = 0; dx < dstSize; dx++)
+		{
+			uint16_t x0 = dx * srcSize / dstSize;
+			uint16_t x1 = std::max((dx + 1) * srcSize / dstSize, x0 + 1);
+
+			uint32_t sum = 0;
+			for (uint16_t sx = x0; sx < x1; sx++)
+			{
+				sum += black[sx];
+			}
+
+			if (sum > 0 && sum * 256 >= (uint32_t)threshold * (x1 - x0) * (y1 - y0))
+			{
+				out[dx >> 3] &= ~(0x80 >> (dx & 7));
+			}
+		}
+	}
+}
@@ -0,0 +1,535 @@
+#include "components/page_buffer.h"
+
+#include <string.h>
+
+#include "config.h"
+#include "rle.h"
+
+PageBuffer::PageBuffer(int16_t width, int16_t height, int16_t pageHeight)
+	: Adafruit_GFX(width, height),
+	  stride((width + 7) / 8),
+	  pageHeight(pageHeight),
+	  bandY(0),
+	  bandHeight(pageHeight),
+	  unicodeFont(NULL)
+{
+	for (uint8_t p = 0; p < DISP_PLANES; p++)
+	{
+		planes[p] = (uint8_t *)malloc(stride * pageHeight);
+	}
+}
+
+PageBuffer::PageBuffer(int16_t width, int16_t height)
+	: Adafruit_GFX(width, height),
+	  stride((width + 7) / 8),
+	  pageHeight(height),
+	  bandY(0),
+	  bandHeight(height),
+	  unicodeFont(NULL)
+{
+	for (uint8_t p = 0; p < DISP_PLANES; p++)
+	{
+		planes[p] = NULL;
+	}
+}
+
+PageBuffer::~PageBuffer()
+{
+	for (uint8_t p = 0; p < DISP_PLANES; p++)
+	{
+		free(planes[p]);
+	}
+}
+
+void PageBuffer::setBand(int16_t y, int16_t h)
+{
+	bandY = y;
+	bandHeight = std::min(h, std::min(pageHeight, (int16_t)(HEIGHT - y)));
+}
+
+const uint8_t *PageBuffer::rows(uint8_t plane, int16_t y, int16_t &h)
+{
+	h = std::min(h, (int16_t)(bandY + bandHeight - y));
+	return row(plane, y);
+}
+
+uint8_t PageBuffer::planeBits(uint16_t color)
+{
+#if defined(DISP_7C)
+	// native color index of the ACeP controller
+	switch (color)
+	{
+	case Color::Black:
+		return 0x00;
+	case Color::White:
+		return 0x01;
+	case Color::Green:
+		return 0x02;
+	case Color::Blue:
+		return 0x03;
+	case Color::Red:
+		return 0x04;
+	case Color::Yellow:
+		return 0x05;
+	case Color::Orange:
+		return 0x06;
+	default:
+		return color == Color::LightGrey ? 0x01 : 0x00;
+	}
+#elif defined(DISP_3C)
+	// plane 0: black plane (0 = black), plane 1: color plane (0 = red)
+	switch (color)
+	{
+	case Color::White:
+	case Color::LightGrey:
+		return 0x03;
+	case Color::Red:
+		return 0x01;
+	default:
+		return 0x02;
+	}
+#else
+	return (color == Color::White || color == Color::LightGrey) ? 0x01 : 0x00;
+#endif
+}
+
+void PageBuffer::drawPixel(int16_t x, int16_t y, uint16_t color)
+{
+	if (x < 0 || x >= WIDTH || y < bandY || y >= bandY + bandHeight)
+	{
+		return;
+	}
+
+	uint8_t bits = planeBits(color);
+	uint8_t mask = 0x80 >> (x & 7);
+	uint16_t i = x >> 3;
+
+	for (uint8_t p = 0; p < DISP_PLANES; p++)
+	{
+		uint8_t *data = rowData(p, y);
+		if ((bits >> p) & 1)
+		{
+			data[i] |= mask;
+		}
+		else
+		{
+			data[i] &= ~mask;
+		}
+	}
+}
+
+void PageBuffer::fillScreen(uint16_t color)
+{
+	fillRect(0, bandY, WIDTH, bandHeight, color);
+}
+
+bool PageBuffer::clip(int16_t &x0, int16_t &y0, int16_t &x1, int16_t &y1) const
+{
+	x0 = std::max(x0, (int16_t)0);
+	x1 = std::min(x1, WIDTH);
+	y0 = std::max(y0, bandY);
+	y1 = std::min(y1, (int16_t)(bandY + bandHeight));
+
+	return x0 < x1 && y0 < y1;
+}
+
+// Applies op to the pixels [x0, x1) of the rows [y0, y1) of a plane.
+// Whole bytes are written at once, only the first and the last byte of a
+// span need masking. Spans covering the full width are written with a
+// single memset per row.
+void PageBuffer::spanRows(uint8_t plane, int16_t x0, int16_t y0, int16_t x1, int16_t y1, SpanOp op)
+{
+	if (op != SpanOp::Toggle && x0 == 0 && x1 == WIDTH && (WIDTH & 7) == 0)
+	{
+		for (int16_t y = y0; y < y1; y++)
+		{
+			memset(rowData(plane, y), op == SpanOp::Set ? 0xFF : 0x00, stride);
+		}
+		return;
+	}
+
+	int16_t firstByte = x0 >> 3;
+	int16_t lastByte = (x1 - 1) >> 3;
+	uint8_t firstMask = 0xFF >> (x0 & 7);
+	uint8_t lastMask = 0xFF << (7 - ((x1 - 1) & 7));
+
+	if (firstByte == lastByte)
+	{
+		firstMask &= lastMask;
+	}
+
+	for (int16_t y = y0; y < y1; y++)
+	{
+		uint8_t *row = rowData(plane, y);
+
+		switch (op)
+		{
+		case SpanOp::Set:
+			row[firstByte] |= firstMask;
+			if (lastByte > firstByte)
+			{
+				memset(row + firstByte + 1, 0xFF, lastByte - firstByte - 1);
+				row[lastByte] |= lastMask;
+			}
+			break;
+
+		case SpanOp::Clear:
+			row[firstByte] &= ~firstMask;
+			if (lastByte > firstByte)
+			{
+				memset(row + firstByte + 1, 0x00, lastByte - firstByte - 1);
+				row[lastByte] &= ~lastMask;
+			}
+			break;
+
+		case SpanOp::Toggle:
+			row[firstByte] ^= firstMask;
+			if (lastByte > firstByte)
+			{
+				uint8_t *b = row + firstByte + 1;
+				uint8_t *end = row + lastByte;
+
+				// toggle 32 bits at a time where the row is word aligned
+				while (b < end && ((uintptr_t)b & 3) != 0)
+				{
+					*b++ ^= 0xFF;
+				}
+				while (b + 4 <= end)
+				{
+					*(uint32_t *)b ^= 0xFFFFFFFF;
+					b += 4;
+				}
+				while (b < end)
+				{
+					*b++ ^= 0xFF;
+				}
+
+				row[lastByte] ^= lastMask;
+			}
+			break;
+		}
+	}
+}
+
+void PageBuffer::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+	int16_t x0 = x, y0 = y, x1 = x + w, y1 = y + h;
+	if (w <= 0 || h <= 0 || !clip(x0, y0, x1, y1))
+	{
+		return;
+	}
+
+	uint8_t bits = planeBits(color);
+	for (uint8_t p = 0; p < DISP_PLANES; p++)
+	{
+		spanRows(p, x0, y0, x1, y1, ((bits >> p) & 1) ? SpanOp::Set : SpanOp::Clear);
+	}
+}
+
+// Only the black/white information is flipped, which is the first plane on
+// all panels. On the 7C panel this also swaps some of the other colors.
+void PageBuffer::invertRect(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+	int16_t x0 = x, y0 = y, x1 = x + w, y1 = y + h;
+	if (w <= 0 || h <= 0 || !clip(x0, y0, x1, y1))
+	{
+		return;
+	}
+
+	spanRows(0, x0, y0, x1, y1, SpanOp::Toggle);
+}
+
+// Reads 8 bits of a bitmap row, starting at bit offset bit.
+// Bits left of the start of the row read as 0.
+static inline uint8_t readBits(const uint8_t *src, int16_t bit, uint16_t rowBytes)
+{
+	if (bit < 0)
+	{
+		return src[0] >> (-bit);
+	}
+
+	uint16_t i = bit >> 3;
+	uint8_t shift = bit & 7;
+	if (shift == 0)
+	{
+		return src[i];
+	}
+
+	uint8_t bits = src[i] << shift;
+	if (i + 1 < rowBytes)
+	{
+		bits |= src[i + 1] >> (8 - shift);
+	}
+	return bits;
+}
+
+// Instead of going through drawPixel for every single bit, the bitmap is
+// combined with the band a whole destination byte at a time. When x is byte
+// aligned, source bytes map 1:1 onto destination bytes, otherwise each
+// destination byte is assembled from two neighbouring source bytes.
+void PageBuffer::drawBitmap1bpp(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color, bool inverted)
+{
+	if (bitmap == NULL || w <= 0 || h <= 0)
+	{
+		return;
+	}
+
+	int16_t x0 = x, y0 = y, x1 = x + w, y1 = y + h;
+	if (!clip(x0, y0, x1, y1))
+	{
+		return;
+	}
+
+	uint16_t rowBytes = (w + 7) / 8;
+	int16_t firstByte = x0 >> 3;
+	int16_t lastByte = (x1 - 1) >> 3;
+	uint8_t firstMask = 0xFF >> (x0 & 7);
+	uint8_t lastMask = 0xFF << (7 - ((x1 - 1) & 7));
+	uint8_t invert = inverted ? 0xFF : 0x00;
+	uint8_t bits = planeBits(color);
+	bool aligned = (x & 7) == 0;
+
+	for (int16_t yy = y0; yy < y1; yy++)
+	{
+		const uint8_t *src = bitmap + (yy - y) * rowBytes;
+		uint8_t *dst[DISP_PLANES];
+		for (uint8_t p = 0; p < DISP_PLANES; p++)
+		{
+			dst[p] = rowData(p, yy);
+		}
+
+		for (int16_t b = firstByte; b <= lastByte; b++)
+		{
+			int16_t srcBit = b * 8 - x;
+			uint8_t ink = (aligned ? src[srcBit >> 3] : readBits(src, srcBit, rowBytes)) ^ invert;
+
+			if (b == firstByte)
+			{
+				ink &= firstMask;
+			}
+			if (b == lastByte)
+			{
+				ink &= lastMask;
+			}
+
+			for (uint8_t p = 0; p < DISP_PLANES; p++)
+			{
+				if ((bits >> p) & 1)
+				{
+					dst[p][b] |= ink;
+				}
+				else
+				{
+					dst[p][b] &= ~ink;
+				}
+			}
+		}
+	}
+}
+
+bool PageBuffer::readRect(int16_t x, int16_t y, int16_t w, int16_t h, std::vector<uint8_t> &out)
+{
+	if ((x & 7) != 0 || (w & 7) != 0 || x < 0 || x + w > WIDTH || y < bandY || y + h > bandY + bandHeight)
+	{
+		return false;
+	}
+
+	out.clear();
+	for (int16_t yy = y; yy < y + h; yy++)
+	{
+		for (uint8_t p = 0; p < DISP_PLANES; p++)
+		{
+			rle::encode(rowData(p, yy) + (x >> 3), w >> 3, out);
+		}
+	}
+	return true;
+}
+
+bool PageBuffer::writeRect(int16_t x, int16_t y, int16_t w, int16_t h, const uint8_t *data, size_t len)
+{
+	if ((x & 7) != 0 || (w & 7) != 0 || x < 0 || x + w > WIDTH || y < bandY || y + h > bandY + bandHeight)
+	{
+		return false;
+	}
+
+	// make sure the copy is complete before anything is overwritten
+	size_t bytes = (size_t)h * DISP_PLANES * (w >> 3);
+	rle::Decoder decoder;
+	decoder.reset(data, len);
+	if (decoder.read(NULL, bytes) != bytes)
+	{
+		return false;
+	}
+
+	decoder.reset(data, len);
+	for (int16_t yy = y; yy < y + h; yy++)
+	{
+		for (uint8_t p = 0; p < DISP_PLANES; p++)
+		{
+			decoder.read(rowData(p, yy) + (x >> 3), w >> 3);
+		}
+	}
+	return true;
+}
+
+size_t PageBuffer::write(uint8_t c)
+{
+	uint32_t codepoint = utf8Decoder.feed(c);
+	if (codepoint == utf8::Incomplete)
+	{
+		return 1;
+	}
+
+	if (unicodeFont != NULL)
+	{
+		writeUnicode(codepoint);
+		return 1;
+	}
+
+	return writeGfx(codepoint < 0x80 ? (uint8_t)codepoint : utf8::fold(codepoint));
+}
+
+size_t PageBuffer::writeGfx(uint8_t c)
+{
+	if (gfxFont == NULL || textsize_x != 1 || textsize_y != 1 || wrap || c < gfxFont->first || c > gfxFont->last)
+	{
+		return Adafruit_GFX::write(c);
+	}
+
+	const GFXglyph *glyph = &gfxFont->glyph[c - gfxFont->first];
+	if (glyph->width > 0 && glyph->height > 0)
+	{
+		const uint8_t *bitmap = glyphCache.get(gfxFont, c);
+		if (bitmap == NULL)
+		{
+			return Adafruit_GFX::write(c);
+		}
+
+		drawBitmap1bpp(cursor_x + glyph->xOffset, cursor_y + glyph->yOffset, bitmap, glyph->width, glyph->height, textcolor, false);
+	}
+
+	cursor_x += glyph->xAdvance;
+	return 1;
+}
+
+// The glyph of the code point, or of '?' if the font does not have it
+const GFXglyph *PageBuffer::unicodeGlyph(uint32_t codepoint, int32_t &index) const
+{
+	index = findGlyph(unicodeFont, codepoint);
+	if (index < 0)
+	{
+		index = findGlyph(unicodeFont, '?');
+	}
+	return index < 0 ? NULL : &unicodeFont->glyph[index];
+}
+
+void PageBuffer::writeUnicode(uint32_t codepoint)
+{
+	if (codepoint == '\n')
+	{
+		cursor_x = 0;
+		cursor_y += unicodeFont->yAdvance;
+		return;
+	}
+
+	int32_t index;
+	const GFXglyph *glyph = unicodeGlyph(codepoint, index);
+	if (codepoint == '\r' || glyph == NULL)
+	{
+		return;
+	}
+
+	if (glyph->width > 0 && glyph->height > 0)
+	{
+		int16_t x = cursor_x + glyph->xOffset;
+		int16_t y = cursor_y + glyph->yOffset;
+		const uint8_t *bitmap = glyphCache.get(unicodeFont, index);
+
+		if (bitmap != NULL)
+		{
+			drawBitmap1bpp(x, y, bitmap, glyph->width, glyph->height, textcolor, false);
+		}
+		else
+		{
+			// the cache is full, draw straight from the font
+			const uint8_t *src = unicodeFont->bitmap + glyph->bitmapOffset;
+			uint16_t bit = 0;
+			for (uint8_t yy = 0; yy < glyph->height; yy++)
+			{
+				for (uint8_t xx = 0; xx < glyph->width; xx++, bit++)
+				{
+					if (src[bit >> 3] & (0x80 >> (bit & 7)))
+					{
+						drawPixel(x + xx, y + yy, textcolor);
+					}
+				}
+			}
+		}
+	}
+
+	cursor_x += glyph->xAdvance;
+}
+
+void PageBuffer::textBounds(const String &text, int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h)
+{
+	if (unicodeFont == NULL)
+	{
+		// replace what the GFX font cannot show, like write() does
+		String folded;
+		size_t pos = 0;
+		while (pos < text.length())
+		{
+			uint32_t codepoint = utf8::next(text.c_str(), text.length(), pos);
+			folded += codepoint < 0x80 ? (char)codepoint : utf8::fold(codepoint);
+		}
+
+		getTextBounds(folded, 0, 0, x1, y1, w, h);
+		return;
+	}
+
+	int16_t minX = INT16_MAX, minY = INT16_MAX, maxX = INT16_MIN, maxY = INT16_MIN;
+	int16_t cursorX = 0, cursorY = 0;
+
+	size_t pos = 0;
+	while (pos < text.length())
+	{
+		uint32_t codepoint = utf8::next(text.c_str(), text.length(), pos);
+		if (codepoint == '\n')
+		{
+			cursorX = 0;
+			cursorY += unicodeFont->yAdvance;
+			continue;
+		}
+
+		int32_t index;
+		const GFXglyph *glyph = unicodeGlyph(codepoint, index);
+		if (codepoint == '\r' || glyph == NULL)
+		{
+			continue;
+		}
+
+		if (glyph->width > 0 && glyph->height > 0)
+		{
+			minX = std::min(minX, (int16_t)(cursorX + glyph->xOffset));
+			minY = std::min(minY, (int16_t)(cursorY + glyph->yOffset));
+			maxX = std::max(maxX, (int16_t)(cursorX + glyph->xOffset + glyph->width - 1));
+			maxY = std::max(maxY, (int16_t)(cursorY + glyph->yOffset + glyph->height - 1));
+		}
+		cursorX += glyph->xAdvance;
+	}
+
+	*x1 = 0;
+	*y1 = 0;
+	*w = 0;
+	*h = 0;
+	if (maxX >= minX)
+	{
+		*x1 = minX;
+		*w = maxX - minX + 1;
+	}
+	if (maxY >= minY)
+	{
+		*y1 = minY;
+		*h = maxY - minY + 1;
+	}
+}
@@ -0,0 +1,187 @@
+#include "components/row_cache.h"
+
+#include <Preferences.h>
+
+#include "config.h"
+
+// Bump whenever the layout of the index or of the stored regions changes,
+// the keys of the old version are not found anymore.
+#define ROW_CACHE_SPACE "row_cache_2"
+
+// the index is stored as the wake counter followed by the entries
+static const uint32_t indexKey = Journal::key(ROW_CACHE_SPACE "_index", 0);
+
+// the cache used to be kept in NVS, free the space it took up there
+static void dropNvsCache()
+{
+	Preferences prefs;
+	if (prefs.begin("row_cache", true))
+	{
+		bool stale = prefs.isKey("version");
+		prefs.end();
+		if (stale && prefs.begin("row_cache", false))
+		{
+			prefs.clear();
+			prefs.end();
+		}
+	}
+}
+
+void RowCache::begin()
+{
+	if (open || budget == 0)
+	{
+		return;
+	}
+
+	journal = &Journal::shared();
+	if (!journal->isOpen())
+	{
+		return;
+	}
+	open = true;
+	dropNvsCache();
+
+	size_t len = 0;
+	const uint8_t *stored = journal->get(indexKey, len);
+	wake = 1;
+	index.clear();
+	if (stored != NULL && len >= sizeof(uint32_t))
+	{
+		wake = *(const uint32_t *)stored + 1;
+		index.resize((len - sizeof(uint32_t)) / sizeof(Entry));
+		memcpy(index.data(), stored + sizeof(uint32_t), index.size() * sizeof(Entry));
+	}
+	changed = false;
+
+	// the budget may have been lowered since the cache was written
+	evict(0);
+
+#if DEBUG_LEVEL >= 1
+	Serial.printf("[debug] row cache: %d regions\n", index.size());
+#endif
+}
+
+void RowCache::end()
+{
+	if (!open)
+	{
+		return;
+	}
+
+	if (changed)
+	{
+		std::vector<uint8_t> data(sizeof(uint32_t) + index.size() * sizeof(Entry));
+		memcpy(data.data(), &wake, sizeof(uint32_t));
+		memcpy(data.data() + sizeof(uint32_t), index.data(), index.size() * sizeof(Entry));
+		journal->put(indexKey, data.data(), data.size());
+	}
+
+	open = false;
+}
+
+std::vector<RowCache::Entry>::iterator RowCache::find(uint32_t key)
+{
+	for (std::vector<Entry>::iterator it = index.begin(); it != index.end(); it++)
+	{
+		if (it->key == key)
+		{
+			return it;
+		}
+	}
+	return index.end();
+}
+
+void RowCache::remove(std::vector<Entry>::iterator entry)
+{
+	journal->remove(Journal::key(ROW_CACHE_SPACE, entry->key));
+	index.erase(entry);
+	changed = true;
+}
+
+// drops the least recently drawn regions until needed more bytes fit
+void RowCache::evict(size_t needed)
+{
+	size_t total = 0;
+	for (const Entry &entry : index)
+	{
+		total += entry.size;
+	}
+
+	while (!index.empty() && total + needed > budget)
+	{
+		std::vector<Entry>::iterator oldest = index.begin();
+		for (std::vector<Entry>::iterator it = index.begin(); it != index.end(); it++)
+		{
+			if (it->lastUsed < oldest->lastUsed)
+			{
+				oldest = it;
+			}
+		}
+
+		total -= oldest->size;
+		remove(oldest);
+	}
+}
+
+bool RowCache::draw(DisplayBuffer *buffer, uint32_t key, const Rect &r)
+{
+	if (!open)
+	{
+		return false;
+	}
+
+	std::vector<Entry>::iterator entry = find(key);
+	if (entry == index.end())
+	{
+		return false;
+	}
+
+	// copied straight from the mapped flash
+	size_t len = 0;
+	const uint8_t *data = journal->get(Journal::key(ROW_CACHE_SPACE, key), len);
+	if (data == NULL || len != entry->size || !buffer->writeRect(r, data, len))
+	{
+		Serial.printf("[error]: row cache: region %08x is damaged\n", (unsigned int)key);
+		remove(entry);
+		return false;
+	}
+
+	entry->lastUsed = wake;
+	changed = true;
+	return true;
+}
+
+void RowCache::store(DisplayBuffer *buffer, uint32_t key, const Rect &r)
+{
+	if (!open)
+	{
+		return;
+	}
+
+	std::vector<uint8_t> data;
+	if (!buffer->readRect(r, data) || data.size() > budget || data.size() > UINT16_MAX)
+	{
+		return;
+	}
+
+	std::vector<Entry>::iterator entry = find(key);
+	if (entry != index.end())
+	{
+		remove(entry);
+	}
+	evict(data.size());
+
+	if (!journal->put(Journal::key(ROW_CACHE_SPACE, key), data.data(), data.size()))
+	{
+		Serial.println("[error]: row cache: failed to store region");
+		return;
+	}
+
+	Entry added;
+	added.key = key;
+	added.lastUsed = wake;
+	added.size = data.size();
+	index.push_back(added);
+	changed = true;
+}
@@ -27,10 +27,13 @@ StatusBar::StatusBar(DisplayBuffer *buffer, calendar_client::CalendarClient *cal
 #endif
 }
 
-void StatusBar::render(time_t now) const
+void StatusBar::renderStatic() const
 {
 	buffer->drawHLine(x, y + height, width);
+}
 
+void StatusBar::render(time_t now) const
+{
 	int xOffset = 0;
 	bool drawOnLeftBound = false;
 	for (std::vector<StatusBarComponent *>::const_iterator it = leftBound.begin(); it != leftBound.end(); it++)
@@ -160,7 +163,9 @@ int WiFiStatus::getWidth() const
 
 void WiFiStatus::render(int x, int y, time_t now) const
 {
-	int rssi = WiFi.RSSI();
+	// wakes between syncs do not connect, show how the last sync went
+	const calendar_client::SyncState *lastSync = calendar_client::CalendarClient::getLastSync();
+	int rssi = WiFi.status() == WL_CONNECTED || lastSync == NULL ? WiFi.RSSI() : lastSync->rssi;
 
 #if defined(DISP_3C) || defined(DISP_7C)
 	Color fgSave;
@@ -0,0 +1,227 @@
+#include "components/strip_buffer.h"
+
+#include <string.h>
+
+#include "config.h"
+#include "rle.h"
+
+StripBuffer::StripBuffer(int16_t width, int16_t height, int16_t stripHeight, uint8_t slotCount)
+	: PageBuffer(width, height),
+	  stripHeight(stripHeight),
+	  slotCount(slotCount),
+	  slotPlaneBytes(stride * stripHeight),
+	  strips((height + stripHeight - 1) / stripHeight),
+	  useCounter(0)
+{
+	for (Strip &strip : strips)
+	{
+		strip.slot = -1;
+		strip.solid = planeBits(Color::White);
+	}
+
+	slotData = (uint8_t *)malloc(slotCount * DISP_PLANES * slotPlaneBytes);
+	slotStrip = (int16_t *)malloc(slotCount * sizeof(int16_t));
+	slotUsed = (uint32_t *)malloc(slotCount * sizeof(uint32_t));
+	slotDirty = (bool *)malloc(slotCount * sizeof(bool));
+
+	for (uint8_t i = 0; i < slotCount; i++)
+	{
+		slotStrip[i] = -1;
+		slotUsed[i] = 0;
+		slotDirty[i] = false;
+	}
+}
+
+StripBuffer::~StripBuffer()
+{
+	free(slotData);
+	free(slotStrip);
+	free(slotUsed);
+	free(slotDirty);
+}
+
+// Makes sure the strip is decoded into a slot and returns the slot. If all
+// slots are taken, the least recently used strip is encoded again first.
+int8_t StripBuffer::open(int16_t strip, bool write)
+{
+	int8_t slot = strips[strip].slot;
+
+	if (slot < 0)
+	{
+		slot = 0;
+		for (uint8_t i = 0; i < slotCount; i++)
+		{
+			if (slotStrip[i] < 0)
+			{
+				slot = i;
+				break;
+			}
+			if (slotUsed[i] < slotUsed[slot])
+			{
+				slot = i;
+			}
+		}
+
+		if (slotStrip[slot] >= 0)
+		{
+			close(slot);
+		}
+
+		const Strip &s = strips[strip];
+		uint8_t *data = slotData + slot * DISP_PLANES * slotPlaneBytes;
+		size_t bytes = stripRows(strip) * stride;
+
+		if (s.solid != NotSolid)
+		{
+			for (uint8_t p = 0; p < DISP_PLANES; p++)
+			{
+				memset(data + p * slotPlaneBytes, ((s.solid >> p) & 1) ? 0xFF : 0x00, bytes);
+			}
+		}
+		else
+		{
+			rle::Decoder decoder;
+			decoder.reset(s.data.data(), s.data.size());
+			for (uint8_t p = 0; p < DISP_PLANES; p++)
+			{
+				if (decoder.read(data + p * slotPlaneBytes, bytes) != bytes)
+				{
+					Serial.printf("[error]: strip %d is truncated\n", strip);
+				}
+			}
+		}
+
+		strips[strip].slot = slot;
+		slotStrip[slot] = strip;
+		slotDirty[slot] = false;
+	}
+
+	slotUsed[slot] = ++useCounter;
+	slotDirty[slot] |= write;
+	return slot;
+}
+
+// Frees the slot. Strips that were drawn to are encoded again, or reduced
+// to their color if nothing but a single color is left.
+void StripBuffer::close(int8_t slot)
+{
+	Strip &strip = strips[slotStrip[slot]];
+
+	if (slotDirty[slot])
+	{
+		const uint8_t *data = slotData + slot * DISP_PLANES * slotPlaneBytes;
+		size_t bytes = stripRows(slotStrip[slot]) * stride;
+
+		uint8_t solid = 0;
+		for (uint8_t p = 0; p < DISP_PLANES && solid != NotSolid; p++)
+		{
+			const uint8_t *plane = data + p * slotPlaneBytes;
+			if (plane[0] != 0x00 && plane[0] != 0xFF)
+			{
+				solid = NotSolid;
+				break;
+			}
+			for (size_t i = 1; i < bytes; i++)
+			{
+				if (plane[i] != plane[0])
+				{
+					solid = NotSolid;
+					break;
+				}
+			}
+			if (solid != NotSolid)
+			{
+				solid |= (plane[0] & 1) << p;
+			}
+		}
+
+		strip.solid = solid;
+		strip.data.clear();
+		if (solid == NotSolid)
+		{
+			for (uint8_t p = 0; p < DISP_PLANES; p++)
+			{
+				rle::encode(data + p * slotPlaneBytes, bytes, strip.data);
+			}
+		}
+		strip.data.shrink_to_fit();
+	}
+
+	strip.slot = -1;
+	slotStrip[slot] = -1;
+	slotDirty[slot] = false;
+}
+
+uint8_t *StripBuffer::rowData(uint8_t plane, int16_t y)
+{
+	int16_t strip = y / stripHeight;
+	int8_t slot = open(strip, true);
+
+	return slotData + (slot * DISP_PLANES + plane) * slotPlaneBytes + (y - strip * stripHeight) * stride;
+}
+
+const uint8_t *StripBuffer::rows(uint8_t plane, int16_t y, int16_t &h)
+{
+	if (y < 0 || y >= HEIGHT)
+	{
+		return NULL;
+	}
+
+	int16_t strip = y / stripHeight;
+	int8_t slot = open(strip, false);
+
+	h = std::min(h, (int16_t)(strip * stripHeight + stripRows(strip) - y));
+	return slotData + (slot * DISP_PLANES + plane) * slotPlaneBytes + (y - strip * stripHeight) * stride;
+}
+
+// Strips that are covered completely by a full width fill become solid,
+// without decoding or encoding anything. This is what makes clearing the
+// frame cheap.
+void StripBuffer::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+	int16_t x0 = x, y0 = y, x1 = x + w, y1 = y + h;
+	if (w <= 0 || h <= 0 || !clip(x0, y0, x1, y1))
+	{
+		return;
+	}
+
+	if (x0 > 0 || x1 < WIDTH)
+	{
+		PageBuffer::fillRect(x0, y0, x1 - x0, y1 - y0, color);
+		return;
+	}
+
+	for (int16_t strip = y0 / stripHeight; strip * stripHeight < y1; strip++)
+	{
+		int16_t top = strip * stripHeight;
+		int16_t bottom = top + stripRows(strip);
+
+		if (y0 > top || y1 < bottom)
+		{
+			int16_t from = std::max(y0, top);
+			PageBuffer::fillRect(x0, from, x1 - x0, std::min(y1, bottom) - from, color);
+			continue;
+		}
+
+		Strip &s = strips[strip];
+		if (s.slot >= 0)
+		{
+			slotStrip[s.slot] = -1;
+			slotDirty[s.slot] = false;
+			s.slot = -1;
+		}
+		s.solid = planeBits(color);
+		s.data.clear();
+		s.data.shrink_to_fit();
+	}
+}
+
+size_t StripBuffer::getEncodedSize() const
+{
+	size_t size = 0;
+	for (const Strip &strip : strips)
+	{
+		size += strip.data.capacity();
+	}
+	return size;
+}
@@ -0,0 +1,203 @@
+#include "components/vector_icon.h"
+
+#include <algorithm>
+#include <math.h>
+
+// Reads a zigzag encoded varint, false at the end of the data.
+static bool readValue(const uint8_t *data, size_t len, size_t &pos, int32_t &value)
+{
+	uint32_t v = 0;
+	for (uint8_t shift = 0; shift < 32; shift += 7)
+	{
+		if (pos >= len)
+		{
+			return false;
+		}
+
+		uint8_t b = data[pos++];
+		v |= (uint32_t)(b & 0x7F) << shift;
+		if (!(b & 0x80))
+		{
+			value = (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool VectorIcon::draw(PageBuffer &page, const uint8_t *data, size_t len, int16_t x, int16_t y, uint16_t size, uint16_t color)
+{
+	if (data == NULL || !page.intersectsBand(y, size))
+	{
+		return data != NULL;
+	}
+
+	Edges outline;
+	float scale = (float)size / Units;
+	int32_t ux = 0, uy = 0;
+	float p[6];
+	size_t pos = 0;
+
+	while (pos < len)
+	{
+		uint8_t command = data[pos++];
+		if (command > Close)
+		{
+			return false;
+		}
+
+		uint8_t points = command == Cubic ? 3 : (command == Close ? 0 : 1);
+		for (uint8_t i = 0; i < points; i++)
+		{
+			int32_t dx, dy;
+			if (!readValue(data, len, pos, dx) || !readValue(data, len, pos, dy))
+			{
+				return false;
+			}
+			ux += dx;
+			uy += dy;
+			p[2 * i] = x + ux * scale;
+			p[2 * i + 1] = y + uy * scale;
+		}
+
+		switch (command)
+		{
+		case Move:
+			outline.moveTo(p[0], p[1]);
+			break;
+		case Line:
+			outline.lineTo(p[0], p[1]);
+			break;
+		case Cubic:
+			outline.cubicTo(p[0], p[1], p[2], p[3], p[4], p[5]);
+			break;
+		case Close:
+			outline.close();
+			break;
+		}
+	}
+	// contours are filled as if they were closed
+	outline.close();
+
+	fill(page, outline.edges, color);
+	return true;
+}
+
+void VectorIcon::Edges::moveTo(float x, float y)
+{
+	close();
+	startX = curX = x;
+	startY = curY = y;
+}
+
+void VectorIcon::Edges::lineTo(float x, float y)
+{
+	float x0 = curX, y0 = curY, x1 = x, y1 = y;
+	curX = x;
+	curY = y;
+
+	if (y0 > y1)
+	{
+		std::swap(x0, x1);
+		std::swap(y0, y1);
+	}
+
+	// the rows whose center lies within [y0, y1), none for horizontal edges
+	int16_t r0 = (int16_t)ceilf(y0 - 0.5f);
+	int16_t r1 = (int16_t)ceilf(y1 - 0.5f);
+	if (r0 >= r1)
+	{
+		return;
+	}
+
+	Edge edge;
+	edge.dxdy = (x1 - x0) / (y1 - y0);
+	edge.x = x0 + (r0 + 0.5f - y0) * edge.dxdy;
+	edge.y0 = r0;
+	edge.y1 = r1;
+	edges.push_back(edge);
+}
+
+// The curve is cut into as many lines as it takes to stay within a quarter
+// pixel of it (Wang's formula).
+void VectorIcon::Edges::cubicTo(float x1, float y1, float x2, float y2, float x, float y)
+{
+	float x0 = curX, y0 = curY;
+	float ddx = std::max(fabsf(x0 - 2 * x1 + x2), fabsf(x1 - 2 * x2 + x));
+	float ddy = std::max(fabsf(y0 - 2 * y1 + y2), fabsf(y1 - 2 * y2 + y));
+	int16_t n = (int16_t)std::min(64.0f, std::max(1.0f, ceilf(sqrtf(3.0f * sqrtf(ddx * ddx + ddy * ddy)))));
+
+	for (int16_t i = 1; i < n; i++)
+	{
+		float t = (float)i / n, s = 1 - t;
+		float a = s * s * s, b = 3 * s * s * t, c = 3 * s * t * t, d = t * t * t;
+		lineTo(a * x0 + b * x1 + c * x2 + d * x, a * y0 + b * y1 + c * y2 + d * y);
+	}
+	lineTo(x, y);
+}
+
+// Scanline fill with an active edge list: the edges crossing the center of
+// a row are intersected with it, and the pixels between every other pair of
+// crossings are filled.
+void VectorIcon::fill(PageBuffer &page, std::vector<Edge> &edges, uint16_t color)
+{
+	if (edges.empty())
+	{
+		return;
+	}
+
+	std::sort(edges.begin(), edges.end(), [](const Edge &a, const Edge &b)
+			  { return a.y0 < b.y0; });
+
+	int16_t bottom = edges[0].y1;
+	for (const Edge &edge : edges)
+	{
+		bottom = std::max(bottom, edge.y1);
+	}
+
+	int16_t top = std::max(edges[0].y0, page.getBandY());
+	bottom = std::min(bottom, (int16_t)(page.getBandY() + page.getBandHeight()));
+
+	std::vector<Edge> active;
+	std::vector<float> crossings;
+	size_t next = 0;
+
+	for (int16_t row = top; row < bottom; row++)
+	{
+		for (; next < edges.size() && edges[next].y0 <= row; next++)
+		{
+			// edges starting above the band are moved down to this row
+			Edge edge = edges[next];
+			if (edge.y1 > row)
+			{
+				edge.x += (row - edge.y0) * edge.dxdy;
+				active.push_back(edge);
+			}
+		}
+
+		crossings.clear();
+		for (size_t i = 0; i < active.size();)
+		{
+			if (active[i].y1 <= row)
+			{
+				active[i] = active.back();
+				active.pop_back();
+				continue;
+			}
+			crossings.push_back(active[i].x);
+			active[i].x += active[i].dxdy;
+			i++;
+		}
+
+		std::sort(crossings.begin(), crossings.end());
+		for (size_t i = 0; i + 1 < crossings.size(); i += 2)
+		{
+			int16_t x0 = (int16_t)ceilf(crossings[i] - 0.5f);
+			int16_t x1 = (int16_t)ceilf(crossings[i + 1] - 0.5f);
+			if (x1 > x0)
+			{
+				page.fillRect(x0, row, x1 - x0, 1, color);
+			}
+		}
+	}
+}
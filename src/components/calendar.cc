@@ -6,21 +6,23 @@
 
 #include "components/calendar.h"
 #include "components/statusbar.h"
+#include "components/timeline.h"
 
 #if defined(DISP_3C) || defined(DISP_7C)
 Calendar::Calendar(DisplayBuffer *buffer, calendar_client::CalendarClient *calClient, Color accentColor)
-	: DisplayComponent(buffer, buffer->width() / 2, StatusBar::StatusBarHeight, buffer->width() / 2, buffer->height() - StatusBar::StatusBarHeight, accentColor),
+	: DisplayComponent(buffer, buffer->width() / 2, StatusBar::StatusBarHeight + Timeline::TimelineHeight, buffer->width() / 2, buffer->height() - StatusBar::StatusBarHeight - Timeline::TimelineHeight, accentColor),
 
 #else
 Calendar::Calendar(DisplayBuffer *buffer, calendar_client::CalendarClient *calClient)
-	: DisplayComponent(buffer, buffer->width() / 2, StatusBar::StatusBarHeight, buffer->width() / 2, buffer->height() - StatusBar::StatusBarHeight),
+	: DisplayComponent(buffer, buffer->width() / 2, StatusBar::StatusBarHeight + Timeline::TimelineHeight, buffer->width() / 2, buffer->height() - StatusBar::StatusBarHeight - Timeline::TimelineHeight),
 #endif
 	  calClient(calClient),
-	  entryHeight(48)
+	  entryHeight(48),
+	  rowCache(ROW_CACHE_SIZE)
 {
 }
 
-bool Calendar::checkTruncatedEvents(time_t now, int *displayable, int *skipped, int *more) const
+bool Calendar::checkTruncatedEvents(const calendar_client::CalendarEntries &entries, time_t now, int *displayable, int *skipped, int *more) const
 {
 	// If there are more calendar items than fit on the display,
 	// we need to truncate them a bit so they'll fit
@@ -33,15 +35,14 @@ bool Calendar::checkTruncatedEvents(time_t now, int *displayable, int *skipped,
 		*skipped = 0;
 		*more = 0;
 
-		int calendarEntryCount = calClient->getCalendarEntries()->size();
+		int calendarEntryCount = entries.size();
 		bool skipPast = calendarEntryCount > maxCalendarEvents;
 
 #if DEBUG_LEVEL >= 1
 		Serial.printf("[debug] calendar_entries: %d (max: %d)\n", calendarEntryCount, maxCalendarEvents);
 #endif
 		int itemCntr = 0;
-		for (calendar_client::CalendarEntries::const_iterator calIt = calClient->getCalendarEntries()->begin();
-			 calIt != calClient->getCalendarEntries()->end(); calIt++)
+		for (calendar_client::CalendarEntries::const_iterator calIt = entries.begin(); calIt != entries.end(); calIt++)
 		{
 			// if we must truncate, lets hide the the calendar item after now
 			if (skipPast && calIt->getEnd() < now)
@@ -120,12 +121,15 @@ int Calendar::renderSkippedEntries(int y, int skipped, int maxEntries, String ev
 
 void Calendar::render(time_t now) const
 {
+	const calendar_client::CalendarEntries &entries = *calClient->getCalendarEntries();
 	int yOffset = y;
 
 	int maxCalendarEntries = 0;
 	int skippedMeetings = 0;
 	int moreMeetings = 0;
-	bool truncate = checkTruncatedEvents(now, &maxCalendarEntries, &skippedMeetings, &moreMeetings);
+	bool truncate = checkTruncatedEvents(entries, now, &maxCalendarEntries, &skippedMeetings, &moreMeetings);
+
+	rowCache.begin();
 
 	// If we have more meetings than we can display,
 	// at least add an indicator that there's more to come at the bottom
@@ -136,8 +140,7 @@ void Calendar::render(time_t now) const
 
 	int itemCntr = 0;
 	int drawnItems = 0;
-	for (calendar_client::CalendarEntries::const_iterator calIt = calClient->getCalendarEntries()->begin();
-		 calIt != calClient->getCalendarEntries()->end(); calIt++)
+	for (calendar_client::CalendarEntries::const_iterator calIt = entries.begin(); calIt != entries.end(); calIt++)
 	{
 		itemCntr++;
 
@@ -161,6 +164,8 @@ void Calendar::render(time_t now) const
 	{
 		yOffset += renderSkippedEntries(yOffset, moreMeetings, maxCalendarEntries, TXT_UPCOMINT_EVENTS, skippedMeetings > 0);
 	}
+
+	rowCache.end();
 }
 
 int Calendar::renderCalendarEntry(int x, int y, const calendar_client::CalendarEntry &entry, time_t now) const
@@ -172,31 +177,44 @@ int Calendar::renderCalendarEntry(int x, int y, const calendar_client::CalendarE
 	Serial.printf("[verbose] rendering_calendar entry: %s. is_important: %d, is_current: %d, is_past: %d\n", entry.getTitle().c_str(), entry.isImportant(), isCurrentEvent, isPastEvent);
 #endif
 
+	// the entry without the separator line above it, which belongs to
+	// whatever is drawn above
+	Rect r;
+	r.x = x;
+	r.y = y + 1;
+	r.width = width;
+	r.height = entryHeight - 1;
+
+	uint32_t key = entryKey(entry, isPastEvent, isCurrentEvent);
+	if (!rowCache.draw(buffer, key, r))
+	{
 #if defined(DISP_3C) || defined(DISP_7C)
-	Color fgSave;
+		Color fgSave;
 #endif
 
-	if (isCurrentEvent)
-	{
 #if defined(DISP_3C) || defined(DISP_7C)
-		fgSave = buffer->setForegroundColor(accentColor);
-#elif defined(INVERT_AS_ACCENT) && INVERT_AS_ACCENT == true
-		buffer->invert();
-		buffer->fillBackground(x, y, width, entryHeight);
+		if (isCurrentEvent)
+		{
+			fgSave = buffer->setForegroundColor(accentColor);
+		}
 #endif
-	}
 
-	renderCalendarEntryIcon(x, y, entry, isPastEvent, isCurrentEvent);
-	renderCalendarEntryTitle(x + entryHeight, y, entry, isPastEvent);
-	renderCalendarEntryTime(x + entryHeight, y + entryHeight, entry, isPastEvent);
+		renderCalendarEntryIcon(x, y, entry, isPastEvent, isCurrentEvent);
+		renderCalendarEntryTitle(x + entryHeight, y, entry, isPastEvent);
+		renderCalendarEntryTime(x + entryHeight, y + entryHeight, entry, isPastEvent);
 
-	if (isCurrentEvent)
-	{
+		if (isCurrentEvent)
+		{
 #if defined(DISP_3C) || defined(DISP_7C)
-		buffer->setForegroundColor(fgSave);
+			buffer->setForegroundColor(fgSave);
 #elif defined(INVERT_AS_ACCENT) && INVERT_AS_ACCENT == true
-		buffer->invert();
+			// the entry is drawn as usual and flipped as a whole afterwards,
+			// sparing the separator lines above and left of it
+			buffer->invertRect(x + 1, y + 1, width - 1, entryHeight - 1);
 #endif
+		}
+
+		rowCache.store(buffer, key, r);
 	}
 
 	buffer->drawHLine(x, y + entryHeight, width);
@@ -204,6 +222,34 @@ int Calendar::renderCalendarEntry(int x, int y, const calendar_client::CalendarE
 	return entryHeight;
 }
 
+// Identifies how an entry looks when rendered. The fonts and icons are part
+// of the key; bump the version whenever the code rendering the entries
+// changes.
+uint32_t Calendar::entryKey(const calendar_client::CalendarEntry &entry, bool isPast, bool isCurrent) const
+{
+	const uint8_t version = 2;
+	time_t start = entry.getStart();
+	time_t end = entry.getEnd();
+	uint8_t flags = isPast | (isCurrent << 1) | (entry.isImportant() << 2);
+	uint16_t colors[] = {buffer->getForegroundColor(), buffer->getBackgroundColor(),
+#if defined(DISP_3C) || defined(DISP_7C)
+						 accentColor
+#endif
+	};
+	int16_t layout[] = {(int16_t)width, (int16_t)entryHeight};
+	uint32_t assets[] = {DisplayBuffer::fontKey(12), DisplayBuffer::fontKey(9), getIconPackKey()};
+
+	uint32_t key = fnv1a(&version, sizeof(version));
+	key = fnv1a(entry.getTitle(), key);
+	key = fnv1a(&start, sizeof(start), key);
+	key = fnv1a(&end, sizeof(end), key);
+	key = fnv1a(&flags, sizeof(flags), key);
+	key = fnv1a(colors, sizeof(colors), key);
+	key = fnv1a(layout, sizeof(layout), key);
+	key = fnv1a(assets, sizeof(assets), key);
+	return key;
+}
+
 void Calendar::renderCalendarEntryIcon(int x, int y, const calendar_client::CalendarEntry &entry, bool isPast, bool isCurrent) const
 {
 	int offsetX = x;
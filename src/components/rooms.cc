@@ -0,0 +1,102 @@
+#include "components/rooms.h"
+#include "components/statusbar.h"
+#include "config.h"
+#include "utils.h"
+
+#if defined(DISP_3C) || defined(DISP_7C)
+Rooms::Rooms(DisplayBuffer *buffer, calendar_client::CalendarClient *calClient, Color accentColor)
+	: DisplayComponent(buffer, 0, StatusBar::StatusBarHeight, buffer->width(), buffer->height() - StatusBar::StatusBarHeight, accentColor),
+#else
+Rooms::Rooms(DisplayBuffer *buffer, calendar_client::CalendarClient *calClient)
+	: DisplayComponent(buffer, 0, StatusBar::StatusBarHeight, buffer->width(), buffer->height() - StatusBar::StatusBarHeight),
+#endif
+	  calClient(calClient),
+	  columns(calendar_client::CalendarClient::getRoomCount())
+{
+}
+
+static String timeOf(time_t t)
+{
+	tm timeInfo = *localtime(&t);
+	return getTimeStr(&timeInfo);
+}
+
+void Rooms::renderStatic() const
+{
+	int columnWidth = width / columns;
+	for (int i = 1; i < columns; i++)
+	{
+		buffer->drawVLine(x + i * columnWidth, y, height);
+	}
+	buffer->drawHLine(x, y + nameHeight, width);
+	buffer->drawHLine(x, y + height - nextHeight, width);
+}
+
+void Rooms::render(time_t now) const
+{
+	int columnWidth = width / columns;
+	for (int i = 0; i < columns; i++)
+	{
+		const calendar_client::RoomSummary *room = calClient->getRoomSummary(i);
+		if (room != NULL)
+		{
+			renderRoom(x + i * columnWidth, *room, now);
+		}
+	}
+}
+
+void Rooms::renderRoom(int x, const calendar_client::RoomSummary &room, time_t now) const
+{
+	int columnWidth = width / columns;
+	int textWidth = columnWidth - 2 * padding;
+	int centerX = x + columnWidth / 2;
+
+	buffer->setFontSize(12);
+	buffer->drawString(centerX, y + nameHeight / 2, room.name, Alignment::Center, textWidth, 1);
+
+	// the state of the room, between the rules
+	int stateY = y + nameHeight;
+	int stateHeight = height - nameHeight - nextHeight;
+	String state = room.isFree() ? String(TXT_FREE) : String(room.current);
+	String until;
+	if (!room.isFree())
+	{
+		until = String(TXT_UNTIL) + " " + timeOf(room.freeFrom);
+	}
+	else if (room.freeUntil != LONG_MAX && room.freeUntil < calendar_client::DayOccupancy::startOfDay(now, 1))
+	{
+		until = String(TXT_UNTIL) + " " + timeOf(room.freeUntil);
+	}
+
+	Color fgSave = buffer->getForegroundColor();
+	if (room.important)
+	{
+#if defined(DISP_3C) || defined(DISP_7C)
+		buffer->setForegroundColor(accentColor);
+#endif
+		buffer->drawRect(x + padding, stateY + padding, columnWidth - 2 * padding, stateHeight - 2 * padding, 4);
+	}
+
+	buffer->setFontSize(room.isFree() ? 24 : 18);
+	TextSize *stateSize = buffer->getStringBounds(state, textWidth - 2 * padding, 3);
+	int stateTextHeight = stateSize != NULL ? stateSize->height : 0;
+	int blockY = stateY + stateHeight / 2 - (stateTextHeight + (until.isEmpty() ? 0 : 20)) / 2;
+	buffer->drawString(centerX, blockY, state, Alignment::HorizontalCenter | Alignment::Top, textWidth - 2 * padding, 3);
+
+	if (!until.isEmpty())
+	{
+		buffer->setFontSize(12);
+		buffer->drawString(centerX, blockY + stateTextHeight + 4, until, Alignment::HorizontalCenter | Alignment::Top, textWidth, 1);
+	}
+	buffer->setForegroundColor(fgSave);
+
+	// the next meeting
+	if (room.next[0] != '\0')
+	{
+		int nextY = y + height - nextHeight + padding;
+		buffer->setFontSize(9);
+		buffer->drawString(x + padding, nextY, String(TXT_NEXT) + " " + timeOf(room.nextStart), Alignment::Top | Alignment::Left, textWidth, 1);
+		buffer->setFontSize(12);
+		buffer->drawString(x + padding, nextY + 18, room.next, Alignment::Top | Alignment::Left, textWidth, 1);
+	}
+}
@@ -1,13 +1,14 @@
 #include "components/status.h"
 #include "components/statusbar.h"
+#include "components/timeline.h"
 #include "config.h"
 
 #if defined(DISP_3C) || defined(DISP_7C)
 Status::Status(DisplayBuffer *buffer, calendar_client::CalendarClient *calClient, Color accentColor)
-	: DisplayComponent(buffer, 0, StatusBar::StatusBarHeight, buffer->width() / 2, buffer->height() - StatusBar::StatusBarHeight, accentColor),
+	: DisplayComponent(buffer, 0, StatusBar::StatusBarHeight + Timeline::TimelineHeight, buffer->width() / 2, buffer->height() - StatusBar::StatusBarHeight - Timeline::TimelineHeight, accentColor),
 #else
 Status::Status(DisplayBuffer *buffer, calendar_client::CalendarClient *calClient)
-	: DisplayComponent(buffer, 0, StatusBar::StatusBarHeight, buffer->width() / 2, buffer->height() - StatusBar::StatusBarHeight),
+	: DisplayComponent(buffer, 0, StatusBar::StatusBarHeight + Timeline::TimelineHeight, buffer->width() / 2, buffer->height() - StatusBar::StatusBarHeight - Timeline::TimelineHeight),
 #endif
 	  calClient(calClient)
 
@@ -58,9 +59,6 @@ void Status::render(time_t now) const
 
 #if defined(DISP_3C) || defined(DISP_7C)
 		buffer->setForegroundColor(accentColor);
-#elif defined(INVERT_AS_ACCENT) && INVERT_AS_ACCENT == true
-		buffer->invert();
-		buffer->fillBackground(x, y, width, height);
 #endif
 
 		buffer->drawRect(x + 20, y + 20, width - 40, height - 40, 10);
@@ -95,6 +93,15 @@ void Status::render(time_t now) const
 
 	buffer->drawString(startX, startY, statusMsg, alignment, maxTextWidth, 3);
 
+#if defined(INVERT_AS_ACCENT) && INVERT_AS_ACCENT == true
+	// the card is drawn as usual and flipped as a whole afterwards,
+	// sparing the status bar separator in the first row
+	if (isImportant)
+	{
+		buffer->invertRect(x, y + 1, width, height - 1);
+	}
+#endif
+
 	// reset display color
 	buffer->setForegroundColor(fgSave);
 	buffer->setBackgroundColor(bgSave);
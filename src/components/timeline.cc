@@ -0,0 +1,96 @@
+#include "components/timeline.h"
+#include "components/statusbar.h"
+#include "config.h"
+
+#if defined(DISP_3C) || defined(DISP_7C)
+Timeline::Timeline(DisplayBuffer *buffer, Color accentColor)
+	: DisplayComponent(buffer, 0, StatusBar::StatusBarHeight, buffer->width(), TimelineHeight, accentColor)
+#else
+Timeline::Timeline(DisplayBuffer *buffer)
+	: DisplayComponent(buffer, 0, StatusBar::StatusBarHeight, buffer->width(), TimelineHeight)
+#endif
+{
+}
+
+int Timeline::minuteX(int minute) const
+{
+	const int first = TIMELINE_START * 60;
+	const int last = TIMELINE_END * 60;
+	minute = std::min(std::max(minute, first), last);
+	return x + padding + (minute - first) * (width - 2 * padding) / (last - first);
+}
+
+// the hour ticks below the bar and the separator
+void Timeline::renderStatic() const
+{
+	int tickY = y + 2 + barHeight + 1;
+	for (int hour = TIMELINE_START; hour <= TIMELINE_END; hour++)
+	{
+		buffer->drawVLine(minuteX(hour * 60), tickY, y + height - tickY - 1);
+	}
+	buffer->drawHLine(x, y + height, width);
+}
+
+// Fills the runs of set minutes of a plane within the bar, each as a single
+// span, or hatched with a vertical line every third pixel.
+void Timeline::renderRuns(const uint32_t *plane, int barY, bool hatched) const
+{
+	uint16_t end = TIMELINE_START * 60;
+	uint16_t start = calendar_client::DayOccupancy::findRun(plane, end, end);
+	while (start < TIMELINE_END * 60)
+	{
+		int x0 = minuteX(start);
+		int x1 = std::max(minuteX(end), x0 + 1);
+
+		if (hatched)
+		{
+			for (int hatchX = x0 + (3 - x0 % 3) % 3; hatchX < x1; hatchX += 3)
+			{
+				buffer->drawVLine(hatchX, barY, barHeight - 1);
+			}
+		}
+		else
+		{
+			buffer->fillRect(x0, barY, x1 - x0, barHeight);
+		}
+
+		start = calendar_client::DayOccupancy::findRun(plane, end, end);
+	}
+}
+
+void Timeline::render(time_t now) const
+{
+	if (!buffer->isVisible(y, height))
+	{
+		return;
+	}
+
+	int barY = y + 2;
+	buffer->drawRect(x + padding, barY, width - 2 * padding + 1, barHeight);
+
+	const calendar_client::DayOccupancy *day = calendar_client::CalendarClient::getOccupancy(now);
+	if (day == NULL)
+	{
+		return;
+	}
+
+	renderRuns(day->tentative, barY, true);
+	renderRuns(day->busy, barY, false);
+
+#if defined(DISP_3C) || defined(DISP_7C)
+	// important times stand out in the accent color
+	Color fgSave = buffer->setForegroundColor(accentColor);
+	renderRuns(day->important, barY, false);
+	buffer->setForegroundColor(fgSave);
+#endif
+
+	// now is marked by a notch that sticks out of the bar on both sides
+	int minute = day->minuteOf(now);
+	if (minute >= TIMELINE_START * 60 && minute <= TIMELINE_END * 60)
+	{
+		int nowX = minuteX(minute);
+		buffer->invertRect(nowX - 1, barY, 3, barHeight);
+		buffer->fillRect(nowX - 1, y, 3, 2);
+		buffer->fillRect(nowX - 1, barY + barHeight, 3, 1);
+	}
+}
@@ -0,0 +1,29 @@
+#include "crc.h"
+
+// half a byte at a time, to keep the table small
+uint32_t crc::crc32(const void *data, size_t len, uint32_t seed)
+{
+	static const uint32_t table[16] = {
+		0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+		0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c, 0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c};
+
+	const uint8_t *bytes = (const uint8_t *)data;
+	uint32_t crc = ~seed;
+	for (size_t i = 0; i < len; i++)
+	{
+		crc = (crc >> 4) ^ table[(crc ^ bytes[i]) & 0x0f];
+		crc = (crc >> 4) ^ table[(crc ^ (bytes[i] >> 4)) & 0x0f];
+	}
+	return ~crc;
+}
+
+uint32_t fnv1a(const void *data, size_t len, uint32_t seed)
+{
+	const uint8_t *bytes = (const uint8_t *)data;
+	uint32_t h = seed;
+	for (size_t i = 0; i < len; i++)
+	{
+		h = (h ^ bytes[i]) * 16777619u;
+	}
+	return h;
+}
@@ -1,8 +1,12 @@
 #include "display.h"
 
+#include <Preferences.h>
+
 #include "components/statusbar.h"
 #include "components/calendar.h"
 #include "components/status.h"
+#include "components/timeline.h"
+#include "components/rooms.h"
 
 #include "config.h"
 
@@ -16,22 +20,37 @@ Display::Display(int8_t pin_epd_pwr, int8_t pin_epd_sck, int8_t pin_epd_miso, in
 	  pin_epd_miso(pin_epd_miso),
 	  pin_epd_mosi(pin_epd_mosi),
 	  pin_epd_cs(pin_epd_cs),
+	  timeline(NULL),
+	  calendar(NULL),
+	  statusIndicator(NULL),
+	  rooms(NULL),
 	  calClient(calClient),
 	  initialized(false)
 {
 	// initialize power pin as output pin
 	pinMode(pin_epd_pwr, OUTPUT);
 	buffer = new DisplayBuffer(pin_epd_cs, pin_epd_dc, pin_epd_rst, pin_epd_busy);
+	buffer->setBusyCallback(&Display::_onBusy, this);
 
 #if defined(DISP_3C) || defined(DISP_7C)
 	statusBar = new StatusBar(buffer, calClient, accentColor);
+#ifdef MULTI_ROOM
+	rooms = new Rooms(buffer, calClient, accentColor);
+#else
+	timeline = new Timeline(buffer, accentColor);
 	calendar = new Calendar(buffer, calClient, accentColor);
 	statusIndicator = new Status(buffer, calClient, accentColor);
+#endif
 #else
 	statusBar = new StatusBar(buffer, calClient);
+#ifdef MULTI_ROOM
+	rooms = new Rooms(buffer, calClient);
+#else
+	timeline = new Timeline(buffer);
 	calendar = new Calendar(buffer, calClient);
 	statusIndicator = new Status(buffer, calClient);
 #endif
+#endif
 }
 
 void Display::init()
@@ -52,13 +71,47 @@ void Display::init()
 	initialized = true;
 }
 
+// Invoked by the epd driver over and over while it waits for BUSY to release.
+// Each invocation runs at most one pending task, so the driver gets to check
+// the BUSY line in between.
+void Display::_onBusy(const void *display)
+{
+	Display *self = (Display *)display;
+	if (self->refreshTasks.empty())
+	{
+		delay(1);
+		return;
+	}
+
+	std::function<void()> task = self->refreshTasks.front();
+	self->refreshTasks.erase(self->refreshTasks.begin());
+	task();
+}
+
+void Display::runRefreshTasks()
+{
+	while (!refreshTasks.empty())
+	{
+		std::function<void()> task = refreshTasks.front();
+		refreshTasks.erase(refreshTasks.begin());
+		task();
+	}
+}
+
 void Display::powerOff()
 {
+	// if the refresh finished before all tasks got their turn, run them now
+	runRefreshTasks();
+
 	if (!initialized)
 	{
 		return;
 	}
 
+	// the tasks may have outlasted the driver's busy timeout, so make sure
+	// the refresh has actually finished before sending any further commands
+	buffer->waitWhileBusy();
+
 	// turns powerOff() and sets controller to deep sleep
 	// for minimum power use, ONLY if wakeable by RST (rst >= 0)
 	buffer->hibernate();
@@ -68,13 +121,79 @@ void Display::powerOff()
 	initialized = false;
 }
 
+// Identifies the layout of the static layer. Bump the version whenever
+// something in the renderStatic() methods changes.
+static uint32_t staticLayerKey(DisplayBuffer *buffer)
+{
+	const uint32_t version = 4;
+#ifdef MULTI_ROOM
+	const uint32_t rooms = calendar_client::CalendarClient::getRoomCount();
+#else
+	const uint32_t rooms = 0;
+#endif
+	int32_t layout[] = {DISP_PLANES, StatusBar::StatusBarHeight, Timeline::TimelineHeight, TIMELINE_START, TIMELINE_END, buffer->width(), buffer->height()};
+
+	uint32_t key = fnv1a(&version, sizeof(version));
+	key = fnv1a(&rooms, sizeof(rooms), key);
+	key = fnv1a(layout, sizeof(layout), key);
+	return key;
+}
+
+void Display::loadStaticLayer()
+{
+	Preferences prefs;
+	prefs.begin(NVS_NAMESPACE, false);
+
+	uint32_t key = staticLayerKey(buffer);
+	size_t len = prefs.getBytesLength("staticLayer");
+
+	if (prefs.getUInt("staticLayerKey", 0) == key && len > 0)
+	{
+		staticLayer.resize(len);
+		prefs.getBytes("staticLayer", staticLayer.data(), len);
+	}
+	else
+	{
+		// first boot with this layout, compose the layer once and keep it
+		buffer->composeStaticLayer([this]()
+								   { _renderStatic(); },
+								   staticLayer);
+		prefs.putBytes("staticLayer", staticLayer.data(), staticLayer.size());
+		prefs.putUInt("staticLayerKey", key);
+	}
+
+	prefs.end();
+}
+
+void Display::_renderStatic() const
+{
+	statusBar->renderStatic();
+	if (rooms != NULL)
+	{
+		rooms->renderStatic();
+		return;
+	}
+
+	timeline->renderStatic();
+	calendar->renderStatic();
+	statusIndicator->renderStatic();
+
+	buffer->drawVLine(buffer->width() / 2, StatusBar::StatusBarHeight + Timeline::TimelineHeight, buffer->height());
+}
+
+// the separators are part of the static layer, see _renderStatic()
 void Display::_render(time_t now) const
 {
 	statusBar->render(now);
+	if (rooms != NULL)
+	{
+		rooms->render(now);
+		return;
+	}
+
+	timeline->render(now);
 	calendar->render(now);
 	statusIndicator->render(now);
-
-	buffer->drawVLine(buffer->width() / 2, StatusBar::StatusBarHeight, buffer->height());
 }
 
 void Display::_fullPageStatus(String icon, int16_t iconSize, const String &title, const String &description, time_t now) const
@@ -84,6 +203,7 @@ void Display::_fullPageStatus(String icon, int16_t iconSize, const String &title
 
 	if (now != 0)
 	{
+		statusBar->renderStatic();
 		statusBar->render(now);
 		startY = StatusBar::StatusBarHeight + ((buffer->height() - StatusBar::StatusBarHeight) / 2);
 	}
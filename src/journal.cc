@@ -0,0 +1,534 @@
+#include "journal.h"
+
+#include <Arduino.h>
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <esp_idf_version.h>
+#include <esp_partition.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "config.h"
+#include "crc.h"
+
+Journal::Journal()
+	: base(NULL), size(0), handle(0), partition(NULL), sectors(0), head(0), offset(0), sequence(0)
+{
+#ifndef ARDUINO
+	faultBudget = -1;
+#endif
+}
+
+bool Journal::begin(const char *name)
+{
+	end();
+
+#ifdef ARDUINO
+	const esp_partition_t *p = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, name);
+	if (p == NULL)
+	{
+		Serial.printf("[error]: Partition '%s' not found\n", name);
+		return false;
+	}
+
+	const void *data;
+#if ESP_IDF_VERSION_MAJOR >= 5
+	esp_partition_mmap_handle_t mapHandle;
+	esp_err_t err = esp_partition_mmap(p, 0, p->size, ESP_PARTITION_MMAP_DATA, &data, &mapHandle);
+#else
+	spi_flash_mmap_handle_t mapHandle;
+	esp_err_t err = esp_partition_mmap(p, 0, p->size, SPI_FLASH_MMAP_DATA, &data, &mapHandle);
+#endif
+	if (err != ESP_OK)
+	{
+		Serial.printf("[error]: Mapping partition '%s' failed (%d)\n", name, err);
+		return false;
+	}
+
+	base = (const uint8_t *)data;
+	size = p->size;
+	handle = mapHandle;
+	partition = p;
+#else
+	char path[64];
+	snprintf(path, sizeof(path), "%s.bin", name);
+
+	// a new file is blank flash
+	int fd = open(path, O_RDWR | O_CREAT, 0644);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0)
+	{
+		Serial.printf("[error]: Journal '%s' can not be opened\n", path);
+		if (fd >= 0)
+		{
+			close(fd);
+		}
+		return false;
+	}
+	if (st.st_size == 0)
+	{
+		std::vector<uint8_t> blank(HostSize, 0xff);
+		if (::write(fd, blank.data(), blank.size()) != (ssize_t)blank.size())
+		{
+			close(fd);
+			return false;
+		}
+		st.st_size = HostSize;
+	}
+
+	void *data = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		Serial.printf("[error]: Mapping '%s' failed\n", path);
+		return false;
+	}
+
+	base = (const uint8_t *)data;
+	size = st.st_size;
+	faultBudget = -1;
+#endif
+
+	sectors = size / SectorSize;
+	if (sectors < 3 || !mount())
+	{
+		Serial.printf("[error]: Journal '%s' can not be used\n", name);
+		end();
+		return false;
+	}
+
+#if DEBUG_LEVEL >= 1
+	Serial.printf("[debug] Mapped journal '%s', %u keys, sector %u of %u\n", name, (unsigned)count(), head, sectors);
+#endif
+
+	return true;
+}
+
+void Journal::end()
+{
+	if (base == NULL)
+	{
+		return;
+	}
+
+#ifdef ARDUINO
+#if ESP_IDF_VERSION_MAJOR >= 5
+	esp_partition_munmap(handle);
+#else
+	spi_flash_munmap(handle);
+#endif
+#else
+	munmap((void *)base, size);
+#endif
+
+	base = NULL;
+	size = 0;
+	handle = 0;
+	partition = NULL;
+	index.clear();
+}
+
+Journal &Journal::shared()
+{
+	static Journal journal;
+	if (!journal.isOpen())
+	{
+		journal.begin();
+	}
+	return journal;
+}
+
+uint32_t Journal::key(const char *space, uint32_t id)
+{
+	return fnv1a(&id, sizeof(id), fnv1a(space, strlen(space)));
+}
+
+// Finds the sectors in use and replays their records, oldest first.
+bool Journal::mount()
+{
+	index.clear();
+
+	std::vector<std::pair<uint32_t, uint16_t>> used;
+	for (uint16_t sector = 0; sector < sectors; sector++)
+	{
+		if (isUsed(sector))
+		{
+			used.push_back(std::make_pair(((const SectorHeader *)(base + sector * SectorSize))->sequence, sector));
+		}
+	}
+	std::sort(used.begin(), used.end());
+
+	if (used.empty())
+	{
+		// blank or foreign partition, start over
+		SectorHeader header = {Magic, 1};
+		head = 0;
+		sequence = header.sequence;
+		offset = sizeof(SectorHeader);
+		return erase(0) && write(0, &header, sizeof(header));
+	}
+
+	head = used.back().second;
+	sequence = used.back().first;
+
+	// The sector after the head must be erased. If it is not, a compaction
+	// was cut short. If the head has all copies, only the erase is left to
+	// do, the oldest sector may already be partly erased. Otherwise the head
+	// only holds some of the copies, so drop it and compact again.
+	uint16_t oldest = (head + 1) % sectors;
+	if (used.size() > 1 && isUsed(oldest))
+	{
+		if (isCompacted(head, ((const SectorHeader *)(base + oldest * SectorSize))->sequence))
+		{
+#if DEBUG_LEVEL >= 1
+			Serial.printf("[debug] Journal: finishing erase of sector %u\n", oldest);
+#endif
+			return erase(oldest) && mount();
+		}
+
+#if DEBUG_LEVEL >= 1
+		Serial.printf("[debug] Journal: redoing compaction of sector %u\n", oldest);
+#endif
+		return erase(head) && mount() && advance();
+	}
+
+	for (size_t i = 0; i < used.size(); i++)
+	{
+		scan(used[i].second);
+	}
+	return true;
+}
+
+void Journal::scan(uint16_t sector)
+{
+	uint32_t at = sector * SectorSize + sizeof(SectorHeader);
+	uint32_t end = (sector + 1) * SectorSize;
+
+	while (at + sizeof(RecordHeader) <= end)
+	{
+		const RecordHeader *record = (const RecordHeader *)(base + at);
+		if (record->key == 0xffffffff && record->length == 0xffff && record->flags == 0xffff && record->crc == 0xffffffff)
+		{
+			// blank, the end of the records
+			break;
+		}
+
+		uint32_t next = at + recordSize(record->length);
+		if (next > end || checksum(*record, record + 1) != record->crc)
+		{
+			// cut short by a reset, nothing can be appended to this sector anymore
+#if DEBUG_LEVEL >= 1
+			Serial.printf("[debug] Journal: damaged record at %08x\n", (unsigned)at);
+#endif
+			at = end;
+			break;
+		}
+
+		if (record->flags & Tombstone)
+		{
+			removeLocation(record->key);
+		}
+		else if (!(record->flags & Compacted))
+		{
+			setLocation(record->key, at);
+		}
+		at = next;
+	}
+
+	if (sector == head)
+	{
+		offset = at;
+	}
+}
+
+// true if the sector holds the marker of a finished compaction of the
+// sector with the given sequence
+bool Journal::isCompacted(uint16_t sector, uint32_t compactedSequence) const
+{
+	uint32_t at = sector * SectorSize + sizeof(SectorHeader);
+	uint32_t end = (sector + 1) * SectorSize;
+
+	while (at + sizeof(RecordHeader) <= end)
+	{
+		const RecordHeader *record = (const RecordHeader *)(base + at);
+		uint32_t next = at + recordSize(record->length);
+		if (next > end || checksum(*record, record + 1) != record->crc)
+		{
+			// blank or damaged, the end of the records
+			return false;
+		}
+
+		if ((record->flags & Compacted) && record->key == compactedSequence)
+		{
+			return true;
+		}
+		at = next;
+	}
+	return false;
+}
+
+// Moves on to the next sector, which is always erased, and makes sure the
+// one after it is erased too, by copying what is still used in it.
+bool Journal::advance()
+{
+	uint16_t next = (head + 1) % sectors;
+	SectorHeader header = {Magic, sequence + 1};
+	if ((!isBlank(next) && !erase(next)) || !write(next * SectorSize, &header, sizeof(header)))
+	{
+		return false;
+	}
+
+	head = next;
+	sequence = header.sequence;
+	offset = head * SectorSize + sizeof(SectorHeader);
+
+	uint16_t oldest = (head + 1) % sectors;
+	return !isUsed(oldest) || compact(oldest);
+}
+
+bool Journal::compact(uint16_t sector)
+{
+	uint32_t start = sector * SectorSize;
+	uint32_t end = start + SectorSize;
+	uint32_t compactedSequence = ((const SectorHeader *)(base + start))->sequence;
+
+	std::vector<Location> live;
+	for (const Location &location : index)
+	{
+		if (location.offset >= start && location.offset < end)
+		{
+			live.push_back(location);
+		}
+	}
+
+	// the data is copied to RAM first, the mapped flash can not be read
+	// while it is written
+	std::vector<uint8_t> data;
+	for (const Location &location : live)
+	{
+		const RecordHeader *record = (const RecordHeader *)(base + location.offset);
+		data.assign((const uint8_t *)(record + 1), (const uint8_t *)(record + 1) + record->length);
+		if (!writeRecord(record->key, data.data(), data.size(), record->flags))
+		{
+			return false;
+		}
+	}
+
+	// from here on a reset only leaves the erase to be done, see mount()
+	if (!writeRecord(compactedSequence, NULL, 0, Compacted))
+	{
+		return false;
+	}
+
+#if DEBUG_LEVEL >= 1
+	Serial.printf("[debug] Journal: compacted sector %u, %u records kept\n", sector, (unsigned)live.size());
+#endif
+
+	return erase(sector);
+}
+
+const uint8_t *Journal::get(uint32_t key, size_t &length) const
+{
+	std::vector<Location>::const_iterator it = std::lower_bound(index.begin(), index.end(), key, [](const Location &location, uint32_t key)
+																{ return location.key < key; });
+	if (it == index.end() || it->key != key)
+	{
+		return NULL;
+	}
+
+	const RecordHeader *record = (const RecordHeader *)(base + it->offset);
+	length = record->length;
+	return (const uint8_t *)(record + 1);
+}
+
+bool Journal::put(uint32_t key, const void *data, size_t length)
+{
+	return append(key, data, length, 0);
+}
+
+bool Journal::remove(uint32_t key)
+{
+	size_t length;
+	return get(key, length) == NULL || append(key, NULL, 0, Tombstone);
+}
+
+bool Journal::append(uint32_t key, const void *data, size_t length, uint16_t flags)
+{
+	if (base == NULL)
+	{
+		return false;
+	}
+
+	uint32_t needed = recordSize(length);
+	if (length >= 0xffff || needed > SectorSize - sizeof(SectorHeader))
+	{
+		Serial.printf("[error]: Journal: record of %u bytes is too large\n", (unsigned)length);
+		return false;
+	}
+
+	// the copies made by a compaction may fill the next sector up again, in
+	// which case the journal holds more than it can
+	for (uint16_t i = 0; offset + needed > (uint32_t)(head + 1) * SectorSize; i++)
+	{
+		if (i == sectors - 1)
+		{
+			Serial.printf("[error]: Journal is full\n");
+			return false;
+		}
+		if (!advance())
+		{
+			return false;
+		}
+	}
+
+	return writeRecord(key, data, length, flags);
+}
+
+bool Journal::writeRecord(uint32_t key, const void *data, size_t length, uint16_t flags)
+{
+	uint32_t needed = recordSize(length);
+	if (offset + needed > (uint32_t)(head + 1) * SectorSize)
+	{
+		return false;
+	}
+
+	std::vector<uint8_t> buffer(needed, 0);
+	RecordHeader *record = (RecordHeader *)buffer.data();
+	record->key = key;
+	record->length = length;
+	record->flags = flags;
+	if (length > 0)
+	{
+		memcpy(record + 1, data, length);
+	}
+	record->crc = checksum(*record, record + 1);
+
+	if (!write(offset, buffer.data(), buffer.size()))
+	{
+		// whatever made it to flash is garbage now, do not write after it
+		offset = (head + 1) * SectorSize;
+		return false;
+	}
+
+	if (flags & Tombstone)
+	{
+		removeLocation(key);
+	}
+	else if (!(flags & Compacted))
+	{
+		setLocation(key, offset);
+	}
+	offset += needed;
+	return true;
+}
+
+uint32_t Journal::checksum(const RecordHeader &header, const void *data)
+{
+	return crc::crc32(data, header.length, crc::crc32(&header, offsetof(RecordHeader, crc)));
+}
+
+void Journal::setLocation(uint32_t key, uint32_t offset)
+{
+	std::vector<Location>::iterator it = std::lower_bound(index.begin(), index.end(), key, [](const Location &location, uint32_t key)
+														  { return location.key < key; });
+	if (it != index.end() && it->key == key)
+	{
+		it->offset = offset;
+	}
+	else
+	{
+		Location location = {key, offset};
+		index.insert(it, location);
+	}
+}
+
+void Journal::removeLocation(uint32_t key)
+{
+	std::vector<Location>::iterator it = std::lower_bound(index.begin(), index.end(), key, [](const Location &location, uint32_t key)
+														  { return location.key < key; });
+	if (it != index.end() && it->key == key)
+	{
+		index.erase(it);
+	}
+}
+
+bool Journal::isUsed(uint16_t sector) const
+{
+	return ((const SectorHeader *)(base + sector * SectorSize))->magic == Magic;
+}
+
+bool Journal::isBlank(uint16_t sector) const
+{
+	const uint32_t *words = (const uint32_t *)(base + sector * SectorSize);
+	for (uint32_t i = 0; i < SectorSize / 4; i++)
+	{
+		if (words[i] != 0xffffffff)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Flash can only clear bits, only erasing sets them again. The host stand-in
+// behaves the same, so it catches writes to places that were not erased. An
+// erase cut short on the host leaves the start of the sector, so the header
+// still claims a sector whose records are already gone, which is the worst
+// case for mount().
+bool Journal::write(uint32_t address, const void *data, size_t length)
+{
+#ifdef ARDUINO
+	esp_err_t err = esp_partition_write((const esp_partition_t *)partition, address, data, length);
+	if (err != ESP_OK)
+	{
+		Serial.printf("[error]: Journal: writing at %08x failed (%d)\n", (unsigned)address, err);
+		return false;
+	}
+	return true;
+#else
+	size_t written = length;
+	if (faultBudget >= 0)
+	{
+		written = std::min(length, (size_t)faultBudget);
+		faultBudget -= written;
+	}
+
+	uint8_t *to = (uint8_t *)base + address;
+	const uint8_t *from = (const uint8_t *)data;
+	for (size_t i = 0; i < written; i++)
+	{
+		to[i] &= from[i];
+	}
+	return written == length;
+#endif
+}
+
+bool Journal::erase(uint16_t sector)
+{
+#ifdef ARDUINO
+	esp_err_t err = esp_partition_erase_range((const esp_partition_t *)partition, sector * SectorSize, SectorSize);
+	if (err != ESP_OK)
+	{
+		Serial.printf("[error]: Journal: erasing sector %u failed (%d)\n", sector, err);
+		return false;
+	}
+	return true;
+#else
+	size_t erased = SectorSize;
+	if (faultBudget >= 0)
+	{
+		erased = std::min((size_t)SectorSize, (size_t)faultBudget);
+		faultBudget -= erased;
+	}
+
+	memset((uint8_t *)base + (sector + 1) * SectorSize - erased, 0xff, erased);
+	return erased == SectorSize;
+#endif
+}
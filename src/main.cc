@@ -27,11 +27,16 @@
 
 #include "config.h"
 #include "utils.h"
+#include "rtc_store.h"
 #include "client/calendar_client.h"
 #include "components/display_config.h"
 
 #include "display.h"
 
+#if defined(THIN_CLIENT) && defined(MULTI_ROOM)
+#error "THIN_CLIENT and MULTI_ROOM can not be combined, the server renders the rooms in thin-client mode"
+#endif
+
 Preferences prefs;
 calendar_client::CalendarClient calClient(API_ENDPOINT, API_ENDPOINT_PORT);
 
@@ -41,11 +46,14 @@ Display epd(PIN_EPD_PWR, PIN_EPD_SCK, PIN_EPD_MISO, PIN_EPD_MOSI, PIN_EPD_CS, PI
 Display epd(PIN_EPD_PWR, PIN_EPD_SCK, PIN_EPD_MISO, PIN_EPD_MOSI, PIN_EPD_CS, PIN_EPD_DC, PIN_EPD_RST, PIN_EPD_BUSY, &calClient);
 #endif
 
-// Put esp32 into ultra low-power deep sleep (<11μA).
-void beginDeepSleep(unsigned long startTime)
-{
-	killWiFi();
+// Seconds until the next wake. Computed while the panel is refreshing,
+// -1 as long as it has not been computed yet.
+int sleepSeconds = -1;
 
+// Sleep duration is until the end of the current meeting, or till the
+// beginning of the next meeting, but at most SLEEP_DURATION.
+int computeSleepSeconds()
+{
 	tm timeInfo = {};
 	// only call getLocalTime if we havent gotten the ntp time yet
 	if (!getLocalTime(&timeInfo))
@@ -55,39 +63,97 @@ void beginDeepSleep(unsigned long startTime)
 
 	time_t now = mktime(&timeInfo);
 
-	int sleepSeconds = SLEEP_DURATION * 60; // SLEEP_DURATION is in minutes, multiply by 60
+	int seconds = SLEEP_DURATION * 60; // SLEEP_DURATION is in minutes, multiply by 60
 
+#if defined(THIN_CLIENT)
+	// until the server expects the frame to change
+	const calendar_client::FrameState *frame = calendar_client::CalendarClient::getFrame();
+	if (frame != NULL && frame->validUntil > now && difftime(frame->validUntil, now) < seconds)
+	{
+		seconds = difftime(frame->validUntil, now);
+#if DEBUG_LEVEL >= 1
+		Serial.println("[debug] sleeping till the frame changes (" + String(seconds) + "s)");
+#endif
+	}
+#elif defined(MULTI_ROOM)
+	// until the first of the rooms changes its state
+	for (size_t i = 0; i < calendar_client::CalendarClient::getRoomCount(); i++)
+	{
+		const calendar_client::RoomSummary *room = calClient.getRoomSummary(i);
+		if (room == NULL)
+		{
+			continue;
+		}
+		time_t change = room->isFree() ? room->nextStart : room->currentEnd;
+		if (change > now && difftime(change, now) < seconds)
+		{
+			seconds = difftime(change, now);
+		}
+	}
+#if DEBUG_LEVEL >= 1
+	Serial.println("[debug] sleeping till the next room changes (" + String(seconds) + "s)");
+#endif
+#else
 	// Sleep duration is until the end of this meeting, or till the beginning of the next meeting
 	const calendar_client::CalendarEntry *currEvent = calClient.getCurrentEvent(now, false);
+	const calendar_client::CalendarEntry *nextEvent = currEvent == NULL ? calClient.getNextEvent(now) : NULL;
+	const calendar_client::DayOccupancy *day = calendar_client::CalendarClient::getOccupancy(now);
 
 	if (currEvent != NULL)
 	{
-		sleepSeconds = difftime(currEvent->getEnd(), now); // calculate the minutes until the event ends
+		seconds = difftime(currEvent->getEnd(), now); // calculate the minutes until the event ends
 #if DEBUG_LEVEL >= 1
-		Serial.println("[debug] sleeping till end of this event: " + currEvent->getTitle() + " (" + sleepSeconds + "s)");
+		Serial.println("[debug] sleeping till end of this event: " + currEvent->getTitle() + " (" + seconds + "s)");
 #endif
 	}
-	else
+	else if (nextEvent != NULL)
 	{
-		const calendar_client::CalendarEntry *nextEvent = calClient.getNextEvent(now);
-		if (nextEvent != NULL)
-		{
-			sleepSeconds = difftime(nextEvent->getStart(), now); // calculate the minutes until the next event starts
+		seconds = difftime(nextEvent->getStart(), now); // calculate the minutes until the next event starts
 #if DEBUG_LEVEL >= 1
-			Serial.println("[debug] sleeping till start of next event: " + nextEvent->getTitle() + " (" + sleepSeconds + "s)");
+		Serial.println("[debug] sleeping till start of next event: " + nextEvent->getTitle() + " (" + seconds + "s)");
 #endif
-		}
 	}
+	else if (calClient.getIndex().size() == 0 && day != NULL)
+	{
+		// the calendar was not fetched on this wake, so sleep till the
+		// schedule known from the last fetch changes
+		uint16_t minute = day->minuteOf(now);
+		uint16_t change = day->isOccupied(minute) ? day->occupiedUntil(minute) : day->freeUntil(minute);
+		seconds = difftime(day->midnight + change * 60, now);
+#if DEBUG_LEVEL >= 1
+		Serial.println("[debug] sleeping till the last known schedule changes (" + String(seconds) + "s)");
+#endif
+	}
+#endif
 
 	// if we sleep for more than SLEEP_DURATION, wake up a bit earlier,
 	// to check for potential new calendar invites
-	if (sleepSeconds > SLEEP_DURATION * 60)
+	if (seconds > SLEEP_DURATION * 60)
 	{
-		sleepSeconds = SLEEP_DURATION * 60;
+		seconds = SLEEP_DURATION * 60;
 	}
 
 	// add extra delay to compensate for esp32's with fast RTCs.
-	sleepSeconds += 10ULL;
+	seconds += 10ULL;
+
+	return seconds;
+}
+
+// Put esp32 into ultra low-power deep sleep (<11μA).
+void beginDeepSleep(unsigned long startTime)
+{
+	// tasks that did not get their turn while the panel was busy still
+	// need the network, so run them before tearing it down
+	epd.runRefreshTasks();
+	killWiFi();
+
+	// waits for the refresh to finish and hibernates the panel
+	epd.powerOff();
+
+	if (sleepSeconds < 0)
+	{
+		sleepSeconds = computeSleepSeconds();
+	}
 
 #if DEBUG_LEVEL >= 1
 	printHeapUsage();
@@ -112,6 +178,9 @@ void setup()
 
 	disableBuiltinLED();
 
+	// state kept in RTC memory, empty unless we woke from deep sleep
+	RtcStore::begin();
+
 	// Open namespace for read/write to non-volatile storage
 	prefs.begin(NVS_NAMESPACE, false);
 
@@ -133,6 +202,7 @@ void setup()
 			prefs.putBool("lowBat", true);
 			prefs.end();
 			epd.error("battery_alert_90deg", "Low Battery");
+			epd.powerOff();
 		}
 
 		// critically low battery
@@ -172,6 +242,24 @@ void setup()
 
 	tm timeInfo = {};
 
+	// RENDER OFFLINE
+	// Between syncs, the calendar (or the calendars of the rooms) fetched on
+	// the last one is rendered from flash. The clock kept running through
+	// deep sleep, only the time zone has to be set again.
+	// The frame of the thin client is fetched on every wake.
+	setenv("TZ", TIMEZONE, 1);
+	tzset();
+#ifndef THIN_CLIENT
+	if (getLocalTime(&timeInfo, 0) && !calendar_client::CalendarClient::isSyncDue(mktime(&timeInfo)) && calClient.loadCalendar())
+	{
+		epd.addRefreshTask([]()
+						   { sleepSeconds = computeSleepSeconds(); });
+
+		epd.render(mktime(&timeInfo));
+		beginDeepSleep(startTime);
+	}
+#endif
+
 	// START WIFI
 	wl_status_t wifiStatus = startWiFi();
 
@@ -200,6 +288,22 @@ void setup()
 		beginDeepSleep(startTime);
 	}
 
+	// the telemetry upload is hidden behind whatever gets rendered next
+	epd.addRefreshTask([batteryVoltage, startTime]()
+					   { calClient.uploadTelemetry(batteryVoltage, WiFi.RSSI(), millis() - startTime); });
+
+#ifdef THIN_CLIENT
+	// everything shown is rendered by the server, an unchanged frame leaves
+	// the panel off
+	int frameStatus = calClient.fetchFrame(epd.width(), epd.height(), [](Stream &stream)
+										   { return epd.renderFrame(stream); });
+	if (frameStatus != HTTP_CODE_OK && frameStatus != HTTP_CODE_NOT_MODIFIED)
+	{
+		epd.error("wi_cloud_down", "Fetching frame failed", calendar_client::CalendarClient::getHttpResponsePhrase(frameStatus), mktime(&timeInfo));
+	}
+	beginDeepSleep(startTime);
+#endif
+
 	calClient.fetchCustomStatus();
 	const calendar_client::CustomStatus *stat = calClient.getCustomStatus();
 	if (stat != NULL && !stat->getTitle().isEmpty())
@@ -208,7 +312,11 @@ void setup()
 		beginDeepSleep(startTime);
 	}
 
+#ifdef MULTI_ROOM
+	int httpStatus = calClient.fetchRooms();
+#else
 	int httpStatus = calClient.fetchCalendar();
+#endif
 	if (httpStatus != HTTP_CODE_OK)
 	{
 		std::stringstream ss;
@@ -218,6 +326,22 @@ void setup()
 		beginDeepSleep(startTime);
 	}
 
+	// keep the calendar for the wakes until the next sync, which only
+	// counts as done once it is in flash
+	time_t syncTime = mktime(&timeInfo);
+	int rssi = WiFi.RSSI();
+	epd.addRefreshTask([syncTime, rssi]()
+					   {
+		if (calClient.saveCalendar())
+		{
+			calendar_client::CalendarClient::setSynced(syncTime, rssi);
+		} });
+
+	// the calendar is known now, so the sleep schedule can be computed
+	// while the panel is refreshing
+	epd.addRefreshTask([]()
+					   { sleepSeconds = computeSleepSeconds(); });
+
 	epd.render(mktime(&timeInfo));
 	beginDeepSleep(startTime);
 }
@@ -0,0 +1,115 @@
+#include "rle.h"
+
+#include <string.h>
+
+namespace rle
+{
+    void encode(const uint8_t *data, size_t len, std::vector<uint8_t> &out)
+    {
+        size_t i = 0;
+        while (i < len)
+        {
+            // measure the run starting at i
+            size_t run = 1;
+            while (i + run < len && run < 129 && data[i + run] == data[i])
+            {
+                run++;
+            }
+
+            if (run >= 3)
+            {
+                out.push_back((uint8_t)(run + 126));
+                out.push_back(data[i]);
+                i += run;
+                continue;
+            }
+
+            // collect literals until the next run of at least 3 bytes starts
+            size_t start = i;
+            while (i < len && i - start < 128)
+            {
+                if (i + 2 < len && data[i] == data[i + 1] && data[i] == data[i + 2])
+                {
+                    break;
+                }
+                i++;
+            }
+
+            out.push_back((uint8_t)(i - start - 1));
+            out.insert(out.end(), data + start, data + i);
+        }
+    }
+
+    void Decoder::reset(const uint8_t *data, size_t len)
+    {
+        remaining = 0;
+        literal = false;
+        pending = false;
+        setInput(data, len);
+    }
+
+    void Decoder::setInput(const uint8_t *data, size_t len)
+    {
+        in = data;
+        inLen = len;
+        pos = 0;
+    }
+
+    size_t Decoder::read(uint8_t *out, size_t len)
+    {
+        size_t produced = 0;
+
+        while (produced < len)
+        {
+            if (remaining == 0 && !pending)
+            {
+                if (pos >= inLen)
+                {
+                    break;
+                }
+
+                uint8_t control = in[pos++];
+                literal = control < 128;
+                remaining = literal ? control + 1 : control - 126;
+                pending = !literal;
+            }
+
+            // the value of a repeat run may be the first byte of the next chunk
+            if (pending)
+            {
+                if (pos >= inLen)
+                {
+                    break;
+                }
+                value = in[pos++];
+                pending = false;
+            }
+
+            size_t n = remaining < len - produced ? remaining : len - produced;
+
+            if (literal)
+            {
+                // literal bytes may be split over chunks as well
+                n = n < inLen - pos ? n : inLen - pos;
+                if (n == 0)
+                {
+                    break;
+                }
+                if (out != NULL)
+                {
+                    memcpy(out + produced, in + pos, n);
+                }
+                pos += n;
+            }
+            else if (out != NULL)
+            {
+                memset(out + produced, value, n);
+            }
+
+            remaining -= n;
+            produced += n;
+        }
+
+        return produced;
+    }
+};
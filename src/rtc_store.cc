@@ -0,0 +1,119 @@
+#include "rtc_store.h"
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <esp_system.h>
+#endif
+
+#include "crc.h"
+
+#ifndef RTC_DATA_ATTR
+#define RTC_DATA_ATTR
+#endif
+
+// word aligned, so the headers can be accessed in place
+RTC_DATA_ATTR static uint32_t memory[RTC_STORE_SIZE / 4];
+
+#ifndef ARDUINO
+static const char *hostPath = "rtc_store.bin";
+
+static void flush()
+{
+	FILE *file = fopen(hostPath, "wb");
+	if (file == NULL)
+	{
+		Serial.printf("[error]: Writing '%s' failed\n", hostPath);
+		return;
+	}
+	fwrite(memory, 1, sizeof(memory), file);
+	fclose(file);
+}
+#endif
+
+static RtcStore::Header *header()
+{
+	return (RtcStore::Header *)memory;
+}
+
+static RtcStore::RecordHeader *record(rtc_record::Id id)
+{
+	return (RtcStore::RecordHeader *)((uint8_t *)memory + RtcStore::offset(id));
+}
+
+bool RtcStore::begin()
+{
+#ifdef ARDUINO
+	// the RTC memory is only kept across deep sleep, after any other reset
+	// it may hold anything
+	bool coldBoot = esp_reset_reason() != ESP_RST_DEEPSLEEP;
+#else
+	FILE *file = fopen(hostPath, "rb");
+	bool coldBoot = file == NULL || fread(memory, 1, sizeof(memory), file) != sizeof(memory);
+	if (file != NULL)
+	{
+		fclose(file);
+	}
+#endif
+
+	if (!coldBoot && header()->magic == Magic && header()->version == Version && header()->size == offset(rtc_record::Count))
+	{
+		return true;
+	}
+
+#if DEBUG_LEVEL >= 1
+	Serial.printf("[debug] RTC store reset (%s)\n", coldBoot ? "cold boot" : "new layout");
+#endif
+	reset();
+	return false;
+}
+
+void RtcStore::reset()
+{
+	memset(memory, 0, sizeof(memory));
+	header()->magic = Magic;
+	header()->version = Version;
+	header()->size = offset(rtc_record::Count);
+#ifndef ARDUINO
+	flush();
+#endif
+}
+
+bool RtcStore::read(rtc_record::Id id, void *data, size_t length)
+{
+	const RecordHeader *r = record(id);
+	if (r->length == 0)
+	{
+		return false;
+	}
+
+	if (r->length != length || crc::crc32(r + 1, length) != r->crc)
+	{
+		Serial.printf("[error]: RTC store record %d is corrupt\n", id);
+		return false;
+	}
+
+	memcpy(data, r + 1, length);
+	return true;
+}
+
+void RtcStore::write(rtc_record::Id id, const void *data, size_t length)
+{
+	RecordHeader *r = record(id);
+	memcpy(r + 1, data, length);
+	r->length = length;
+	r->crc = crc::crc32(data, length);
+#ifndef ARDUINO
+	flush();
+#endif
+}
+
+void RtcStore::erase(rtc_record::Id id)
+{
+	record(id)->length = 0;
+#ifndef ARDUINO
+	flush();
+#endif
+}
@@ -0,0 +1,109 @@
+#include "utf8.h"
+
+namespace utf8
+{
+    uint32_t Decoder::feed(uint8_t b)
+    {
+        if (remaining > 0)
+        {
+            if ((b & 0xC0) == 0x80)
+            {
+                codepoint = (codepoint << 6) | (b & 0x3F);
+                return --remaining == 0 ? codepoint : Incomplete;
+            }
+
+            // the sequence was cut short and is dropped, b starts a new one
+            remaining = 0;
+            return feed(b);
+        }
+
+        if (b < 0x80)
+        {
+            return b;
+        }
+        else if ((b & 0xE0) == 0xC0)
+        {
+            codepoint = b & 0x1F;
+            remaining = 1;
+        }
+        else if ((b & 0xF0) == 0xE0)
+        {
+            codepoint = b & 0x0F;
+            remaining = 2;
+        }
+        else if ((b & 0xF8) == 0xF0)
+        {
+            codepoint = b & 0x07;
+            remaining = 3;
+        }
+        else
+        {
+            // stray continuation byte or invalid lead byte
+            return Replacement;
+        }
+
+        return Incomplete;
+    }
+
+    uint32_t next(const char *s, size_t len, size_t &pos)
+    {
+        uint8_t b = s[pos++];
+        uint32_t codepoint;
+        uint8_t continuation;
+
+        if (b < 0x80)
+        {
+            return b;
+        }
+        else if ((b & 0xE0) == 0xC0)
+        {
+            codepoint = b & 0x1F;
+            continuation = 1;
+        }
+        else if ((b & 0xF0) == 0xE0)
+        {
+            codepoint = b & 0x0F;
+            continuation = 2;
+        }
+        else if ((b & 0xF8) == 0xF0)
+        {
+            codepoint = b & 0x07;
+            continuation = 3;
+        }
+        else
+        {
+            return Replacement;
+        }
+
+        while (continuation-- > 0)
+        {
+            // a sequence that is cut short ends before the offending byte
+            if (pos >= len || (s[pos] & 0xC0) != 0x80)
+            {
+                return Replacement;
+            }
+            codepoint = (codepoint << 6) | (s[pos++] & 0x3F);
+        }
+
+        return codepoint;
+    }
+
+    char fold(uint32_t codepoint)
+    {
+        // U+00C0 to U+00FF without their accents
+        static const char latin1[] = "AAAAAAACEEEEIIII"
+                                     "DNOOOOOxOUUUUYPs"
+                                     "aaaaaaaceeeeiiii"
+                                     "dnooooo/ouuuuypy";
+
+        if (codepoint >= 0x20 && codepoint < 0x7F)
+        {
+            return (char)codepoint;
+        }
+        if (codepoint >= 0xC0 && codepoint <= 0xFF)
+        {
+            return latin1[codepoint - 0xC0];
+        }
+        return '?';
+    }
+};
@@ -0,0 +1,384 @@
+#pragma once
+
+// Stand-in for Adafruit_GFX in the host environment. The generic drawing
+// paths are the ones of the library (1.11): everything that a subclass
+// does not override ends up in drawPixel(), pixel by pixel, and GFX font
+// glyphs are drawn bit by bit. The benchmarks in test/ compare against
+// these paths. The built-in 5x7 font is not included, text without a GFX
+// font is only advanced over.
+
+#include <Arduino.h>
+#include <stdlib.h>
+
+typedef struct
+{
+    uint16_t bitmapOffset;
+    uint8_t width;
+    uint8_t height;
+    uint8_t xAdvance;
+    int8_t xOffset;
+    int8_t yOffset;
+} GFXglyph;
+
+typedef struct
+{
+    uint8_t *bitmap;
+    GFXglyph *glyph;
+    uint16_t first;
+    uint16_t last;
+    uint8_t yAdvance;
+} GFXfont;
+
+class Adafruit_GFX : public Print
+{
+public:
+    Adafruit_GFX(int16_t w, int16_t h) : WIDTH(w), HEIGHT(h), _width(w), _height(h) {}
+
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+
+    virtual void startWrite() {}
+    virtual void writePixel(int16_t x, int16_t y, uint16_t color) { drawPixel(x, y, color); }
+    virtual void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) { fillRect(x, y, w, h, color); }
+    virtual void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) { drawFastVLine(x, y, h, color); }
+    virtual void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) { drawFastHLine(x, y, w, color); }
+    virtual void endWrite() {}
+
+    virtual void writeLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+    {
+        bool steep = abs(y1 - y0) > abs(x1 - x0);
+        if (steep)
+        {
+            swap(x0, y0);
+            swap(x1, y1);
+        }
+        if (x0 > x1)
+        {
+            swap(x0, x1);
+            swap(y0, y1);
+        }
+
+        int16_t dx = x1 - x0;
+        int16_t dy = abs(y1 - y0);
+        int16_t err = dx / 2;
+        int16_t ystep = y0 < y1 ? 1 : -1;
+
+        for (; x0 <= x1; x0++)
+        {
+            if (steep)
+            {
+                writePixel(y0, x0, color);
+            }
+            else
+            {
+                writePixel(x0, y0, color);
+            }
+            err -= dy;
+            if (err < 0)
+            {
+                y0 += ystep;
+                err += dx;
+            }
+        }
+    }
+
+    virtual void setRotation(uint8_t r) { rotation = r & 3; }
+
+    virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+    {
+        startWrite();
+        writeLine(x, y, x, y + h - 1, color);
+        endWrite();
+    }
+
+    virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+    {
+        startWrite();
+        writeLine(x, y, x + w - 1, y, color);
+        endWrite();
+    }
+
+    virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+    {
+        startWrite();
+        for (int16_t i = x; i < x + w; i++)
+        {
+            writeFastVLine(i, y, h, color);
+        }
+        endWrite();
+    }
+
+    virtual void fillScreen(uint16_t color) { fillRect(0, 0, _width, _height, color); }
+
+    virtual void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+    {
+        if (x0 == x1)
+        {
+            drawFastVLine(x0, std::min(y0, y1), abs(y1 - y0) + 1, color);
+        }
+        else if (y0 == y1)
+        {
+            drawFastHLine(std::min(x0, x1), y0, abs(x1 - x0) + 1, color);
+        }
+        else
+        {
+            startWrite();
+            writeLine(x0, y0, x1, y1, color);
+            endWrite();
+        }
+    }
+
+    virtual void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+    {
+        startWrite();
+        writeFastHLine(x, y, w, color);
+        writeFastHLine(x, y + h - 1, w, color);
+        writeFastVLine(x, y, h, color);
+        writeFastVLine(x + w - 1, y, h, color);
+        endWrite();
+    }
+
+    // set bits are drawn
+    void drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color)
+    {
+        int16_t byteWidth = (w + 7) / 8;
+        uint8_t b = 0;
+
+        startWrite();
+        for (int16_t j = 0; j < h; j++, y++)
+        {
+            for (int16_t i = 0; i < w; i++)
+            {
+                if (i & 7)
+                {
+                    b <<= 1;
+                }
+                else
+                {
+                    b = bitmap[j * byteWidth + i / 8];
+                }
+                if (b & 0x80)
+                {
+                    writePixel(x + i, y, color);
+                }
+            }
+        }
+        endWrite();
+    }
+
+    // cleared bits are drawn, like GxEPD2_GFX::drawInvertedBitmap()
+    void drawInvertedBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color)
+    {
+        int16_t byteWidth = (w + 7) / 8;
+        uint8_t b = 0;
+
+        startWrite();
+        for (int16_t j = 0; j < h; j++, y++)
+        {
+            for (int16_t i = 0; i < w; i++)
+            {
+                if (i & 7)
+                {
+                    b <<= 1;
+                }
+                else
+                {
+                    b = bitmap[j * byteWidth + i / 8];
+                }
+                if (!(b & 0x80))
+                {
+                    writePixel(x + i, y, color);
+                }
+            }
+        }
+        endWrite();
+    }
+
+    void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size_x, uint8_t size_y)
+    {
+        if (gfxFont == NULL)
+        {
+            return;
+        }
+
+        c -= (uint8_t)gfxFont->first;
+        const GFXglyph *glyph = gfxFont->glyph + c;
+        const uint8_t *bitmap = gfxFont->bitmap;
+
+        uint16_t bo = glyph->bitmapOffset;
+        uint8_t w = glyph->width, h = glyph->height;
+        int8_t xo = glyph->xOffset, yo = glyph->yOffset;
+        uint8_t bits = 0, bit = 0;
+
+        startWrite();
+        for (uint8_t yy = 0; yy < h; yy++)
+        {
+            for (uint8_t xx = 0; xx < w; xx++)
+            {
+                if (!(bit++ & 7))
+                {
+                    bits = bitmap[bo++];
+                }
+                if (bits & 0x80)
+                {
+                    if (size_x == 1 && size_y == 1)
+                    {
+                        writePixel(x + xo + xx, y + yo + yy, color);
+                    }
+                    else
+                    {
+                        writeFillRect(x + (xo + xx) * size_x, y + (yo + yy) * size_y, size_x, size_y, color);
+                    }
+                }
+                bits <<= 1;
+            }
+        }
+        endWrite();
+    }
+
+    using Print::write;
+    virtual size_t write(uint8_t c) override
+    {
+        if (gfxFont == NULL)
+        {
+            cursor_x += textsize_x * 6;
+            return 1;
+        }
+
+        if (c == '\n')
+        {
+            cursor_x = 0;
+            cursor_y += (int16_t)textsize_y * gfxFont->yAdvance;
+        }
+        else if (c != '\r' && c >= gfxFont->first && c <= gfxFont->last)
+        {
+            const GFXglyph *glyph = gfxFont->glyph + (c - gfxFont->first);
+            if (glyph->width > 0 && glyph->height > 0)
+            {
+                int16_t xo = glyph->xOffset;
+                if (wrap && (cursor_x + textsize_x * (xo + glyph->width)) > _width)
+                {
+                    cursor_x = 0;
+                    cursor_y += (int16_t)textsize_y * gfxFont->yAdvance;
+                }
+                drawChar(cursor_x, cursor_y, c, textcolor, textbgcolor, textsize_x, textsize_y);
+            }
+            cursor_x += glyph->xAdvance * (int16_t)textsize_x;
+        }
+        return 1;
+    }
+
+    void getTextBounds(const char *text, int16_t x, int16_t y, int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h)
+    {
+        int16_t minX = _width, minY = _height, maxX = -1, maxY = -1;
+        *x1 = x;
+        *y1 = y;
+        *w = *h = 0;
+
+        for (; *text != '\0'; text++)
+        {
+            charBounds((uint8_t)*text, &x, &y, &minX, &minY, &maxX, &maxY);
+        }
+
+        if (maxX >= minX)
+        {
+            *x1 = minX;
+            *w = maxX - minX + 1;
+        }
+        if (maxY >= minY)
+        {
+            *y1 = minY;
+            *h = maxY - minY + 1;
+        }
+    }
+    void getTextBounds(const String &text, int16_t x, int16_t y, int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h) { getTextBounds(text.c_str(), x, y, x1, y1, w, h); }
+
+    void setCursor(int16_t x, int16_t y)
+    {
+        cursor_x = x;
+        cursor_y = y;
+    }
+    void setTextColor(uint16_t c) { textcolor = textbgcolor = c; }
+    void setTextColor(uint16_t c, uint16_t bg)
+    {
+        textcolor = c;
+        textbgcolor = bg;
+    }
+    void setTextSize(uint8_t s) { textsize_x = textsize_y = s > 0 ? s : 1; }
+    void setTextWrap(bool w) { wrap = w; }
+    void setFont(const GFXfont *f = NULL)
+    {
+        // the baseline of GFX fonts is at the cursor, the built-in font is
+        // drawn below it
+        if (f != NULL && gfxFont == NULL)
+        {
+            cursor_y += 6;
+        }
+        else if (f == NULL && gfxFont != NULL)
+        {
+            cursor_y -= 6;
+        }
+        gfxFont = (GFXfont *)f;
+    }
+
+    int16_t width() const { return _width; }
+    int16_t height() const { return _height; }
+    uint8_t getRotation() const { return rotation; }
+    int16_t getCursorX() const { return cursor_x; }
+    int16_t getCursorY() const { return cursor_y; }
+
+protected:
+    const int16_t WIDTH;
+    const int16_t HEIGHT;
+    int16_t _width;
+    int16_t _height;
+    int16_t cursor_x = 0;
+    int16_t cursor_y = 0;
+    uint16_t textcolor = 0xFFFF;
+    uint16_t textbgcolor = 0xFFFF;
+    uint8_t textsize_x = 1;
+    uint8_t textsize_y = 1;
+    uint8_t rotation = 0;
+    bool wrap = true;
+    bool _cp437 = false;
+    GFXfont *gfxFont = NULL;
+
+    static void swap(int16_t &a, int16_t &b)
+    {
+        int16_t t = a;
+        a = b;
+        b = t;
+    }
+
+    void charBounds(uint8_t c, int16_t *x, int16_t *y, int16_t *minX, int16_t *minY, int16_t *maxX, int16_t *maxY)
+    {
+        if (gfxFont == NULL)
+        {
+            *x += textsize_x * 6;
+            return;
+        }
+
+        if (c == '\n')
+        {
+            *x = 0;
+            *y += textsize_y * gfxFont->yAdvance;
+        }
+        else if (c != '\r' && c >= gfxFont->first && c <= gfxFont->last)
+        {
+            const GFXglyph *glyph = gfxFont->glyph + (c - gfxFont->first);
+            int16_t gw = glyph->width, gh = glyph->height, xa = glyph->xAdvance;
+            int16_t xo = glyph->xOffset, yo = glyph->yOffset;
+            if (wrap && (*x + ((xo + gw) * textsize_x)) > _width)
+            {
+                *x = 0;
+                *y += textsize_y * gfxFont->yAdvance;
+            }
+            int16_t x1 = *x + xo * textsize_x, y1 = *y + yo * textsize_y;
+            int16_t x2 = x1 + gw * textsize_x - 1, y2 = y1 + gh * textsize_y - 1;
+            *minX = std::min(*minX, x1);
+            *minY = std::min(*minY, y1);
+            *maxX = std::max(*maxX, x2);
+            *maxY = std::max(*maxY, y2);
+            *x += xa * textsize_x;
+        }
+    }
+};
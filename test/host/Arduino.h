@@ -0,0 +1,163 @@
+#pragma once
+
+// Stand-in for the parts of the Arduino core that the code built by the
+// host environment (env:native, see test/README) uses. Only as much as that
+// code needs, it is not meant to run anything else.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+#define LOW 0x0
+#define HIGH 0x1
+
+class String
+{
+protected:
+    std::string s;
+
+public:
+    String() {}
+    String(const char *text) : s(text != NULL ? text : "") {}
+    String(const std::string &text) : s(text) {}
+    explicit String(char c) : s(1, c) {}
+    explicit String(int value) : s(std::to_string(value)) {}
+    explicit String(unsigned value) : s(std::to_string(value)) {}
+    explicit String(long value) : s(std::to_string(value)) {}
+    explicit String(unsigned long value) : s(std::to_string(value)) {}
+
+    const char *c_str() const { return s.c_str(); }
+    unsigned length() const { return s.length(); }
+    bool isEmpty() const { return s.empty(); }
+    char operator[](unsigned i) const { return s[i]; }
+
+    String &operator+=(const String &other)
+    {
+        s += other.s;
+        return *this;
+    }
+    String &operator+=(const char *other)
+    {
+        s += other;
+        return *this;
+    }
+    String &operator+=(char c)
+    {
+        s += c;
+        return *this;
+    }
+    bool concat(const char *data, unsigned length)
+    {
+        s.append(data, length);
+        return true;
+    }
+
+    bool operator==(const String &other) const { return s == other.s; }
+    bool operator!=(const String &other) const { return s != other.s; }
+    friend String operator+(const String &a, const String &b) { return String(a.s + b.s); }
+};
+
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+
+    size_t write(const char *text)
+    {
+        size_t n = 0;
+        while (*text != '\0')
+        {
+            n += write((uint8_t)*text++);
+        }
+        return n;
+    }
+    size_t print(const char *text) { return write(text); }
+    size_t print(const String &text) { return write(text.c_str()); }
+    size_t println(const char *text) { return print(text) + write((uint8_t)'\n'); }
+    size_t println(const String &text) { return println(text.c_str()); }
+
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)))
+    {
+        char buffer[256];
+        va_list args;
+        va_start(args, format);
+        vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        return write(buffer);
+    }
+};
+
+// the serial port prints to stdout
+class HardwareSerial : public Print
+{
+public:
+    void begin(unsigned long) {}
+    virtual size_t write(uint8_t c) override { return fputc(c, stdout) == EOF ? 0 : 1; }
+    using Print::write;
+};
+
+inline HardwareSerial Serial;
+
+inline unsigned long millis()
+{
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+inline void delay(unsigned long ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// Like in the Arduino core, reads wait up to the timeout for data to arrive.
+class Stream : public Print
+{
+protected:
+    unsigned long timeout = 1000;
+
+    int timedRead()
+    {
+        unsigned long start = millis();
+        do
+        {
+            int c = read();
+            if (c >= 0)
+            {
+                return c;
+            }
+            delay(1);
+        } while (millis() - start < timeout);
+        return -1;
+    }
+
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long ms) { timeout = ms; }
+    unsigned long getTimeout() const { return timeout; }
+
+    size_t readBytes(char *buffer, size_t length)
+    {
+        size_t n = 0;
+        while (n < length)
+        {
+            int c = timedRead();
+            if (c < 0)
+            {
+                break;
+            }
+            buffer[n++] = (char)c;
+        }
+        return n;
+    }
+};
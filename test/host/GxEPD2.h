@@ -0,0 +1,35 @@
+#pragma once
+
+// Stand-in for the GxEPD2 headers in the host environment: the colors and
+// the dimensions of the panels, which is all the buffers take from them.
+// The drivers themselves are not built on the host.
+
+#include <Adafruit_GFX.h>
+
+#define GxEPD_BLACK 0x0000
+#define GxEPD_WHITE 0xFFFF
+#define GxEPD_DARKGREY 0x7BEF
+#define GxEPD_LIGHTGREY 0xC618
+#define GxEPD_RED 0xF800
+#define GxEPD_GREEN 0x07E0
+#define GxEPD_BLUE 0x001F
+#define GxEPD_YELLOW 0xFFE0
+#define GxEPD_ORANGE 0xFC00
+
+struct GxEPD2_750_T7
+{
+    static const uint16_t WIDTH = 800;
+    static const uint16_t HEIGHT = 480;
+};
+
+struct GxEPD2_750c_Z08
+{
+    static const uint16_t WIDTH = 800;
+    static const uint16_t HEIGHT = 480;
+};
+
+struct GxEPD2_730c_GDEY073D46
+{
+    static const uint16_t WIDTH = 800;
+    static const uint16_t HEIGHT = 480;
+};
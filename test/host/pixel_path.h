@@ -0,0 +1,71 @@
+#pragma once
+
+// Helpers shared by the host tests.
+
+#include <chrono>
+
+#include "components/page_buffer.h"
+#include "random_input.h"
+
+// Draws through the generic Adafruit_GFX paths, i.e. pixel by pixel, into
+// another PageBuffer. This is what the buffer did before it got its own
+// span, blit and glyph paths, and what they are compared against.
+class PixelPath : public Adafruit_GFX
+{
+public:
+    explicit PixelPath(PageBuffer &target) : Adafruit_GFX(target.width(), target.height()), target(target) {}
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override { target.drawPixel(x, y, color); }
+
+private:
+    PageBuffer &target;
+};
+
+// the colors the panel of the build can show
+static const uint16_t testColors[] = {
+    GxEPD_BLACK,
+    GxEPD_WHITE,
+#if defined(DISP_3C) || defined(DISP_7C)
+    GxEPD_RED,
+#endif
+#if defined(DISP_7C)
+    GxEPD_GREEN,
+    GxEPD_BLUE,
+    GxEPD_YELLOW,
+    GxEPD_ORANGE,
+#endif
+};
+
+inline uint16_t randomColor()
+{
+    return testColors[random(0, sizeof(testColors) / sizeof(testColors[0]) - 1)];
+}
+
+// true if both buffers hold the same pixels in their current band
+inline bool sameBand(PageBuffer &a, PageBuffer &b)
+{
+    for (int16_t y = a.getBandY(); y < a.getBandY() + a.getBandHeight(); y++)
+    {
+        for (uint8_t p = 0; p < DISP_PLANES; p++)
+        {
+            if (memcmp(a.row(p, y), b.row(p, y), a.getStride()) != 0)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// microseconds per call of fn, averaged over n calls
+template <typename Fn>
+double microsPerCall(int n, Fn fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; i++)
+    {
+        fn();
+    }
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / n;
+}
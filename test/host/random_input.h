@@ -0,0 +1,14 @@
+#pragma once
+
+// Random input for the host tests. The generator is seeded the same way on
+// every run, so a failure can be reproduced.
+
+#include <random>
+
+static std::mt19937 rng(1);
+
+// uniformly distributed in [from, to]
+static long random(long from, long to)
+{
+    return std::uniform_int_distribution<long>(from, to)(rng);
+}
@@ -0,0 +1,345 @@
+#include <unity.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "client/calendar_entry.h"
+#include "client/calendar_index.h"
+#include "random_input.h"
+
+using namespace calendar_client;
+
+// the random entries fall into [0, Range), everything after it is free
+static const time_t Range = 2000;
+
+class TestEntry : public CalendarEntry
+{
+public:
+	TestEntry(time_t start, time_t end, BusyState busy = BusyState::Busy)
+	{
+		this->start = start;
+		this->end = end;
+		this->busy = busy;
+	}
+};
+
+class TestIndex : public CalendarIndex
+{
+public:
+	using CalendarIndex::blockAt;
+
+	size_t blockCount() const { return blocks.size(); }
+	time_t blockStart(size_t block) const { return blocks[block].start; }
+	time_t blockEnd(size_t block) const { return blocks[block].end; }
+	size_t firstGap(size_t from, time_t length) const { return CalendarIndex::firstGap(1, 0, gapLeaves, from, length); }
+
+	// every leaf of the max tree holds the gap after its block, every inner
+	// node the largest gap below it
+	bool gapTreeHolds() const
+	{
+		for (size_t i = 0; i < gapLeaves; i++)
+		{
+			if (gapTree[gapLeaves + i] != (i < blocks.size() ? gap(i) : 0))
+			{
+				return false;
+			}
+		}
+		for (size_t i = 1; i < gapLeaves; i++)
+		{
+			if (gapTree[i] != std::max(gapTree[2 * i], gapTree[2 * i + 1]))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+// The same questions answered by looking at every moment: which ones are
+// taken up by an entry that is not Free, and the merged blocks as the runs
+// of those.
+class Scan
+{
+public:
+	const std::vector<CalendarEntry> &entries;
+	std::vector<const CalendarEntry *> byStart;
+	std::vector<bool> busy;
+	std::vector<std::pair<time_t, time_t>> blocks;
+
+	explicit Scan(const std::vector<CalendarEntry> &entries) : entries(entries), busy(Range, false)
+	{
+		for (const CalendarEntry &entry : entries)
+		{
+			byStart.push_back(&entry);
+			for (time_t t = entry.getStart(); t < entry.getEnd() && entry.getBusy() != BusyState::Free; t++)
+			{
+				busy[t] = true;
+			}
+		}
+		std::stable_sort(byStart.begin(), byStart.end(), [](const CalendarEntry *a, const CalendarEntry *b)
+						 { return a->getStart() < b->getStart(); });
+
+		for (time_t t = 0; t < Range; t++)
+		{
+			if (busy[t] && (t == 0 || !busy[t - 1]))
+			{
+				blocks.push_back({t, t});
+			}
+			if (busy[t])
+			{
+				blocks.back().second = t + 1;
+			}
+		}
+	}
+
+	bool isBusy(time_t t) const { return t >= 0 && t < Range && busy[t]; }
+
+	// with t0 == t1 the ones going on at t0 that did not just start
+	std::vector<const CalendarEntry *> eventsIn(time_t t0, time_t t1) const
+	{
+		std::vector<const CalendarEntry *> out;
+		for (const CalendarEntry *entry : byStart)
+		{
+			if (entry->getStart() < t1 && entry->getEnd() > t0)
+			{
+				out.push_back(entry);
+			}
+		}
+		return out;
+	}
+
+	const CalendarEntry *nextStart(time_t t) const
+	{
+		for (const CalendarEntry *entry : byStart)
+		{
+			if (entry->getStart() > t)
+			{
+				return entry;
+			}
+		}
+		return NULL;
+	}
+
+	long blockAt(time_t t) const
+	{
+		long found = -1;
+		for (size_t i = 0; i < blocks.size(); i++)
+		{
+			if (blocks[i].first <= t)
+			{
+				found = i;
+			}
+		}
+		return found;
+	}
+
+	time_t gap(size_t block) const { return block + 1 < blocks.size() ? blocks[block + 1].first - blocks[block].second : LONG_MAX; }
+
+	size_t firstGap(size_t from, time_t length) const
+	{
+		for (size_t i = from; i < blocks.size(); i++)
+		{
+			if (gap(i) >= length)
+			{
+				return i;
+			}
+		}
+		return SIZE_MAX;
+	}
+
+	time_t freeUntil(time_t t) const
+	{
+		if (isBusy(t))
+		{
+			return t;
+		}
+		for (time_t u = t; u < Range; u++)
+		{
+			if (isBusy(u))
+			{
+				return u;
+			}
+		}
+		return LONG_MAX;
+	}
+
+	time_t nextFreeSlot(time_t t, time_t minDuration) const
+	{
+		for (time_t s = t;; s++)
+		{
+			time_t u = s;
+			while (u < s + minDuration && u < Range && !isBusy(u))
+			{
+				u++;
+			}
+			if (u == s + minDuration || u >= Range)
+			{
+				return s;
+			}
+		}
+	}
+};
+
+// entries of 0 to 150 units, some of them touching or overlapping, and one in
+// four of them Free
+static std::vector<CalendarEntry> randomEntries(int count)
+{
+	std::vector<CalendarEntry> entries;
+	for (int i = 0; i < count; i++)
+	{
+		time_t start = random(0, Range - 150);
+		if (!entries.empty() && random(0, 4) == 0)
+		{
+			start = std::min(entries[random(0, entries.size() - 1)].getEnd(), Range - 150);
+		}
+		entries.push_back(TestEntry(start, start + random(0, 150), (BusyState)std::min(random(0, 3), 2L)));
+	}
+	return entries;
+}
+
+static void checkQueries(const std::vector<CalendarEntry> &entries, int queries)
+{
+	TestIndex index;
+	index.build(entries);
+	Scan scan(entries);
+	char message[96];
+
+	TEST_ASSERT_EQUAL(entries.size(), index.size());
+	TEST_ASSERT_EQUAL(scan.blocks.size(), index.blockCount());
+	for (size_t i = 0; i < scan.blocks.size(); i++)
+	{
+		TEST_ASSERT_EQUAL(scan.blocks[i].first, index.blockStart(i));
+		TEST_ASSERT_EQUAL(scan.blocks[i].second, index.blockEnd(i));
+	}
+	TEST_ASSERT_TRUE(index.gapTreeHolds());
+
+	for (int q = 0; q < queries; q++)
+	{
+		time_t t = random(-10, Range + 10);
+		time_t t1 = random(0, 2) == 0 ? t : t + random(1, 300);
+		time_t minDuration = random(1, 400);
+		size_t from = random(0, scan.blocks.size());
+		snprintf(message, sizeof(message), "%u entries, t %ld, t1 %ld, min %ld, from %u", (unsigned)entries.size(), (long)t,
+				 (long)t1, (long)minDuration, (unsigned)from);
+
+		std::vector<const CalendarEntry *> events;
+		index.eventsIn(t, t1, events);
+		TEST_ASSERT_TRUE_MESSAGE(events == scan.eventsIn(t, t1), message);
+		TEST_ASSERT_TRUE_MESSAGE(index.nextStart(t) == scan.nextStart(t), message);
+		TEST_ASSERT_EQUAL_MESSAGE(scan.blockAt(t), index.blockAt(t), message);
+		TEST_ASSERT_EQUAL_MESSAGE(scan.firstGap(from, minDuration), index.firstGap(from, minDuration), message);
+		TEST_ASSERT_EQUAL_MESSAGE(scan.freeUntil(t), index.freeUntil(t), message);
+		TEST_ASSERT_EQUAL_MESSAGE(scan.nextFreeSlot(t, minDuration), index.nextFreeSlot(t, minDuration), message);
+	}
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_queries_match_scan()
+{
+	for (int count : {1, 2, 3, 5, 8, 20, 50, 200})
+	{
+		for (int round = 0; round < 20; round++)
+		{
+			checkQueries(randomEntries(count), 200);
+		}
+	}
+}
+
+void test_no_blocks()
+{
+	TestIndex index;
+	index.build(std::vector<CalendarEntry>());
+	TEST_ASSERT_EQUAL(0, index.blockCount());
+	TEST_ASSERT_EQUAL(-1, index.blockAt(100));
+	TEST_ASSERT_EQUAL(LONG_MAX, index.freeUntil(100));
+	TEST_ASSERT_EQUAL(100, index.nextFreeSlot(100, 3600));
+	TEST_ASSERT_NULL(index.nextStart(100));
+
+	// entries without length take up no time
+	std::vector<CalendarEntry> entries = {TestEntry(100, 100), TestEntry(200, 200)};
+	index.build(entries);
+	TEST_ASSERT_EQUAL(0, index.blockCount());
+	TEST_ASSERT_EQUAL(100, index.nextFreeSlot(100, 3600));
+	TEST_ASSERT_TRUE(index.nextStart(100) == &entries[1]);
+	checkQueries(entries, 100);
+}
+
+void test_touching_blocks_merge()
+{
+	std::vector<CalendarEntry> entries = {TestEntry(20, 30), TestEntry(10, 20), TestEntry(30, 40), TestEntry(50, 60)};
+	TestIndex index;
+	index.build(entries);
+
+	TEST_ASSERT_EQUAL(2, index.blockCount());
+	TEST_ASSERT_EQUAL(10, index.blockStart(0));
+	TEST_ASSERT_EQUAL(40, index.blockEnd(0));
+	TEST_ASSERT_EQUAL(20, index.freeUntil(20));
+	TEST_ASSERT_EQUAL(40, index.nextFreeSlot(10, 10));
+	TEST_ASSERT_EQUAL(60, index.nextFreeSlot(10, 11));
+	checkQueries(entries, 100);
+}
+
+void test_time_inside_block()
+{
+	std::vector<CalendarEntry> entries = {TestEntry(100, 200), TestEntry(150, 300), TestEntry(400, 500)};
+	TestIndex index;
+	index.build(entries);
+
+	TEST_ASSERT_EQUAL(0, index.blockAt(250));
+	TEST_ASSERT_EQUAL(250, index.freeUntil(250));
+	TEST_ASSERT_EQUAL(300, index.nextFreeSlot(250, 100));
+	TEST_ASSERT_EQUAL(500, index.nextFreeSlot(250, 101));
+
+	// the end of a block is free, its start is not
+	TEST_ASSERT_EQUAL(400, index.freeUntil(300));
+	TEST_ASSERT_EQUAL(400, index.freeUntil(400));
+	checkQueries(entries, 100);
+}
+
+// like in DayOccupancy, only Busy and Tentative entries take up the room
+void test_free_entries_leave_room_free()
+{
+	std::vector<CalendarEntry> entries = {TestEntry(100, 200, BusyState::Free), TestEntry(150, 250, BusyState::Tentative),
+										  TestEntry(300, 400, BusyState::Free)};
+	TestIndex index;
+	index.build(entries);
+
+	TEST_ASSERT_EQUAL(1, index.blockCount());
+	TEST_ASSERT_EQUAL(150, index.freeUntil(100));
+	TEST_ASSERT_EQUAL(250, index.nextFreeSlot(150, 3600));
+	TEST_ASSERT_EQUAL(LONG_MAX, index.freeUntil(300));
+
+	// but they are still events
+	std::vector<const CalendarEntry *> events;
+	index.eventsAt(350, events);
+	TEST_ASSERT_EQUAL(1, events.size());
+	checkQueries(entries, 100);
+}
+
+void test_longer_than_every_gap()
+{
+	std::vector<CalendarEntry> entries = {TestEntry(0, 100), TestEntry(110, 200), TestEntry(230, 300), TestEntry(305, 400)};
+	TestIndex index;
+	index.build(entries);
+
+	TEST_ASSERT_EQUAL(3, index.firstGap(0, 31));
+	TEST_ASSERT_EQUAL(400, index.nextFreeSlot(0, 31));
+	TEST_ASSERT_EQUAL(200, index.nextFreeSlot(0, 30));
+	TEST_ASSERT_EQUAL(400, index.nextFreeSlot(300, 6));
+	checkQueries(entries, 100);
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_queries_match_scan);
+	RUN_TEST(test_no_blocks);
+	RUN_TEST(test_touching_blocks_merge);
+	RUN_TEST(test_time_inside_block);
+	RUN_TEST(test_free_entries_leave_room_free);
+	RUN_TEST(test_longer_than_every_gap);
+	return UNITY_END();
+}
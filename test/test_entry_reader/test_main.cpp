@@ -0,0 +1,301 @@
+#include <unity.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "client/calendar_store.h"
+#include "client/entry_reader.h"
+#include "random_input.h"
+
+using namespace calendar_client;
+
+// a response as it arrives over the connection, nothing more arrives after
+// its end
+class TestStream : public Stream
+{
+protected:
+	std::string data;
+	size_t position;
+
+public:
+	explicit TestStream(const std::string &data) : data(data), position(0) { setTimeout(5); }
+
+	int available() override { return data.size() - position; }
+	int read() override { return position < data.size() ? (uint8_t)data[position++] : -1; }
+	int peek() override { return position < data.size() ? (uint8_t)data[position] : -1; }
+	size_t write(uint8_t) override { return 0; }
+};
+
+static std::string entry(const char *id, time_t start, time_t end, const char *title)
+{
+	char json[160];
+	snprintf(json, sizeof(json), "{\"id\": \"%s\", \"title\": \"%s\", \"start\": %ld, \"end\": %ld, \"busy\": 2}", id, title, (long)start,
+			 (long)end);
+	return json;
+}
+
+// reads all entries, returns false if the reader failed
+static bool readAll(const std::string &response, CalendarEntries &entries, time_t &lastUpdated)
+{
+	TestStream stream(response);
+	EntryReader reader(stream);
+	CalendarEntry next;
+	while (reader.next(next))
+	{
+		entries.push_back(next);
+	}
+	lastUpdated = reader.getLastUpdated();
+	return !reader.failed();
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_last_updated_before_or_after_entries()
+{
+	std::string entries = "[" + entry("a", 100, 200, "A") + ", " + entry("b", 300, 400, "B") + "]";
+
+	for (const std::string &response : {"{\"last_updated\": 1700000000, \"entries\": " + entries + "}",
+										"{\"entries\": " + entries + ", \"last_updated\": 1700000000}",
+										"\n{ \"entries\" :\n" + entries + " ,\n\"last_updated\" : 1700000000 }"})
+	{
+		CalendarEntries read;
+		time_t lastUpdated = 0;
+		TEST_ASSERT_TRUE_MESSAGE(readAll(response, read, lastUpdated), response.c_str());
+		TEST_ASSERT_EQUAL(2, read.size());
+		TEST_ASSERT_EQUAL_STRING("A", read[0].getTitle().c_str());
+		TEST_ASSERT_EQUAL(300, read[1].getStart());
+		TEST_ASSERT_EQUAL(400, read[1].getEnd());
+		TEST_ASSERT_EQUAL(1700000000, lastUpdated);
+	}
+
+	// no entries at all, or an empty list
+	for (const char *response : {"{\"last_updated\": 5}", "{\"entries\": [], \"last_updated\": 5}", "{\"last_updated\": 5, \"entries\": []}"})
+	{
+		CalendarEntries read;
+		time_t lastUpdated = 0;
+		TEST_ASSERT_TRUE_MESSAGE(readAll(response, read, lastUpdated), response);
+		TEST_ASSERT_EQUAL(0, read.size());
+		TEST_ASSERT_EQUAL(5, lastUpdated);
+	}
+}
+
+// the other members of every kind are skipped with skipValue(), before,
+// between and after the two that are read
+void test_unknown_members_are_skipped()
+{
+	std::string response = "{\"version\": 3, \"offset\": -3600, \"scale\": 1.5e3, \"ok\": true, \"error\": null, \"off\": false,"
+						   " \"server\": \"calendar, v2 {beta}\", \"rooms\": [1, [2, {\"entries\": []}], \"]\"],"
+						   " \"last_updated\": 77,"
+						   " \"meta\": {\"entries\": [{\"id\": \"x\"}], \"last_updated\": 88},"
+						   " \"entries\": [" +
+						   entry("a", 100, 200, "A") + "],"
+													   " \"tail\": {\"a\": [true, false, null, -1.25]}, \"end\": 0}";
+
+	CalendarEntries read;
+	time_t lastUpdated = 0;
+	TEST_ASSERT_TRUE(readAll(response, read, lastUpdated));
+	TEST_ASSERT_EQUAL(1, read.size());
+	TEST_ASSERT_EQUAL_STRING("a", read[0].getId().c_str());
+	TEST_ASSERT_EQUAL(77, lastUpdated);
+
+	// unknown members of an entry are left to ArduinoJson
+	response = "{\"entries\": [{\"start\": 10, \"extra\": {\"end\": 99}, \"end\": 20, \"attendees\": [\"x\", \"y\"]}]}";
+	read.clear();
+	TEST_ASSERT_TRUE(readAll(response, read, lastUpdated));
+	TEST_ASSERT_EQUAL(1, read.size());
+	TEST_ASSERT_EQUAL(20, read[0].getEnd());
+}
+
+void test_escapes_in_strings()
+{
+	// an escaped quote does not end a key or a skipped value, and a key that
+	// only contains "entries" is not the entries
+	std::string response = "{\"say \\\"entries\\\"\": \"a \\\"quoted\\\" \\\\ value\", \"x\\\\\": [\"\\\"]\"],"
+						   " \"entries\": [{\"id\": \"e\", \"title\": \"Caf\\u00e9 \\\"Zur Post\\\"\", \"start\": 1, \"end\": 2}],"
+						   " \"last_updated\": 9}";
+
+	CalendarEntries read;
+	time_t lastUpdated = 0;
+	TEST_ASSERT_TRUE(readAll(response, read, lastUpdated));
+	TEST_ASSERT_EQUAL(1, read.size());
+	TEST_ASSERT_EQUAL_STRING("Caf\xc3\xa9 \"Zur Post\"", read[0].getTitle().c_str());
+	TEST_ASSERT_EQUAL(9, lastUpdated);
+}
+
+// a response cut short anywhere fails, however much of it was read
+void test_truncated_stream_fails()
+{
+	std::string response = "{\"last_updated\": 1700000000, \"note\": \"cut \\\"here\\\"\", \"entries\": [" + entry("a", 100, 200, "A") +
+						   ", " + entry("b", 300, 400, "B") + "], \"more\": [1, 2.5, true]}";
+
+	for (size_t length = 0; length < response.size(); length++)
+	{
+		CalendarEntries read;
+		time_t lastUpdated = 0;
+		std::string cut = response.substr(0, length);
+		TEST_ASSERT_FALSE_MESSAGE(readAll(cut, read, lastUpdated), cut.c_str());
+	}
+
+	CalendarEntries read;
+	time_t lastUpdated = 0;
+	TEST_ASSERT_TRUE(readAll(response, read, lastUpdated));
+	TEST_ASSERT_EQUAL(2, read.size());
+
+	// and so does one that is not an object of entries
+	for (const char *response : {"[]", "{\"entries\": {}}", "{\"entries\": [1]}", "{\"last_updated\": \"today\"}", "{\"entries\" [] }"})
+	{
+		read.clear();
+		TEST_ASSERT_FALSE_MESSAGE(readAll(response, read, lastUpdated), response);
+	}
+}
+
+// The entries of several calendars come out sorted by start, on a tie in
+// the order of the calendars, and publish() drops the ones in more than one
+void test_merge_across_sources()
+{
+	std::vector<std::string> responses = {
+		"{\"last_updated\": 10, \"entries\": [" + entry("a", 100, 200, "A") + "," + entry("shared", 300, 400, "Shared") + "," +
+			entry("c", 500, 600, "C") + "]}",
+		"{\"entries\": [" + entry("d", 50, 100, "D") + "," + entry("shared", 300, 400, "Shared") + "," + entry("e", 300, 350, "E") +
+			"], \"last_updated\": 30}",
+		"{\"last_updated\": 20, \"entries\": []}",
+		"{\"last_updated\": 20, \"entries\": [" + entry("f", 700, 800, "F") + "]}",
+	};
+
+	std::vector<TestStream> streams(responses.begin(), responses.end());
+	std::vector<Stream *> pointers;
+	for (TestStream &stream : streams)
+	{
+		pointers.push_back(&stream);
+	}
+
+	CalendarStore store;
+	CalendarSnapshot &next = store.prepare();
+	TEST_ASSERT_TRUE(EntryReader::merge(pointers.data(), pointers.size(), next));
+	TEST_ASSERT_EQUAL(30, next.lastUpdated);
+
+	const char *merged[] = {"d", "a", "shared", "shared", "e", "c", "f"};
+	TEST_ASSERT_EQUAL(sizeof(merged) / sizeof(merged[0]), next.entries.size());
+	for (size_t i = 0; i < next.entries.size(); i++)
+	{
+		TEST_ASSERT_EQUAL_STRING(merged[i], next.entries[i].getId().c_str());
+	}
+
+	store.publish(0);
+	const char *published[] = {"d", "a", "shared", "e", "c", "f"};
+	const CalendarEntries &entries = store.snapshot().entries;
+	TEST_ASSERT_EQUAL(sizeof(published) / sizeof(published[0]), entries.size());
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		TEST_ASSERT_EQUAL_STRING(published[i], entries[i].getId().c_str());
+	}
+	TEST_ASSERT_EQUAL(entries.size(), store.snapshot().index.size());
+}
+
+void test_merge_random_sources()
+{
+	for (int round = 0; round < 50; round++)
+	{
+		// the expected order is start, then calendar, then position
+		std::vector<std::tuple<time_t, size_t, int>> expected;
+		std::vector<std::string> responses;
+		size_t sources = random(1, 5);
+		for (size_t source = 0; source < sources; source++)
+		{
+			std::vector<time_t> starts(random(0, 20));
+			for (time_t &start : starts)
+			{
+				start = random(0, 30) * 60;
+			}
+			std::sort(starts.begin(), starts.end());
+
+			std::string response = "{\"last_updated\": " + std::to_string(source) + ", \"entries\": [";
+			for (size_t i = 0; i < starts.size(); i++)
+			{
+				std::string id = std::to_string(source) + "/" + std::to_string(i);
+				response += (i > 0 ? "," : "") + entry(id.c_str(), starts[i], starts[i] + 60, "T");
+				expected.push_back(std::make_tuple(starts[i], source, (int)i));
+			}
+			responses.push_back(response + "]}");
+		}
+		std::sort(expected.begin(), expected.end());
+
+		std::vector<TestStream> streams(responses.begin(), responses.end());
+		std::vector<Stream *> pointers;
+		for (TestStream &stream : streams)
+		{
+			pointers.push_back(&stream);
+		}
+
+		CalendarStore store;
+		CalendarSnapshot &next = store.prepare();
+		TEST_ASSERT_TRUE(EntryReader::merge(pointers.data(), pointers.size(), next));
+		TEST_ASSERT_EQUAL(sources - 1, next.lastUpdated);
+		TEST_ASSERT_EQUAL(expected.size(), next.entries.size());
+		for (size_t i = 0; i < expected.size(); i++)
+		{
+			std::string id = std::to_string(std::get<1>(expected[i])) + "/" + std::to_string(std::get<2>(expected[i]));
+			TEST_ASSERT_EQUAL_STRING(id.c_str(), next.entries[i].getId().c_str());
+		}
+	}
+}
+
+void test_merge_fails_with_any_source()
+{
+	std::vector<TestStream> streams = {TestStream("{\"entries\": [" + entry("a", 100, 200, "A") + "]}"),
+									   TestStream("{\"entries\": [" + entry("b", 100, 200, "B")),
+									   TestStream("{\"entries\": []}")};
+	std::vector<Stream *> pointers = {&streams[0], &streams[1], &streams[2]};
+
+	CalendarStore store;
+	TEST_ASSERT_FALSE(EntryReader::merge(pointers.data(), pointers.size(), store.prepare()));
+}
+
+// CalendarStore::check(), run by publish(), sorts the entries that came out
+// of order and drops duplicates and entries that end before they start
+void test_publish_sorts_and_drops_duplicates()
+{
+	std::string response = "{\"entries\": [" + entry("late", 900, 1000, "Late") + "," + entry("a", 100, 200, "A") + "," +
+						   // an instance of a, same id but another start
+						   entry("a", 300, 400, "A") + "," + entry("a", 100, 250, "A again") + "," + entry("bad", 500, 400, "Bad") +
+						   "," + entry("b", 300, 400, "B") +
+						   // without ids, the title and the times tell them apart
+						   ", {\"title\": \"No id\", \"start\": 300, \"end\": 400}, {\"title\": \"No id\", \"start\": 300, \"end\": 400}"
+						   ", {\"title\": \"No id\", \"start\": 300, \"end\": 450}, {\"title\": \"Other\", \"start\": 300, \"end\": 400}"
+						   "]}";
+
+	CalendarStore store;
+	CalendarSnapshot &next = store.prepare();
+	time_t lastUpdated;
+	TEST_ASSERT_TRUE(readAll(response, next.entries, lastUpdated));
+	store.publish(0);
+
+	const CalendarEntries &entries = store.snapshot().entries;
+	const char *titles[] = {"A", "A", "B", "No id", "No id", "Other", "Late"};
+	const time_t starts[] = {100, 300, 300, 300, 300, 300, 900};
+	const time_t ends[] = {200, 400, 400, 400, 450, 400, 1000};
+	TEST_ASSERT_EQUAL(sizeof(titles) / sizeof(titles[0]), entries.size());
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		TEST_ASSERT_EQUAL_STRING(titles[i], entries[i].getTitle().c_str());
+		TEST_ASSERT_EQUAL(starts[i], entries[i].getStart());
+		TEST_ASSERT_EQUAL(ends[i], entries[i].getEnd());
+	}
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_last_updated_before_or_after_entries);
+	RUN_TEST(test_unknown_members_are_skipped);
+	RUN_TEST(test_escapes_in_strings);
+	RUN_TEST(test_truncated_stream_fails);
+	RUN_TEST(test_merge_across_sources);
+	RUN_TEST(test_merge_random_sources);
+	RUN_TEST(test_merge_fails_with_any_source);
+	RUN_TEST(test_publish_sorts_and_drops_duplicates);
+	return UNITY_END();
+}
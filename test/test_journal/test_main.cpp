@@ -0,0 +1,248 @@
+#include <unity.h>
+
+#include <map>
+#include <vector>
+
+#include "journal.h"
+
+// the journal file, removed after every test
+static const char *Name = "test_journal";
+static const char *Path = "test_journal.bin";
+
+// values large enough that a sector holds only a few of them
+static const size_t ValueSize = 1000;
+
+class TestJournal : public Journal
+{
+public:
+	// true if the next put of length bytes moves on to the next sector and
+	// compacts the oldest one
+	bool compactsOnNextPut(size_t length) const
+	{
+		return offset + recordSize(length) > (uint32_t)(head + 1) * SectorSize && isUsed((head + 2) % sectors);
+	}
+
+	// true if that compaction also copies records
+	bool copiesOnNextPut(size_t length) const
+	{
+		uint32_t start = (head + 2) % sectors * SectorSize;
+		for (const Location &location : index)
+		{
+			if (location.offset >= start && location.offset < start + SectorSize)
+			{
+				return compactsOnNextPut(length);
+			}
+		}
+		return false;
+	}
+
+	long faultBudgetLeft() const { return faultBudget; }
+};
+
+// the newest version of every key
+typedef std::map<uint32_t, uint32_t> Model;
+
+static std::vector<uint8_t> value(uint32_t key, uint32_t version)
+{
+	std::vector<uint8_t> data(ValueSize);
+	for (size_t i = 0; i < data.size(); i++)
+	{
+		data[i] = key * 31 + version * 7 + i;
+	}
+	return data;
+}
+
+static bool put(Journal &journal, Model &model, uint32_t key, uint32_t version)
+{
+	std::vector<uint8_t> data = value(key, version);
+	if (!journal.put(key, data.data(), data.size()))
+	{
+		return false;
+	}
+	model[key] = version;
+	return true;
+}
+
+static bool holds(const Journal &journal, uint32_t key, uint32_t version)
+{
+	size_t length;
+	const uint8_t *data = journal.get(key, length);
+	std::vector<uint8_t> expected = value(key, version);
+	return data != NULL && length == expected.size() && memcmp(data, expected.data(), length) == 0;
+}
+
+// every key of the model has its value, except for changed, which may also
+// have the version it was being changed to, or be missing if it was new
+static void checkModel(const Journal &journal, const Model &model, uint32_t changed, uint32_t changedTo, const char *what)
+{
+	char message[96];
+	for (const std::pair<const uint32_t, uint32_t> &entry : model)
+	{
+		bool ok = holds(journal, entry.first, entry.second) || (entry.first == changed && holds(journal, changed, changedTo));
+		snprintf(message, sizeof(message), "%s: key %u", what, (unsigned)entry.first);
+		TEST_ASSERT_TRUE_MESSAGE(ok, message);
+	}
+
+	size_t keys = model.size();
+	size_t length;
+	if (model.count(changed) == 0 && journal.get(changed, length) != NULL)
+	{
+		snprintf(message, sizeof(message), "%s: new key %u", what, (unsigned)changed);
+		TEST_ASSERT_TRUE_MESSAGE(holds(journal, changed, changedTo), message);
+		keys++;
+	}
+	snprintf(message, sizeof(message), "%s: number of keys", what);
+	TEST_ASSERT_EQUAL_MESSAGE(keys, journal.count(), message);
+}
+
+static std::vector<uint8_t> readFile()
+{
+	std::vector<uint8_t> data(Journal::HostSize);
+	FILE *f = fopen(Path, "rb");
+	TEST_ASSERT_NOT_NULL(f);
+	TEST_ASSERT_EQUAL(data.size(), fread(data.data(), 1, data.size(), f));
+	fclose(f);
+	return data;
+}
+
+static void writeFile(const std::vector<uint8_t> &data)
+{
+	FILE *f = fopen(Path, "r+b");
+	TEST_ASSERT_NOT_NULL(f);
+	TEST_ASSERT_EQUAL(data.size(), fwrite(data.data(), 1, data.size(), f));
+	fclose(f);
+}
+
+// Puts key in the journal as it is in the file, with a fault after every
+// few bytes, and checks what the next begin() recovers. The step is smaller
+// than the marker, so each record, the marker and the erases are cut short
+// at least once.
+static void putWithFaults(const Model &model, uint32_t key, uint32_t version, const char *what)
+{
+	std::vector<uint8_t> snapshot = readFile();
+
+	// the number of bytes written and erased without a fault
+	long budget = 1 << 30;
+	TestJournal journal;
+	TEST_ASSERT_TRUE(journal.begin(Name));
+	journal.injectFault(budget);
+	Model changed = model;
+	TEST_ASSERT_TRUE(put(journal, changed, key, version));
+	long total = budget - journal.faultBudgetLeft();
+	journal.end();
+
+	for (long bytes = 0; bytes < total; bytes += 7)
+	{
+		writeFile(snapshot);
+		TEST_ASSERT_TRUE(journal.begin(Name));
+		journal.injectFault(bytes);
+		Model faulted = model;
+		TEST_ASSERT_FALSE(put(journal, faulted, key, version));
+
+		TEST_ASSERT_TRUE(journal.begin(Name));
+		char message[64];
+		snprintf(message, sizeof(message), "%s, fault after %ld of %ld bytes", what, bytes, total);
+		checkModel(journal, model, key, version, message);
+
+		// the journal is still usable, also after another begin()
+		uint32_t other = key + 1000;
+		TEST_ASSERT_TRUE(put(journal, faulted, other, 1));
+		TEST_ASSERT_TRUE(journal.begin(Name));
+		TEST_ASSERT_TRUE(holds(journal, other, 1));
+	}
+
+	writeFile(snapshot);
+}
+
+void setUp()
+{
+	remove(Path);
+}
+
+void tearDown()
+{
+	remove(Path);
+}
+
+void test_values_survive_begin()
+{
+	Journal journal;
+	Model model;
+	TEST_ASSERT_TRUE(journal.begin(Name));
+	for (uint32_t key = 1; key <= 10; key++)
+	{
+		TEST_ASSERT_TRUE(put(journal, model, key, 1));
+	}
+	TEST_ASSERT_TRUE(put(journal, model, 3, 2));
+	TEST_ASSERT_TRUE(journal.remove(4));
+	model.erase(4);
+
+	TEST_ASSERT_TRUE(journal.begin(Name));
+	checkModel(journal, model, 0, 0, "after begin");
+	size_t length;
+	TEST_ASSERT_NULL(journal.get(4, length));
+}
+
+// a record cut short keeps the previous value of its key
+void test_torn_write()
+{
+	Journal journal;
+	Model model;
+	TEST_ASSERT_TRUE(journal.begin(Name));
+	for (uint32_t key = 1; key <= 2; key++)
+	{
+		TEST_ASSERT_TRUE(put(journal, model, key, 1));
+	}
+	journal.end();
+
+	putWithFaults(model, 1, 2, "changing a key");
+	putWithFaults(model, 3, 1, "adding a key");
+}
+
+// Writes the journal around the ring, so every new sector compacts the
+// oldest one, with a fault at every byte of one such compaction: in the
+// header of the new sector, the copies, the marker and the erase of the
+// oldest sector. begin() must redo the compaction or finish the erase.
+void test_compaction_replay()
+{
+	TestJournal journal;
+	Model model;
+	TEST_ASSERT_TRUE(journal.begin(Name));
+
+	// keys that are never written again, so compactions copy them
+	for (uint32_t key = 100; key < 104; key++)
+	{
+		TEST_ASSERT_TRUE(put(journal, model, key, 1));
+	}
+
+	uint32_t version = 1;
+	for (int compactions = 0; compactions < 80;)
+	{
+		if (journal.compactsOnNextPut(ValueSize))
+		{
+			compactions++;
+		}
+		version++;
+		TEST_ASSERT_TRUE(put(journal, model, 1 + version % 8, version));
+	}
+	checkModel(journal, model, 0, 0, "around the ring");
+
+	// move on to a compaction that copies the keys that never change
+	while (!journal.copiesOnNextPut(ValueSize))
+	{
+		version++;
+		TEST_ASSERT_TRUE(put(journal, model, 1 + version % 8, version));
+	}
+	journal.end();
+
+	putWithFaults(model, 1, version + 1, "compaction");
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_values_survive_begin);
+	RUN_TEST(test_torn_write);
+	RUN_TEST(test_compaction_replay);
+	return UNITY_END();
+}
@@ -0,0 +1,177 @@
+#include <unity.h>
+
+#include "pixel_path.h"
+
+// flips the first plane pixel by pixel, which is what invertRect() does
+static void togglePixels(PageBuffer &buffer, int16_t x, int16_t y, int16_t w, int16_t h)
+{
+	for (int16_t yy = y; yy < y + h; yy++)
+	{
+		uint8_t *row = buffer.row(0, yy);
+		for (int16_t xx = x; row != NULL && xx < x + w; xx++)
+		{
+			if (xx >= 0 && xx < buffer.width())
+			{
+				row[xx >> 3] ^= 0x80 >> (xx & 7);
+			}
+		}
+	}
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// drawBitmap1bpp() must set the same pixels as drawBitmap() and
+// drawInvertedBitmap() of Adafruit_GFX, clipped to the panel and the band
+void test_blit_matches_pixel_path()
+{
+	PageBuffer fast(800, 480, 64);
+	PageBuffer slow(800, 480, 64);
+	PixelPath reference(slow);
+	uint8_t bitmap[16 * 80];
+
+	for (int i = 0; i < 3000; i++)
+	{
+		if (i % 20 == 0)
+		{
+			int16_t bandY = random(0, 480 - 64);
+			uint16_t background = randomColor();
+			fast.setBand(bandY, 64);
+			slow.setBand(bandY, 64);
+			fast.fillScreen(background);
+			slow.fillScreen(background);
+		}
+
+		int16_t w = random(1, 128), h = random(1, 80);
+		int16_t x = random(-w - 8, 800 + 8), y = fast.getBandY() + random(-h - 8, 64 + 8);
+		for (size_t b = 0; b < sizeof(bitmap); b++)
+		{
+			bitmap[b] = random(0, 255);
+		}
+		uint16_t color = randomColor();
+		bool inverted = random(0, 1);
+
+		fast.drawBitmap1bpp(x, y, bitmap, w, h, color, inverted);
+		if (inverted)
+		{
+			reference.drawInvertedBitmap(x, y, bitmap, w, h, color);
+		}
+		else
+		{
+			reference.drawBitmap(x, y, bitmap, w, h, color);
+		}
+
+		char message[96];
+		snprintf(message, sizeof(message), "blit %d: %dx%d at %d/%d, color %04x, inverted %d", i, w, h, x, y, color, inverted);
+		TEST_ASSERT_TRUE_MESSAGE(sameBand(fast, slow), message);
+	}
+}
+
+// fillRect(), drawFastHLine() and drawFastVLine() must set the same pixels
+// as the generic paths of Adafruit_GFX, and invertRect() must flip the same
+// pixels as togglePixels()
+void test_spans_match_pixel_path()
+{
+	PageBuffer fast(800, 480, 64);
+	PageBuffer slow(800, 480, 64);
+	PixelPath reference(slow);
+
+	for (int i = 0; i < 5000; i++)
+	{
+		if (i % 50 == 0)
+		{
+			int16_t bandY = random(0, 480 - 64);
+			uint16_t background = randomColor();
+			fast.setBand(bandY, 64);
+			slow.setBand(bandY, 64);
+			fast.fillScreen(background);
+			slow.fillScreen(background);
+		}
+
+		int16_t w = random(1, 400), h = random(1, 80);
+		int16_t x = random(-w - 8, 800 + 8), y = fast.getBandY() + random(-h - 8, 64 + 8);
+		uint16_t color = randomColor();
+		int op = random(0, 3);
+
+		switch (op)
+		{
+		case 0:
+			fast.fillRect(x, y, w, h, color);
+			reference.fillRect(x, y, w, h, color);
+			break;
+		case 1:
+			fast.drawFastHLine(x, y, w, color);
+			reference.Adafruit_GFX::drawFastHLine(x, y, w, color);
+			break;
+		case 2:
+			fast.drawFastVLine(x, y, h, color);
+			reference.Adafruit_GFX::drawFastVLine(x, y, h, color);
+			break;
+		case 3:
+			fast.invertRect(x, y, w, h);
+			togglePixels(slow, x, y, w, h);
+			break;
+		}
+
+		char message[96];
+		snprintf(message, sizeof(message), "op %d of %d: %dx%d at %d/%d, color %04x", op, i, w, h, x, y, color);
+		TEST_ASSERT_TRUE_MESSAGE(sameBand(fast, slow), message);
+	}
+}
+
+// a 400x48 highlight, like the one of the current event
+// both paths run an odd number of times, so each leaves the rectangle inverted
+void test_invert_benchmark()
+{
+	PageBuffer expected(800, 480, 480), buffer(800, 480, 480);
+	expected.fillScreen(GxEPD_WHITE);
+	buffer.fillScreen(GxEPD_WHITE);
+
+	double slow = microsPerCall(201, [&]() { togglePixels(expected, 203, 100, 400, 48); });
+	double fast = microsPerCall(20001, [&]() { buffer.invertRect(203, 100, 400, 48); });
+	TEST_ASSERT_TRUE(sameBand(expected, buffer));
+
+	char message[96];
+	snprintf(message, sizeof(message), "400x48: per pixel %.1f us, invertRect %.2f us", slow, fast);
+	TEST_MESSAGE(message);
+}
+
+// a 196x196 icon, byte aligned and not
+void test_blit_benchmark()
+{
+	PageBuffer expected(800, 480, 480), buffer(800, 480, 480);
+	PixelPath reference(expected);
+	static uint8_t icon[25 * 196];
+	for (size_t b = 0; b < sizeof(icon); b++)
+	{
+		icon[b] = random(0, 255);
+	}
+
+	for (int16_t x : {200, 203})
+	{
+		expected.fillScreen(GxEPD_WHITE);
+		buffer.fillScreen(GxEPD_WHITE);
+		double slow = microsPerCall(200, [&]() { reference.drawBitmap(x, 100, icon, 196, 196, GxEPD_BLACK); });
+		double fast = microsPerCall(2000, [&]() { buffer.drawBitmap1bpp(x, 100, icon, 196, 196, GxEPD_BLACK, false); });
+		TEST_ASSERT_TRUE(sameBand(expected, buffer));
+
+		char message[96];
+		snprintf(message, sizeof(message), "196x196 at x=%d: drawBitmap %.1f us, drawBitmap1bpp %.1f us", x, slow, fast);
+		TEST_MESSAGE(message);
+	}
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_blit_matches_pixel_path);
+	RUN_TEST(test_blit_benchmark);
+	RUN_TEST(test_spans_match_pixel_path);
+	RUN_TEST(test_invert_benchmark);
+	return UNITY_END();
+}
@@ -0,0 +1,122 @@
+#include <unity.h>
+
+#include <stdlib.h>
+#include <string>
+
+#include "client/recurrence.h"
+#include "random_input.h"
+
+using namespace calendar_client;
+
+// the instances in [from, limit), walking the series from its first instance
+static std::vector<time_t> walkFromFirst(const Recurrence &rule, time_t first, time_t from, time_t limit)
+{
+	std::vector<time_t> starts;
+	Recurrence::Iterator it(rule, first, first, limit);
+	time_t start;
+	while (it.next(start))
+	{
+		if (start >= from)
+		{
+			starts.push_back(start);
+		}
+	}
+	return starts;
+}
+
+static std::vector<time_t> walk(const Recurrence &rule, time_t first, time_t from, time_t limit)
+{
+	std::vector<time_t> starts;
+	Recurrence::Iterator it(rule, first, from, limit);
+	time_t start;
+	while (it.next(start))
+	{
+		starts.push_back(start);
+	}
+	return starts;
+}
+
+void setUp()
+{
+	// instances keep their local time of day across DST changes
+	setenv("TZ", "CET-1CEST,M3.5.0,M10.5.0/3", 1);
+	tzset();
+}
+
+void tearDown()
+{
+}
+
+// Without COUNT the iterator starts at the period of from instead of the
+// first instance, which must not change which instances it finds.
+void test_skipping_to_from_finds_the_same_instances()
+{
+	static const char *frequencies[] = {"DAILY", "WEEKLY", "MONTHLY", "YEARLY"};
+	static const char *weekdays[] = {"MO", "TU", "WE", "TH", "FR", "SA", "SU"};
+
+	for (int i = 0; i < 2000; i++)
+	{
+		int frequency = random(0, 3);
+		std::string text = std::string("FREQ=") + frequencies[frequency] + ";INTERVAL=" + std::to_string(random(1, 4));
+		if (frequency <= 1 && random(0, 1))
+		{
+			std::string days;
+			for (int d = 0; d < 7; d++)
+			{
+				if (random(0, 2) == 0)
+				{
+					days += days.empty() ? weekdays[d] : std::string(",") + weekdays[d];
+				}
+			}
+			if (!days.empty())
+			{
+				text += ";BYDAY=" + days;
+			}
+		}
+
+		Recurrence rule;
+		TEST_ASSERT_TRUE_MESSAGE(rule.parse(text.c_str()), text.c_str());
+
+		// between 2015 and 2025, looking at up to 6 weeks up to 12 years later
+		time_t first = 1420070400L + random(0, 3650) * 86400L + random(6, 20) * 3600L;
+		time_t from = first + random(-86400, 12 * 366 * 86400L);
+		time_t limit = from + random(1, 42) * 86400L;
+		if (random(0, 3) == 0)
+		{
+			rule.until = from + random(-86400, 30 * 86400L);
+		}
+		std::vector<time_t> instances = walkFromFirst(rule, first, from, limit);
+		if (!instances.empty() && random(0, 3) == 0)
+		{
+			rule.addException(instances[random(0, instances.size() - 1)]);
+		}
+
+		char message[128];
+		snprintf(message, sizeof(message), "%s from %ld after %ld", text.c_str(), (long)(from - first), (long)first);
+		std::vector<time_t> expected = walkFromFirst(rule, first, from, limit);
+		std::vector<time_t> found = walk(rule, first, from, limit);
+		TEST_ASSERT_EQUAL_MESSAGE(expected.size(), found.size(), message);
+		TEST_ASSERT_TRUE_MESSAGE(expected == found, message);
+	}
+}
+
+// with COUNT the instances before from count, but are not returned
+void test_count_includes_instances_before_from()
+{
+	Recurrence rule;
+	TEST_ASSERT_TRUE(rule.parse("FREQ=WEEKLY;BYDAY=MO,WE;COUNT=10"));
+
+	// Monday, 2024-01-08 10:00 CET, the tenth instance is on 2024-02-07
+	time_t first = 1704704400L;
+	std::vector<time_t> found = walk(rule, first, first + 21 * 86400L, first + 365 * 86400L);
+	TEST_ASSERT_EQUAL(4, found.size());
+	TEST_ASSERT_EQUAL(first + 30 * 86400L, found.back());
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_skipping_to_from_finds_the_same_instances);
+	RUN_TEST(test_count_includes_instances_before_from);
+	return UNITY_END();
+}
@@ -0,0 +1,179 @@
+#include <unity.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "rtc_store.h"
+
+// the host stand-in for the RTC memory, removed after every test
+static const char *Path = "rtc_store.bin";
+
+using calendar_client::FrameState;
+using calendar_client::SyncState;
+
+static std::vector<uint8_t> readFile()
+{
+	std::vector<uint8_t> data(RTC_STORE_SIZE);
+	FILE *f = fopen(Path, "rb");
+	TEST_ASSERT_NOT_NULL(f);
+	TEST_ASSERT_EQUAL(data.size(), fread(data.data(), 1, data.size(), f));
+	fclose(f);
+	return data;
+}
+
+static void writeFile(const std::vector<uint8_t> &data)
+{
+	FILE *f = fopen(Path, "wb");
+	TEST_ASSERT_NOT_NULL(f);
+	TEST_ASSERT_EQUAL(data.size(), fwrite(data.data(), 1, data.size(), f));
+	fclose(f);
+}
+
+// a store holding a sync and a frame record, as left by the last wake
+static void saveRecords()
+{
+	RtcStore::begin();
+	SyncState sync = {1700000000, -67};
+	FrameState frame = {0xC0FFEE, 1700003600};
+	RtcStore::save<rtc_record::Sync>(sync);
+	RtcStore::save<rtc_record::Frame>(frame);
+}
+
+static bool holdsRecords()
+{
+	SyncState sync;
+	FrameState frame;
+	return RtcStore::load<rtc_record::Sync>(sync) && sync.time == 1700000000 && sync.rssi == -67 &&
+		   RtcStore::load<rtc_record::Frame>(frame) && frame.hash == 0xC0FFEE && frame.validUntil == 1700003600;
+}
+
+static bool holdsNoRecords()
+{
+	SyncState sync;
+	FrameState frame;
+	calendar_client::DayOccupancy days[OCCUPANCY_DAYS];
+	return !RtcStore::load<rtc_record::Sync>(sync) && !RtcStore::load<rtc_record::Frame>(frame) &&
+		   !RtcStore::load<rtc_record::Occupancy>(days);
+}
+
+void setUp()
+{
+	remove(Path);
+}
+
+void tearDown()
+{
+	remove(Path);
+}
+
+// begin() reads the file back like the RTC memory after a deep sleep
+void test_records_survive_begin()
+{
+	TEST_ASSERT_FALSE(RtcStore::begin());
+	TEST_ASSERT_TRUE(holdsNoRecords());
+
+	saveRecords();
+	TEST_ASSERT_TRUE(RtcStore::begin());
+	TEST_ASSERT_TRUE(holdsRecords());
+
+	calendar_client::DayOccupancy days[OCCUPANCY_DAYS];
+	TEST_ASSERT_FALSE(RtcStore::load<rtc_record::Occupancy>(days));
+}
+
+void test_flipped_byte_fails_crc()
+{
+	saveRecords();
+	std::vector<uint8_t> data = readFile();
+	data[RtcStore::offset(rtc_record::Sync) + sizeof(RtcStore::RecordHeader) + 2] ^= 0x10;
+	writeFile(data);
+
+	TEST_ASSERT_TRUE(RtcStore::begin());
+	SyncState sync;
+	TEST_ASSERT_FALSE(RtcStore::load<rtc_record::Sync>(sync));
+
+	// the other records are not affected
+	FrameState frame;
+	TEST_ASSERT_TRUE(RtcStore::load<rtc_record::Frame>(frame));
+	TEST_ASSERT_EQUAL_UINT32(0xC0FFEE, frame.hash);
+
+	// saving it again repairs it
+	sync = {1700000000, -67};
+	RtcStore::save<rtc_record::Sync>(sync);
+	TEST_ASSERT_TRUE(RtcStore::begin());
+	TEST_ASSERT_TRUE(holdsRecords());
+}
+
+void test_missing_or_short_file_is_cold_boot()
+{
+	saveRecords();
+	std::vector<uint8_t> data = readFile();
+	data.resize(RtcStore::offset(rtc_record::Count));
+	writeFile(data);
+	TEST_ASSERT_FALSE(RtcStore::begin());
+	TEST_ASSERT_TRUE(holdsNoRecords());
+
+	saveRecords();
+	remove(Path);
+	TEST_ASSERT_FALSE(RtcStore::begin());
+	TEST_ASSERT_TRUE(holdsNoRecords());
+
+	// the reset store is kept
+	TEST_ASSERT_TRUE(RtcStore::begin());
+}
+
+void test_new_layout_resets()
+{
+	saveRecords();
+	std::vector<uint8_t> saved = readFile();
+
+	std::vector<uint8_t> data = saved;
+	((RtcStore::Header *)data.data())->version = RtcStore::Version - 1;
+	writeFile(data);
+	TEST_ASSERT_FALSE(RtcStore::begin());
+	TEST_ASSERT_TRUE(holdsNoRecords());
+
+	// a record added or resized without bumping the version
+	data = saved;
+	((RtcStore::Header *)data.data())->size -= 4;
+	writeFile(data);
+	TEST_ASSERT_FALSE(RtcStore::begin());
+	TEST_ASSERT_TRUE(holdsNoRecords());
+
+	data = saved;
+	((RtcStore::Header *)data.data())->magic ^= 1;
+	writeFile(data);
+	TEST_ASSERT_FALSE(RtcStore::begin());
+	TEST_ASSERT_TRUE(holdsNoRecords());
+
+	writeFile(saved);
+	TEST_ASSERT_TRUE(RtcStore::begin());
+	TEST_ASSERT_TRUE(holdsRecords());
+}
+
+void test_erase()
+{
+	saveRecords();
+	RtcStore::erase(rtc_record::Sync);
+
+	SyncState sync;
+	FrameState frame;
+	TEST_ASSERT_FALSE(RtcStore::load<rtc_record::Sync>(sync));
+	TEST_ASSERT_TRUE(RtcStore::load<rtc_record::Frame>(frame));
+
+	TEST_ASSERT_TRUE(RtcStore::begin());
+	TEST_ASSERT_FALSE(RtcStore::load<rtc_record::Sync>(sync));
+	TEST_ASSERT_TRUE(RtcStore::load<rtc_record::Frame>(frame));
+	TEST_ASSERT_EQUAL_UINT32(0xC0FFEE, frame.hash);
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_records_survive_begin);
+	RUN_TEST(test_flipped_byte_fails_crc);
+	RUN_TEST(test_missing_or_short_file_is_cold_boot);
+	RUN_TEST(test_new_layout_resets);
+	RUN_TEST(test_erase);
+	return UNITY_END();
+}
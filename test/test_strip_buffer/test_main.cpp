@@ -0,0 +1,122 @@
+#include <unity.h>
+
+#include "components/strip_buffer.h"
+#include "pixel_path.h"
+
+// true if the strip buffer holds the same frame as the plain buffer
+static bool sameFrame(StripBuffer &strips, PageBuffer &plain)
+{
+	for (uint8_t p = 0; p < DISP_PLANES; p++)
+	{
+		for (int16_t y = 0; y < plain.height();)
+		{
+			int16_t h = plain.height() - y;
+			const uint8_t *data = strips.rows(p, y, h);
+			if (h <= 0 || memcmp(data, plain.row(p, y), h * plain.getStride()) != 0)
+			{
+				return false;
+			}
+			y += h;
+		}
+	}
+	return true;
+}
+
+// draws the same random operation into both buffers
+static void drawRandom(StripBuffer &strips, PageBuffer &plain)
+{
+	static uint8_t bitmap[16 * 80];
+	int16_t w = random(1, 800), h = random(1, 120);
+	int16_t x = random(-w, 800), y = random(-h, 480);
+	uint16_t color = randomColor();
+
+	switch (random(0, 4))
+	{
+	case 0:
+		strips.fillRect(x, y, w, h, color);
+		plain.fillRect(x, y, w, h, color);
+		break;
+	case 1:
+		// full width, which makes covered strips solid
+		strips.fillRect(0, y, 800, h, color);
+		plain.fillRect(0, y, 800, h, color);
+		break;
+	case 2:
+		strips.invertRect(x, y, w, h);
+		plain.invertRect(x, y, w, h);
+		break;
+	case 3:
+		for (int i = 0; i < 50; i++)
+		{
+			int16_t px = random(0, 799), py = random(0, 479);
+			strips.drawPixel(px, py, color);
+			plain.drawPixel(px, py, color);
+		}
+		break;
+	case 4:
+		w = std::min(w, (int16_t)128);
+		h = std::min(h, (int16_t)80);
+		for (size_t b = 0; b < sizeof(bitmap); b++)
+		{
+			bitmap[b] = random(0, 255);
+		}
+		strips.drawBitmap1bpp(x, y, bitmap, w, h, color, false);
+		plain.drawBitmap1bpp(x, y, bitmap, w, h, color, false);
+		break;
+	}
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// The strip buffer must hold the same frame as a plain buffer of the full
+// frame, no matter how often its strips are encoded and decoded again.
+void test_strips_match_full_frame()
+{
+	StripBuffer strips(800, 480, 16, 4);
+	PageBuffer plain(800, 480, 480);
+
+	for (int frame = 0; frame < 20; frame++)
+	{
+		uint16_t background = randomColor();
+		strips.fillScreen(background);
+		plain.fillScreen(background);
+
+		for (int i = 0; i < 100; i++)
+		{
+			drawRandom(strips, plain);
+			if (i % 10 == 9)
+			{
+				char message[64];
+				snprintf(message, sizeof(message), "frame %d, operation %d", frame, i);
+				TEST_ASSERT_TRUE_MESSAGE(sameFrame(strips, plain), message);
+			}
+		}
+
+		char message[96];
+		snprintf(message, sizeof(message), "frame %d: %u bytes encoded, %u uncompressed", frame, (unsigned)strips.getEncodedSize(),
+				 (unsigned)(plain.getStride() * plain.height() * DISP_PLANES));
+		TEST_MESSAGE(message);
+	}
+}
+
+// a cleared frame only keeps the color of each strip
+void test_solid_frame_is_small()
+{
+	StripBuffer strips(800, 480, 16, 4);
+	strips.fillScreen(GxEPD_WHITE);
+	TEST_ASSERT_EQUAL(0, strips.getEncodedSize());
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_strips_match_full_frame);
+	RUN_TEST(test_solid_frame_is_small);
+	return UNITY_END();
+}
@@ -0,0 +1,137 @@
+#include <unity.h>
+
+#include "pixel_path.h"
+
+// A random font shaped like FreeSans12pt7b: the printable ASCII range with
+// glyphs of 8 to 16 x 12 to 17 pixels. The same glyphs also make up a
+// unicode font for the code points 0x20 to 0x7E.
+static const uint16_t First = 0x20, Last = 0x7E, Count = Last - First + 1;
+static GFXglyph glyphs[Count];
+static uint8_t bitmaps[Count * 34];
+static uint16_t codepoints[Count];
+static GFXfont gfxFont = {bitmaps, glyphs, First, Last, 29};
+static UnicodeFont unicodeFont = {bitmaps, glyphs, codepoints, Count, 29};
+
+static const char *Text = "Besprechung 10:00 bis 11:30 Frei 87%";
+
+static void makeFont()
+{
+	uint16_t offset = 0;
+	for (uint16_t i = 0; i < Count; i++)
+	{
+		uint8_t w = random(8, 16), h = random(12, 17);
+		glyphs[i] = {offset, w, h, (uint8_t)(w + 2), 1, (int8_t)-h};
+		codepoints[i] = First + i;
+		for (uint16_t b = 0; b < (w * h + 7) / 8; b++)
+		{
+			bitmaps[offset++] = random(0, 255);
+		}
+	}
+	// the space is empty, like in the real fonts
+	glyphs[0].width = glyphs[0].height = 0;
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// Text drawn from the glyph cache, with the GFX and with the unicode font,
+// must set the same pixels as Adafruit_GFX drawing the glyphs bit by bit,
+// also where it is cut off by the band or the panel.
+void test_text_matches_pixel_path()
+{
+	PageBuffer gfxText(800, 480, 64);
+	PageBuffer unicodeText(800, 480, 64);
+	PageBuffer slow(800, 480, 64);
+	PixelPath reference(slow);
+
+	gfxText.setFont(&gfxFont);
+	unicodeText.setUnicodeFont(&unicodeFont);
+	reference.setFont(&gfxFont);
+	gfxText.setTextWrap(false);
+	unicodeText.setTextWrap(false);
+	reference.setTextWrap(false);
+
+	for (int i = 0; i < 500; i++)
+	{
+		if (i % 10 == 0)
+		{
+			int16_t bandY = random(0, 480 - 64);
+			for (PageBuffer *buffer : {&gfxText, &unicodeText, &slow})
+			{
+				buffer->setBand(bandY, 64);
+				buffer->fillScreen(GxEPD_WHITE);
+			}
+		}
+
+		int16_t x = random(-100, 800), y = gfxText.getBandY() + random(-20, 64 + 20);
+		uint16_t color = randomColor();
+
+		gfxText.setTextColor(color);
+		unicodeText.setTextColor(color);
+		reference.setTextColor(color);
+		gfxText.setCursor(x, y);
+		unicodeText.setCursor(x, y);
+		reference.setCursor(x, y);
+		gfxText.print(Text);
+		unicodeText.print(Text);
+		reference.print(Text);
+
+		char message[64];
+		snprintf(message, sizeof(message), "text %d at %d/%d", i, x, y);
+		TEST_ASSERT_TRUE_MESSAGE(sameBand(gfxText, slow), message);
+		TEST_ASSERT_TRUE_MESSAGE(sameBand(unicodeText, slow), message);
+		TEST_ASSERT_EQUAL(reference.getCursorX(), gfxText.getCursorX());
+		TEST_ASSERT_EQUAL(reference.getCursorX(), unicodeText.getCursorX());
+	}
+}
+
+// every path prints the text at the same 500 positions, the fast ones ten
+// times over, and must end up with the same page
+void test_text_benchmark()
+{
+	PageBuffer expected(800, 480, 480), gfxBuffer(800, 480, 480), unicodeBuffer(800, 480, 480);
+	PixelPath reference(expected);
+	for (Adafruit_GFX *gfx : {(Adafruit_GFX *)&expected, (Adafruit_GFX *)&gfxBuffer, (Adafruit_GFX *)&unicodeBuffer, (Adafruit_GFX *)&reference})
+	{
+		gfx->fillScreen(GxEPD_WHITE);
+		gfx->setTextColor(GxEPD_BLACK);
+		gfx->setTextWrap(false);
+	}
+
+	int i = 0;
+	double glyphsPerCall = strlen(Text);
+	auto draw = [&](Adafruit_GFX &gfx) {
+		gfx.setCursor(i % 300, 20 + i % 400);
+		gfx.print(Text);
+		i = (i + 1) % 500;
+	};
+
+	reference.setFont(&gfxFont);
+	double pixels = glyphsPerCall / microsPerCall(500, [&]() { draw(reference); });
+	gfxBuffer.setFont(&gfxFont);
+	double cached = glyphsPerCall / microsPerCall(5000, [&]() { draw(gfxBuffer); });
+	unicodeBuffer.setUnicodeFont(&unicodeFont);
+	double unicode = glyphsPerCall / microsPerCall(5000, [&]() { draw(unicodeBuffer); });
+	TEST_ASSERT_TRUE(sameBand(expected, gfxBuffer));
+	TEST_ASSERT_TRUE(sameBand(expected, unicodeBuffer));
+
+	char message[128];
+	snprintf(message, sizeof(message), "Mglyph/s: bit by bit %.2f, GFX font %.2f (%.1fx), unicode font %.2f (%.1fx)", pixels, cached,
+			 cached / pixels, unicode, unicode / pixels);
+	TEST_MESSAGE(message);
+}
+
+int main()
+{
+	makeFont();
+
+	UNITY_BEGIN();
+	RUN_TEST(test_text_matches_pixel_path);
+	RUN_TEST(test_text_benchmark);
+	return UNITY_END();
+}